@@ -1,6 +1,8 @@
 #pragma once
 
 #include <deque>
+#include <atomic>
+#include <cstdint>
 #include "Vector3.hpp"
 
 namespace SolarSim {
@@ -10,6 +12,7 @@ namespace SolarSim {
  */
 class Body {
 public:
+    uint32_t id;    // Stable handle; survives reordering of the body store
     std::string name;
     double mass;    // in Solar Masses
     double radius;  // in AU (or scaled for visualization)
@@ -31,10 +34,18 @@ public:
 
     Body(const std::string& name, double mass, double radius, 
          Vector3 pos = Vector3(), Vector3 vel = Vector3())
-        : name(name), mass(mass), radius(radius), 
+        : id(nextId()), name(name), mass(mass), radius(radius), 
           position(pos), velocity(vel), acceleration(0, 0, 0),
           rotationAngle(0), rotationSpeed(0), axialTilt(0), parentName("") {}
 
+    /**
+     * @brief Allocates a process-unique body id.
+     */
+    static uint32_t nextId() {
+        static std::atomic<uint32_t> counter{0};
+        return counter++;
+    }
+
     /**
      * @brief Resets current acceleration to zero. 
      */
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include "Body.hpp"
+#include "MappedFile.hpp"
+
+namespace SolarSim {
+
+/**
+ * @brief Integrator and solver settings stored with a checkpoint.
+ *
+ * Fixed-size and trivially copyable: it is written to the file as-is.
+ */
+struct SimulationConfig {
+    int32_t integrator = 2;         ///< 0=Verlet, 1=RK4, 2=Barnes-Hut, 3=Particle-Mesh
+    int32_t singlePrecision = 0;    ///< Direct-sum runs in float
+    int32_t openingCriterion = 0;   ///< 0=Geometric, 1=Relative
+    int32_t gridSize = 64;          ///< Particle-mesh grid
+    int32_t maxSubsteps = 0;        ///< Sub-step budget per tick (0 = unlimited)
+    int32_t fixedStep = 0;          ///< Always step at `maxStep` (no adaptive step)
+    double theta = 0.5;
+    double forceAccuracy = 0.001;
+    double maxStep = 1.0 / 365.25;  ///< Largest sub-step in years
+};
+
+/**
+ * @brief Everything in a checkpoint besides the bodies.
+ */
+struct CheckpointMeta {
+    double elapsedYears = 0.0;
+    uint64_t tick = 0;
+    SimulationConfig config;
+    std::string rngState;           ///< Serialized `std::mt19937_64`, empty if none
+
+    void captureRng(const std::mt19937_64& rng) {
+        std::ostringstream out;
+        out << rng;
+        rngState = out.str();
+    }
+
+    /** @returns False if no RNG state was stored */
+    bool restoreRng(std::mt19937_64& rng) const {
+        if (rngState.empty()) return false;
+        std::istringstream in(rngState);
+        in >> rng;
+        return !in.fail();
+    }
+};
+
+/**
+ * @brief Versioned binary checkpoint, read back through a memory mapping.
+ *
+ * The CSV state files print 6 significant digits and re-parse every token, so
+ * a save/load round trip neither reproduces the state nor scales to millions
+ * of bodies. A checkpoint stores raw doubles instead:
+ *
+ * | Part | Content |
+ * |------|---------|
+ * | Header | Magic, version, byte-order mark, body count, time, config, column table |
+ * | Columns | One block per field, each starting on a 64-byte boundary |
+ *
+ * Vector columns hold `Vector3` records exactly as the integration workspace
+ * does (32 bytes, zero padding lane), and scalar columns hold plain `double`
+ * arrays, so a mapped column can be used in place by `CheckpointView` with no
+ * parsing or copying. Names are stored as an offset table plus a character
+ * blob. The file stores every field the integrators read, accelerations
+ * included, so a direct-sum run restarted from a checkpoint continues
+ * bit-for-bit. (Tree solvers rebuild their tree on restart and agree to their
+ * own tolerance.)
+ */
+class Checkpoint {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr const char* EXTENSION = ".ssck";
+
+    enum Column : uint32_t {
+        Positions, Velocities, Accelerations, Masses, Radii,
+        RotationAngles, RotationSpeeds, AxialTilts,
+        NameOffsets, Names, ParentOffsets, ParentNames, RngState,
+        COLUMN_COUNT
+    };
+
+    struct ColumnEntry {
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t bodyCount;
+        uint64_t fileBytes;
+        uint64_t tick;
+        double elapsedYears;
+        SimulationConfig config;
+        uint32_t columnCount;
+        uint32_t reserved;
+        ColumnEntry columns[COLUMN_COUNT];
+    };
+
+    static_assert(std::is_trivially_copyable<Header>::value, "Header is written as raw bytes");
+    static_assert(sizeof(Vector3) == 4 * sizeof(double), "Vector columns mirror the padded Vector3 layout");
+
+    static constexpr char MAGIC[8] = { 'S', 'S', 'I', 'M', 'C', 'K', 'P', 'T' };
+
+    /**
+     * @brief Writes `bodies` and `meta` to `filename`.
+     * @return True if the file was written completely
+     */
+    static bool save(const std::vector<Body>& bodies, const CheckpointMeta& meta, const std::string& filename) {
+        const size_t n = bodies.size();
+        std::vector<Vector3> vectors(n);
+        std::vector<double> scalars(n);
+        std::vector<uint64_t> offsets(n + 1);
+        std::string blob;
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.byteOrder = ENDIAN_MARK;
+        header.bodyCount = n;
+        header.tick = meta.tick;
+        header.elapsedYears = meta.elapsedYears;
+        header.config = meta.config;
+        header.columnCount = COLUMN_COUNT;
+
+        // Lay out the columns first so the header can be written up front
+        const size_t nameBytes = totalLength(bodies, &Body::name);
+        const size_t parentBytes = totalLength(bodies, &Body::parentName);
+        const size_t sizes[COLUMN_COUNT] = {
+            n * sizeof(Vector3), n * sizeof(Vector3), n * sizeof(Vector3),
+            n * sizeof(double), n * sizeof(double), n * sizeof(double), n * sizeof(double), n * sizeof(double),
+            (n + 1) * sizeof(uint64_t), nameBytes, (n + 1) * sizeof(uint64_t), parentBytes, meta.rngState.size()
+        };
+        uint64_t cursor = alignUp(sizeof(Header));
+        for (uint32_t c = 0; c < COLUMN_COUNT; ++c) {
+            header.columns[c] = { cursor, sizes[c] };
+            cursor = alignUp(cursor + sizes[c]);
+        }
+        header.fileBytes = cursor;
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for saving: " << filename << std::endl;
+            return false;
+        }
+        uint64_t written = 0;
+        auto emit = [&](const void* data, size_t bytes) {
+            file.write(static_cast<const char*>(data), (std::streamsize)bytes);
+            written += bytes;
+        };
+        auto pad = [&]() {
+            static const char zeros[ALIGNMENT] = {};
+            emit(zeros, alignUp(written) - written);
+        };
+
+        emit(&header, sizeof(header));
+        pad();
+        for (const Vector3 Body::*field : { &Body::position, &Body::velocity, &Body::acceleration }) {
+            for (size_t i = 0; i < n; ++i) vectors[i] = Vector3(bodies[i].*field);
+            emit(vectors.data(), n * sizeof(Vector3));
+            pad();
+        }
+        for (const double Body::*field : { &Body::mass, &Body::radius, &Body::rotationAngle,
+                                           &Body::rotationSpeed, &Body::axialTilt }) {
+            for (size_t i = 0; i < n; ++i) scalars[i] = bodies[i].*field;
+            emit(scalars.data(), n * sizeof(double));
+            pad();
+        }
+        for (const std::string Body::*field : { &Body::name, &Body::parentName }) {
+            blob.clear();
+            for (size_t i = 0; i < n; ++i) {
+                offsets[i] = blob.size();
+                blob += bodies[i].*field;
+            }
+            offsets[n] = blob.size();
+            emit(offsets.data(), (n + 1) * sizeof(uint64_t));
+            pad();
+            emit(blob.data(), blob.size());
+            pad();
+        }
+        emit(meta.rngState.data(), meta.rngState.size());
+        pad();
+
+        file.close();
+        if (!file || written != header.fileBytes) {
+            std::cerr << "Failed to write checkpoint: " << filename << std::endl;
+            return false;
+        }
+        std::cout << "Saved checkpoint (" << n << " bodies) to: " << filename << std::endl;
+        return true;
+    }
+
+    /**
+     * @brief Cheap format sniff: true if `filename` starts with the checkpoint magic.
+     */
+    static bool isCheckpoint(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        char magic[sizeof(MAGIC)] = {};
+        return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    }
+
+    /** @brief True if `filename` carries the checkpoint extension. */
+    static bool hasExtension(const std::string& filename) {
+        const size_t len = std::strlen(EXTENSION);
+        return filename.size() >= len && filename.compare(filename.size() - len, len, EXTENSION) == 0;
+    }
+
+    static size_t alignUp(size_t bytes) { return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+private:
+    static size_t totalLength(const std::vector<Body>& bodies, const std::string Body::*field) {
+        size_t total = 0;
+        for (const auto& b : bodies) total += (b.*field).size();
+        return total;
+    }
+};
+
+/**
+ * @brief Zero-copy view of a checkpoint file.
+ *
+ * `open` maps the file and validates the header and column table; the
+ * accessors then point straight into the mapping. Columns stay valid until the
+ * view is closed or destroyed.
+ */
+class CheckpointView {
+public:
+    /**
+     * @returns False (with a message on stderr) if the file is missing, truncated,
+     *          from another version, or written with a different byte order
+     */
+    bool open(const std::string& filename) {
+        header = nullptr;
+        if (!file.open(filename)) {
+            std::cerr << "Failed to open checkpoint: " << filename << std::endl;
+            return false;
+        }
+        if (file.size() < sizeof(Checkpoint::Header)) return fail(filename, "truncated header");
+        const auto* h = reinterpret_cast<const Checkpoint::Header*>(file.data());
+        if (std::memcmp(h->magic, Checkpoint::MAGIC, sizeof(Checkpoint::MAGIC)) != 0) return fail(filename, "not a checkpoint");
+        if (h->version != Checkpoint::VERSION) return fail(filename, "unsupported version");
+        if (h->byteOrder != Checkpoint::ENDIAN_MARK) return fail(filename, "byte order mismatch");
+        if (h->columnCount != Checkpoint::COLUMN_COUNT || h->fileBytes > file.size()) return fail(filename, "truncated file");
+
+        const uint64_t n = h->bodyCount;
+        const uint64_t expected[Checkpoint::COLUMN_COUNT] = {
+            n * sizeof(Vector3), n * sizeof(Vector3), n * sizeof(Vector3),
+            n * sizeof(double), n * sizeof(double), n * sizeof(double), n * sizeof(double), n * sizeof(double),
+            (n + 1) * sizeof(uint64_t), 0, (n + 1) * sizeof(uint64_t), 0, 0
+        };
+        for (uint32_t c = 0; c < Checkpoint::COLUMN_COUNT; ++c) {
+            const Checkpoint::ColumnEntry& col = h->columns[c];
+            if (col.offset % Checkpoint::ALIGNMENT != 0 || col.offset + col.bytes > h->fileBytes ||
+                (expected[c] != 0 && col.bytes != expected[c])) {
+                return fail(filename, "corrupt column table");
+            }
+        }
+        header = h;
+        if (!stringsValid(Checkpoint::NameOffsets, Checkpoint::Names) ||
+            !stringsValid(Checkpoint::ParentOffsets, Checkpoint::ParentNames)) {
+            header = nullptr;
+            return fail(filename, "corrupt name table");
+        }
+        return true;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    size_t size() const { return (size_t)header->bodyCount; }
+
+    const Vector3* positions() const { return column<Vector3>(Checkpoint::Positions); }
+    const Vector3* velocities() const { return column<Vector3>(Checkpoint::Velocities); }
+    const Vector3* accelerations() const { return column<Vector3>(Checkpoint::Accelerations); }
+    const double* masses() const { return column<double>(Checkpoint::Masses); }
+    const double* radii() const { return column<double>(Checkpoint::Radii); }
+    const double* rotationAngles() const { return column<double>(Checkpoint::RotationAngles); }
+    const double* rotationSpeeds() const { return column<double>(Checkpoint::RotationSpeeds); }
+    const double* axialTilts() const { return column<double>(Checkpoint::AxialTilts); }
+
+    std::string name(size_t i) const { return text(Checkpoint::NameOffsets, Checkpoint::Names, i); }
+    std::string parentName(size_t i) const { return text(Checkpoint::ParentOffsets, Checkpoint::ParentNames, i); }
+
+    CheckpointMeta meta() const {
+        CheckpointMeta m;
+        m.elapsedYears = header->elapsedYears;
+        m.tick = header->tick;
+        m.config = header->config;
+        const Checkpoint::ColumnEntry& rng = header->columns[Checkpoint::RngState];
+        m.rngState.assign(reinterpret_cast<const char*>(file.data() + rng.offset), (size_t)rng.bytes);
+        return m;
+    }
+
+    /**
+     * @brief Materializes the bodies: one sequential pass over the mapped columns.
+     *
+     * Bodies get fresh ids; ids are process-local handles, not saved state.
+     */
+    std::vector<Body> toBodies() const {
+        const size_t n = size();
+        std::vector<Body> bodies;
+        bodies.reserve(n);
+        const Vector3* p = positions();
+        const Vector3* v = velocities();
+        const Vector3* a = accelerations();
+        for (size_t i = 0; i < n; ++i) {
+            Body b(name(i), masses()[i], radii()[i], p[i], v[i]);
+            b.acceleration = a[i];
+            b.rotationAngle = rotationAngles()[i];
+            b.rotationSpeed = rotationSpeeds()[i];
+            b.axialTilt = axialTilts()[i];
+            b.parentName = parentName(i);
+            bodies.push_back(std::move(b));
+        }
+        return bodies;
+    }
+
+private:
+    template <typename T>
+    const T* column(Checkpoint::Column c) const {
+        return reinterpret_cast<const T*>(file.data() + header->columns[c].offset);
+    }
+
+    std::string text(Checkpoint::Column offsetsColumn, Checkpoint::Column blobColumn, size_t i) const {
+        const uint64_t* offsets = column<uint64_t>(offsetsColumn);
+        return std::string(column<char>(blobColumn) + offsets[i], (size_t)(offsets[i + 1] - offsets[i]));
+    }
+
+    bool stringsValid(Checkpoint::Column offsetsColumn, Checkpoint::Column blobColumn) const {
+        const uint64_t* offsets = column<uint64_t>(offsetsColumn);
+        const uint64_t blobBytes = header->columns[blobColumn].bytes;
+        if (offsets[0] != 0 || offsets[size()] != blobBytes) return false;
+        for (size_t i = 0; i < size(); ++i) {
+            if (offsets[i + 1] < offsets[i]) return false;
+        }
+        return true;
+    }
+
+    bool fail(const std::string& filename, const char* reason) {
+        std::cerr << "Invalid checkpoint " << filename << ": " << reason << std::endl;
+        file.close();
+        return false;
+    }
+
+    MappedFile file;
+    const Checkpoint::Header* header = nullptr;
+};
+
+/**
+ * @brief Loads a checkpoint into a body vector.
+ * @return False if the file is missing or invalid (`bodies` and `meta` untouched)
+ */
+inline bool loadCheckpoint(const std::string& filename, std::vector<Body>& bodies, CheckpointMeta& meta) {
+    CheckpointView view;
+    if (!view.open(filename)) return false;
+    bodies = view.toBodies();
+    meta = view.meta();
+    std::cout << "Loaded checkpoint (" << bodies.size() << " bodies, t = " << meta.elapsedYears
+              << " yr) from: " << filename << std::endl;
+    return true;
+}
+
+} // namespace SolarSim
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace SolarSim {
+
+/**
+ * @brief Minimal in-tree FFT (radix-2, power-of-two lengths).
+ *
+ * Just enough for the particle-mesh solver, so the project keeps building with
+ * no numerical dependency. All transforms are unnormalized in both directions:
+ * a forward transform followed by an inverse one scales the data by $n$.
+ */
+class FFT {
+public:
+    using Complex = std::complex<double>;
+
+    static bool isPowerOfTwo(size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+    /**
+     * @brief In-place complex FFT.
+     *
+     * $$X_k = \sum_{j} x_j\, e^{\mp 2\pi i jk/n}$$
+     *
+     * @param data `n` contiguous values
+     * @param n Length, a power of two
+     * @param inverse Use $e^{+2\pi i jk/n}$ (no $1/n$ factor)
+     */
+    static void transform(Complex* data, size_t n, bool inverse) {
+        if (n < 2) return;
+
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) std::swap(data[i], data[j]);
+        }
+
+        const std::vector<Complex>& w = twiddles(n);
+        for (size_t len = 2; len <= n; len <<= 1) {
+            const size_t half = len >> 1;
+            const size_t step = n / len;
+            for (size_t i = 0; i < n; i += len) {
+                for (size_t k = 0; k < half; ++k) {
+                    Complex t = w[k * step];
+                    if (inverse) t = std::conj(t);
+                    t *= data[i + k + half];
+                    data[i + k + half] = data[i + k] - t;
+                    data[i + k] += t;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Real-to-complex FFT via one half-length complex transform.
+     *
+     * The reals are packed as $z_j = x_{2j} + i\,x_{2j+1}$ and transformed at
+     * length $n/2$; the even and odd spectra are then separated using the
+     * Hermitian symmetry of real input. Only the $n/2 + 1$ non-redundant
+     * outputs are written.
+     *
+     * @param in `n` reals
+     * @param out `n/2 + 1` complex outputs
+     * @param n Length, a power of two (at least 2)
+     */
+    static void realToComplex(const double* in, Complex* out, size_t n) {
+        const size_t m = n / 2;
+        std::vector<Complex>& z = lineScratch();
+        z.resize(m);
+        for (size_t j = 0; j < m; ++j) z[j] = Complex(in[2 * j], in[2 * j + 1]);
+        transform(z.data(), m, false);
+
+        const std::vector<Complex>& w = twiddles(n);
+        for (size_t k = 0; k <= m; ++k) {
+            Complex a = z[k % m];
+            Complex b = std::conj(z[(m - k) % m]);
+            Complex even = (a + b) * 0.5;
+            Complex odd = (a - b) * Complex(0.0, -0.5);
+            Complex wk = (k < m) ? w[k] : Complex(-1.0, 0.0);
+            out[k] = even + wk * odd;
+        }
+    }
+
+    /**
+     * @brief Inverse of `realToComplex`, also unnormalized: returns $n$ times the signal.
+     *
+     * @param in `n/2 + 1` complex values of a Hermitian spectrum
+     * @param out `n` reals
+     * @param n Length, a power of two (at least 2)
+     */
+    static void complexToReal(const Complex* in, double* out, size_t n) {
+        const size_t m = n / 2;
+        std::vector<Complex>& z = lineScratch();
+        z.resize(m);
+
+        const std::vector<Complex>& w = twiddles(n);
+        for (size_t k = 0; k < m; ++k) {
+            Complex a = in[k];
+            Complex b = std::conj(in[m - k]);
+            Complex even = a + b;
+            Complex odd = (a - b) * std::conj(w[k]);
+            z[k] = even + Complex(0.0, 1.0) * odd;
+        }
+        transform(z.data(), m, true);
+        for (size_t j = 0; j < m; ++j) {
+            out[2 * j] = z[j].real();
+            out[2 * j + 1] = z[j].imag();
+        }
+    }
+
+private:
+    /**
+     * @brief $e^{-2\pi i k/n}$ for $k < n/2$, cached per thread and per length.
+     */
+    static const std::vector<Complex>& twiddles(size_t n) {
+        static thread_local std::vector<Complex> tables[64];
+        size_t log2n = 0;
+        while ((size_t(1) << log2n) < n) ++log2n;
+        std::vector<Complex>& table = tables[log2n];
+        if (table.size() != n / 2) {
+            table.resize(n / 2);
+            for (size_t k = 0; k < n / 2; ++k) table[k] = std::polar(1.0, -2.0 * M_PI * (double)k / (double)n);
+        }
+        return table;
+    }
+
+    static std::vector<Complex>& lineScratch() {
+        static thread_local std::vector<Complex> z;
+        return z;
+    }
+};
+
+} // namespace SolarSim
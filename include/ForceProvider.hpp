@@ -0,0 +1,810 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include "Vector3.hpp"
+#include "Constants.hpp"
+#include "Octree.hpp"
+#include "ThreadPool.hpp"
+
+#include <immintrin.h>
+
+namespace SolarSim {
+
+/**
+ * @brief Pluggable gravity solver shared by every integrator.
+ *
+ * Integrators only need "accelerations for these positions", so they talk to
+ * this interface instead of owning their own N-body loop. Any integrator
+ * (Verlet, RK4, ...) can then be paired with any solver (direct sum, SIMD,
+ * threaded, Barnes-Hut, ...) without forking the integrator.
+ *
+ * All providers share the same Plummer-style softening: $r^2 \to r^2 + \epsilon$
+ * with $\epsilon$ = `Constants::SOFTENING_EPSILON` unless overridden.
+ *
+ * The state arrays are templated on precision. `ForceProvider` is the double
+ * interface; `BasicForceProvider<float>` serves float simulations, where the
+ * SIMD kernels process twice as many sources per instruction.
+ *
+ * @tparam Real Precision of positions, masses and accelerations
+ */
+template <typename Real>
+class BasicForceProvider {
+public:
+    using RealType = Real;
+    using VectorType = BasicVector3<Real>;
+
+    virtual ~BasicForceProvider() = default;
+
+    /**
+     * @brief Computes gravitational accelerations for a set of point masses.
+     *
+     * $$a_i = \sum_{j \ne i} G m_j \frac{r_j - r_i}{(|r_j - r_i|^2 + \epsilon)^{3/2}}$$
+     *
+     * @param positions Body positions in AU
+     * @param masses Body masses in Solar Masses
+     * @param accelerations Output in AU/Year^2, resized to `positions.size()`
+     */
+    virtual void computeAccelerations(const std::vector<VectorType>& positions,
+                                      const std::vector<Real>& masses,
+                                      std::vector<VectorType>& accelerations) = 0;
+
+    /**
+     * @brief Fused Verlet sweep: kick, drift, then compute new accelerations.
+     *
+     * Applies $v \mathrel{+}= a \cdot kick$ and $x \mathrel{+}= v \cdot dt$ and then
+     * evaluates $a(x)$. Providers that copy positions into their own layout
+     * override this to perform the kick and drift inside that load loop, so the
+     * state arrays are streamed once per step instead of three times.
+     *
+     * @param positions In: $x(t)$. Out: $x(t+dt)$
+     * @param velocities In: $v$ before the kick. Out: kicked velocity
+     * @param masses Body masses in Solar Masses
+     * @param kick Velocity kick duration (years)
+     * @param dt Drift duration (years)
+     * @param accelerations In: acceleration used for the kick. Out: $a(t+dt)$
+     */
+    virtual void kickDriftAndComputeAccelerations(std::vector<VectorType>& positions,
+                                                  std::vector<VectorType>& velocities,
+                                                  const std::vector<Real>& masses,
+                                                  double kick, double dt,
+                                                  std::vector<VectorType>& accelerations) {
+        for (size_t i = 0; i < positions.size(); ++i) {
+            velocities[i] += accelerations[i] * Real(kick);
+            positions[i] += velocities[i] * Real(dt);
+        }
+        computeAccelerations(positions, masses, accelerations);
+    }
+
+    /**
+     * @brief Human-readable solver name for GUI and benchmark output.
+     */
+    virtual const char* getName() const = 0;
+
+    void setSoftening(double epsilonSquared) { softening = epsilonSquared; }
+    double getSoftening() const { return softening; }
+
+protected:
+    double softening = Constants::SOFTENING_EPSILON; ///< Squared softening length (AU^2)
+};
+
+using ForceProvider = BasicForceProvider<double>;
+
+namespace detail {
+
+/**
+ * @brief Sums $m_j \, d_j / (|d_j|^2 + \epsilon)^{3/2}$ over padded SoA sources (AVX2, 4 doubles per iteration).
+ *
+ * A source located exactly at `p` (the body itself) has a zero separation
+ * vector and therefore adds nothing, so no self-interaction branch is needed.
+ */
+inline void accumulateSources(const double* x, const double* y, const double* z, const double* m, size_t n,
+                              const BasicVector3<double>& p, double softening, double out[3]) {
+#if defined(__AVX2__)
+    const __m256d px = _mm256_set1_pd(p.x);
+    const __m256d py = _mm256_set1_pd(p.y);
+    const __m256d pz = _mm256_set1_pd(p.z);
+    const __m256d eps = _mm256_set1_pd(softening);
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+
+    for (size_t j = 0; j < n; j += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&x[j]), px);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&y[j]), py);
+        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&z[j]), pz);
+        __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                   _mm256_add_pd(_mm256_mul_pd(dz, dz), eps));
+        __m256d invD = _mm256_div_pd(one, _mm256_sqrt_pd(d2));
+        __m256d s = _mm256_mul_pd(_mm256_mul_pd(invD, _mm256_mul_pd(invD, invD)), _mm256_loadu_pd(&m[j]));
+        ax = _mm256_add_pd(ax, _mm256_mul_pd(dx, s));
+        ay = _mm256_add_pd(ay, _mm256_mul_pd(dy, s));
+        az = _mm256_add_pd(az, _mm256_mul_pd(dz, s));
+    }
+
+    alignas(32) double bx[4], by[4], bz[4];
+    _mm256_store_pd(bx, ax); _mm256_store_pd(by, ay); _mm256_store_pd(bz, az);
+    out[0] = bx[0] + bx[1] + bx[2] + bx[3];
+    out[1] = by[0] + by[1] + by[2] + by[3];
+    out[2] = bz[0] + bz[1] + bz[2] + bz[3];
+#else
+    double ax = 0.0, ay = 0.0, az = 0.0;
+    for (size_t j = 0; j < n; ++j) {
+        const double dx = x[j] - p.x, dy = y[j] - p.y, dz = z[j] - p.z;
+        const double d2 = dx*dx + dy*dy + dz*dz + softening;
+        const double invD = 1.0 / std::sqrt(d2);
+        const double s = invD * invD * invD * m[j];
+        ax += dx * s; ay += dy * s; az += dz * s;
+    }
+    out[0] = ax; out[1] = ay; out[2] = az;
+#endif
+}
+
+/**
+ * @brief Single-precision variant: 8 sources per AVX2 iteration.
+ */
+inline void accumulateSources(const float* x, const float* y, const float* z, const float* m, size_t n,
+                              const BasicVector3<float>& p, double softening, float out[3]) {
+#if defined(__AVX2__)
+    const __m256 px = _mm256_set1_ps(p.x);
+    const __m256 py = _mm256_set1_ps(p.y);
+    const __m256 pz = _mm256_set1_ps(p.z);
+    const __m256 eps = _mm256_set1_ps((float)softening);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps(), az = _mm256_setzero_ps();
+
+    for (size_t j = 0; j < n; j += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&x[j]), px);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&y[j]), py);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&z[j]), pz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                                  _mm256_add_ps(_mm256_mul_ps(dz, dz), eps));
+        __m256 invD = _mm256_div_ps(one, _mm256_sqrt_ps(d2));
+        __m256 s = _mm256_mul_ps(_mm256_mul_ps(invD, _mm256_mul_ps(invD, invD)), _mm256_loadu_ps(&m[j]));
+        ax = _mm256_add_ps(ax, _mm256_mul_ps(dx, s));
+        ay = _mm256_add_ps(ay, _mm256_mul_ps(dy, s));
+        az = _mm256_add_ps(az, _mm256_mul_ps(dz, s));
+    }
+
+    alignas(32) float bx[8], by[8], bz[8];
+    _mm256_store_ps(bx, ax); _mm256_store_ps(by, ay); _mm256_store_ps(bz, az);
+    out[0] = out[1] = out[2] = 0.0f;
+    for (int k = 0; k < 8; ++k) { out[0] += bx[k]; out[1] += by[k]; out[2] += bz[k]; }
+#else
+    float ax = 0.0f, ay = 0.0f, az = 0.0f;
+    const float eps = (float)softening;
+    for (size_t j = 0; j < n; ++j) {
+        const float dx = x[j] - p.x, dy = y[j] - p.y, dz = z[j] - p.z;
+        const float d2 = dx*dx + dy*dy + dz*dz + eps;
+        const float invD = 1.0f / std::sqrt(d2);
+        const float s = invD * invD * invD * m[j];
+        ax += dx * s; ay += dy * s; az += dz * s;
+    }
+    out[0] = ax; out[1] = ay; out[2] = az;
+#endif
+}
+
+} // namespace detail
+
+/**
+ * @brief Structure-of-arrays copy of the sources a SIMD kernel sweeps over.
+ *
+ * Padded to a whole AVX2 register (4 doubles or 8 floats) with zero-mass
+ * entries so the inner loop never needs a remainder branch; a zero mass
+ * contributes exactly nothing.
+ */
+template <typename Real>
+struct BasicSourceArrays {
+    using VectorType = BasicVector3<Real>;
+    static constexpr size_t Lanes = 32 / sizeof(Real);
+
+    std::vector<Real> x, y, z, m;
+    size_t count = 0; ///< Number of real (unpadded) sources
+
+    void clear() { x.clear(); y.clear(); z.clear(); m.clear(); count = 0; }
+
+    void push(const VectorType& p, Real mass) {
+        x.push_back(p.x); y.push_back(p.y); z.push_back(p.z); m.push_back(mass);
+        ++count;
+    }
+
+    /**
+     * @brief Kicks and drifts every body and loads the drifted sources in one pass.
+     * @param minMass Only bodies heavier than this become sources (all by default)
+     */
+    void loadKickDrift(std::vector<VectorType>& positions, std::vector<VectorType>& velocities,
+                       const std::vector<VectorType>& accelerations, const std::vector<Real>& masses,
+                       double kick, double dt, double minMass = -1.0) {
+        clear();
+        const Real k = Real(kick), h = Real(dt);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            velocities[i] += accelerations[i] * k;
+            positions[i] += velocities[i] * h;
+            if (masses[i] > minMass) push(positions[i], masses[i]);
+        }
+        pad();
+    }
+
+    void pad() {
+        while (x.size() % Lanes != 0) {
+            x.push_back(Real(0)); y.push_back(Real(0)); z.push_back(Real(0)); m.push_back(Real(0));
+        }
+    }
+
+    /**
+     * @brief Acceleration at `p` due to every source (see `detail::accumulateSources`).
+     */
+    VectorType accelerationAt(const VectorType& p, double softening) const {
+        Real sum[3];
+        detail::accumulateSources(x.data(), y.data(), z.data(), m.data(), x.size(), p, softening, sum);
+        return VectorType(sum[0], sum[1], sum[2]) * Real(Constants::G);
+    }
+};
+
+using SourceArrays = BasicSourceArrays<double>;
+
+/**
+ * @brief Scalar O(N^2) direct summation using Newton's third law.
+ *
+ * Each pair is visited once and the force applied to both bodies, halving the
+ * number of square roots compared to a full row-by-row sweep. This is the
+ * reference solver the other providers are validated against.
+ */
+template <typename Real>
+class BasicDirectForce final : public BasicForceProvider<Real> {
+public:
+    using VectorType = BasicVector3<Real>;
+
+    void computeAccelerations(const std::vector<VectorType>& positions,
+                              const std::vector<Real>& masses,
+                              std::vector<VectorType>& accelerations) override {
+        const size_t n = positions.size();
+        const Real eps = Real(this->softening);
+        const Real G = Real(Constants::G);
+        accelerations.assign(n, VectorType(0, 0, 0));
+
+        for (size_t i = 0; i < n; ++i) {
+            // Cache position components locally for better cache performance
+            const Real xi = positions[i].x;
+            const Real yi = positions[i].y;
+            const Real zi = positions[i].z;
+            const Real mi = masses[i];
+
+            // Local accumulator for acceleration
+            Real axi = 0, ayi = 0, azi = 0;
+
+            for (size_t j = i + 1; j < n; ++j) {
+                const Real mj = masses[j];
+
+                const Real dx = positions[j].x - xi;
+                const Real dy = positions[j].y - yi;
+                const Real dz = positions[j].z - zi;
+
+                const Real distSq = dx*dx + dy*dy + dz*dz + eps;
+                const Real invDist = Real(1) / std::sqrt(distSq);
+                const Real invDist3 = invDist * invDist * invDist;
+                const Real f = G * invDist3;
+
+                const Real fx = dx * f;
+                const Real fy = dy * f;
+                const Real fz = dz * f;
+
+                axi += fx * mj;
+                ayi += fy * mj;
+                azi += fz * mj;
+
+                accelerations[j].x -= fx * mi;
+                accelerations[j].y -= fy * mi;
+                accelerations[j].z -= fz * mi;
+            }
+
+            accelerations[i].x += axi;
+            accelerations[i].y += ayi;
+            accelerations[i].z += azi;
+        }
+    }
+
+    const char* getName() const override { return "Direct"; }
+};
+
+using DirectForce = BasicDirectForce<double>;
+
+/**
+ * @brief AVX2 O(N^2) direct summation over a structure-of-arrays copy.
+ *
+ * Gives up the Newton's-third-law symmetry (every row is swept in full) in
+ * exchange for a branch-free SIMD inner loop with no scattered writes
+ * (4 sources per iteration in double, 8 in float).
+ */
+template <typename Real>
+class BasicDirectSimdForce final : public BasicForceProvider<Real> {
+public:
+    using VectorType = BasicVector3<Real>;
+
+    void computeAccelerations(const std::vector<VectorType>& positions,
+                              const std::vector<Real>& masses,
+                              std::vector<VectorType>& accelerations) override {
+        const size_t n = positions.size();
+        sources.clear();
+        for (size_t i = 0; i < n; ++i) sources.push(positions[i], masses[i]);
+        sources.pad();
+
+        accelerations.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            accelerations[i] = sources.accelerationAt(positions[i], this->softening);
+        }
+    }
+
+    void kickDriftAndComputeAccelerations(std::vector<VectorType>& positions,
+                                          std::vector<VectorType>& velocities,
+                                          const std::vector<Real>& masses,
+                                          double kick, double dt,
+                                          std::vector<VectorType>& accelerations) override {
+        sources.loadKickDrift(positions, velocities, accelerations, masses, kick, dt);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            accelerations[i] = sources.accelerationAt(positions[i], this->softening);
+        }
+    }
+
+    const char* getName() const override { return "Direct SIMD"; }
+
+private:
+    BasicSourceArrays<Real> sources;
+};
+
+using DirectSimdForce = BasicDirectSimdForce<double>;
+
+/**
+ * @brief Multithreaded AVX2 direct summation.
+ *
+ * Rows are independent in the full-sweep formulation, so they are split into
+ * contiguous ranges across the shared `ThreadPool` with no synchronization
+ * beyond the final join.
+ */
+template <typename Real>
+class BasicThreadedDirectForce final : public BasicForceProvider<Real> {
+public:
+    using VectorType = BasicVector3<Real>;
+
+    explicit BasicThreadedDirectForce(ThreadPool& pool = ThreadPool::shared()) : pool(pool) {}
+
+    void computeAccelerations(const std::vector<VectorType>& positions,
+                              const std::vector<Real>& masses,
+                              std::vector<VectorType>& accelerations) override {
+        const size_t n = positions.size();
+        sources.clear();
+        for (size_t i = 0; i < n; ++i) sources.push(positions[i], masses[i]);
+        sources.pad();
+
+        accelerations.resize(n);
+        sweepRows(positions, accelerations);
+    }
+
+    void kickDriftAndComputeAccelerations(std::vector<VectorType>& positions,
+                                          std::vector<VectorType>& velocities,
+                                          const std::vector<Real>& masses,
+                                          double kick, double dt,
+                                          std::vector<VectorType>& accelerations) override {
+        sources.loadKickDrift(positions, velocities, accelerations, masses, kick, dt);
+        sweepRows(positions, accelerations);
+    }
+
+    const char* getName() const override { return "Direct (Threaded)"; }
+
+private:
+    void sweepRows(const std::vector<VectorType>& positions, std::vector<VectorType>& accelerations) {
+        pool.parallelFor(positions.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) {
+                accelerations[i] = sources.accelerationAt(positions[i], this->softening);
+            }
+        }, 32);
+    }
+
+    ThreadPool& pool;
+    BasicSourceArrays<Real> sources;
+};
+
+using ThreadedDirectForce = BasicThreadedDirectForce<double>;
+
+/**
+ * @brief Node acceptance rule of `BarnesHutForce`.
+ */
+enum class OpeningCriterion {
+    Geometric, ///< Fixed opening angle: $s < \theta d$
+    Relative   ///< Error bounded relative to the body's previous |a|
+};
+
+/**
+ * @brief Barnes-Hut octree solver, O(N log N).
+ *
+ * For distant clusters of bodies, the force is taken from the cluster's center
+ * of mass rather than from individual bodies. See `OctreePool` for the tree
+ * layout and the opening criterion. The tree is built once per pass and then
+ * walked read-only from the pool's workers, one cost zone each.
+ *
+ * The tree itself stays double: it spans the whole system, and float node
+ * coordinates would lose the moons. `setMixedPrecision` evaluates far terms
+ * in float relative to each group instead.
+ */
+class BarnesHutForce final : public ForceProvider {
+public:
+    /**
+     * @param theta Accuracy parameter ($\theta$); lower is more accurate (typically 0.5)
+     * @param pool Worker pool used to split the tree walks
+     */
+    explicit BarnesHutForce(double theta = 0.5, ThreadPool& pool = ThreadPool::shared())
+        : threads(pool), theta(theta) {}
+
+    void computeAccelerations(const std::vector<Vector3>& positions,
+                              const std::vector<double>& masses,
+                              std::vector<Vector3>& accelerations) override {
+        const size_t n = positions.size();
+        accelerations.resize(n);
+        if (n == 0) return;
+
+        int rootIdx = -1;
+        if (evaluationsSinceBuild < reuseEvaluations) {
+            rootIdx = pool.refit(positions, masses, reuseTolerance);
+        }
+        if (rootIdx < 0) {
+            rootIdx = pool.build(positions, masses);
+            evaluationsSinceBuild = 0;
+        }
+        ++evaluationsSinceBuild;
+
+        updateCostZones(n);
+        // The relative criterion needs every body's |a| from the previous pass
+        const bool relative = criterion == OpeningCriterion::Relative && lastAccel.size() == n;
+        if (listCaching && !relative) {
+            evaluateCachedLists(rootIdx, accelerations);
+            recordAccelerations(accelerations);
+            return;
+        }
+
+        const std::vector<int>& order = pool.getBodyOrder();
+        const double accuracy = forceAccuracy / Constants::G;
+        threads.parallelForRanges(zoneBounds, [&](size_t begin, size_t end, size_t) {
+            for (size_t k = begin; k < end; ++k) {
+                const int i = order[k];
+                Vector3 a(0, 0, 0);
+                if (relative) {
+                    bodyCost[i] = pool.calculateForceRelative(rootIdx, i, accuracy * lastAccel[i], softening, a);
+                } else if (simdTraversal) {
+                    bodyCost[i] = pool.calculateForceSimd(rootIdx, i, theta, softening, a);
+                } else {
+                    bodyCost[i] = pool.calculateForceIterative(rootIdx, i, theta, softening, a);
+                }
+                accelerations[i] = a;
+            }
+        });
+        recordAccelerations(accelerations);
+    }
+
+    const char* getName() const override { return mixedPrecision && listCaching ? "Barnes-Hut (Mixed)" : "Barnes-Hut"; }
+
+    void setTheta(double t) { theta = t; }
+    double getTheta() const { return theta; }
+
+    /**
+     * @brief Selects the opening criterion.
+     *
+     * `Geometric` opens by the fixed angle `theta` for every body. `Relative`
+     * bounds each accepted node's error by `forceAccuracy` times the body's own
+     * |a| from the previous pass (see `OctreePool::calculateForceRelative`), so
+     * quiet bodies dominated by the Sun take far fewer interactions. The
+     * first pass after the body count changes uses the geometric criterion to
+     * seed |a|. The relative walk is scalar and bypasses interaction caching.
+     *
+     * @param accuracy Force accuracy $\alpha$ (relative error per accepted node), e.g. 0.001
+     */
+    void setOpeningCriterion(OpeningCriterion c, double accuracy = 0.001) {
+        criterion = c;
+        forceAccuracy = accuracy;
+    }
+    OpeningCriterion getOpeningCriterion() const { return criterion; }
+    double getForceAccuracy() const { return forceAccuracy; }
+
+    /**
+     * @brief Carries per-body history (costs, |a|, the reused tree) across a reorder of the body store.
+     * @param oldToNew Remap table from `reorderBodiesMorton`
+     */
+    void remapBodies(const std::vector<int>& oldToNew) {
+        auto permute = [&oldToNew](auto& values) {
+            if (values.size() != oldToNew.size()) { values.clear(); return; }
+            auto old = values;
+            for (size_t i = 0; i < old.size(); ++i) values[oldToNew[i]] = old[i];
+        };
+        permute(bodyCost);
+        permute(lastAccel);
+        pool.remapBodies(oldToNew);
+    }
+
+    /**
+     * @brief Forgets everything carried between passes (reused tree, costs, |a|, cached lists).
+     *
+     * The next pass then depends on the positions alone, so a run restarted
+     * from a restored state repeats itself exactly.
+     */
+    void resetHistory() {
+        evaluationsSinceBuild = reuseEvaluations; // Forces a rebuild
+        bodyCost.clear();
+        lastAccel.clear();
+        lists.clear();
+    }
+
+    /**
+     * @brief Evaluates the far field of cached interaction lists in AVX2 float
+     * (see `OctreePool::evaluateInteractionListMixed`).
+     *
+     * Each group packs its list once per pass and its bodies share it, so this
+     * applies with `setInteractionCaching` and is ignored otherwise. Near-field
+     * body-body terms and all accumulation stay in double (4-wide AVX2).
+     */
+    void setMixedPrecision(bool enabled) { mixedPrecision = enabled; }
+    bool isMixedPrecision() const { return mixedPrecision; }
+
+    /**
+     * @brief Tests the children of each opened node four at a time in AVX2
+     * (see `OctreePool::calculateForceSimd`).
+     */
+    void setSimdTraversal(bool enabled) { simdTraversal = enabled; }
+    bool isSimdTraversal() const { return simdTraversal; }
+
+    /**
+     * @brief Node arena usage of the most recent tree build.
+     */
+    const OctreeStats& getTreeStats() const { return pool.getStats(); }
+
+    /**
+     * @brief Reuses the tree structure for up to `evaluations` force evaluations.
+     *
+     * In between rebuilds the tree is refitted (see `OctreePool::refit`); a
+     * rebuild happens early if the bodies of an internal node have moved
+     * relative to one another by more than `tolerance` of that node's cell size
+     * (its spread $\rho$, measured against the node's own center-of-mass drift).
+     * Leaves are not limited: opened leaves are summed body by body. For low
+     * velocity dispersion (the Solar System) the structure barely changes
+     * between steps, so this amortizes construction across many sub-steps at
+     * high time rates. Note RK4 evaluates forces five times per step.
+     *
+     * @param evaluations Evaluations per build; 1 rebuilds every time (default)
+     * @param tolerance Largest spread $\rho$ of an internal node, as a fraction of its cell size
+     */
+    void setTreeReuse(int evaluations, double tolerance = 0.25) {
+        reuseEvaluations = std::max(1, evaluations);
+        reuseTolerance = tolerance;
+    }
+    int getTreeReuse() const { return reuseEvaluations; }
+
+    /**
+     * @brief Interactions each body evaluated in the last pass (indexed by body).
+     */
+    const std::vector<int>& getBodyCosts() const { return bodyCost; }
+
+    /**
+     * @brief Zone boundaries of the last pass, as positions in tree order
+     * (see `OctreePool::getBodyOrder`); zone $k$ is `[bounds[k], bounds[k+1])`.
+     */
+    const std::vector<size_t>& getCostZones() const { return zoneBounds; }
+    const std::vector<int>& getTreeOrder() const { return pool.getBodyOrder(); }
+
+    /**
+     * @brief Caches one interaction list per leaf group and reuses it across steps.
+     *
+     * Each leaf's bodies share one walk (see `OctreePool::buildInteractionList`),
+     * and on later passes only the forces along the cached list are evaluated.
+     * A group re-walks when it leaves its validity sphere, when a cached far
+     * node no longer passes the opening test, or after a rebuild. Node indices
+     * must stay stable for the lists to survive, so this pays off together with
+     * `setTreeReuse`. Takes precedence over the SIMD walk.
+     *
+     * @param enabled Use cached group lists instead of per-body walks
+     * @param radius Validity radius beyond each group's extent, as a fraction of its leaf size
+     */
+    void setInteractionCaching(bool enabled, double radius = 0.25) {
+        listCaching = enabled;
+        listRadius = radius;
+        lists.clear();
+    }
+    bool isInteractionCaching() const { return listCaching; }
+
+    /**
+     * @brief Groups that walked the tree, and groups that reused their list, in the last pass.
+     */
+    size_t getListWalks() const { return listWalks; }
+    size_t getListReuses() const { return listReuses; }
+
+private:
+    void recordAccelerations(const std::vector<Vector3>& accelerations) {
+        lastAccel.resize(accelerations.size());
+        for (size_t i = 0; i < accelerations.size(); ++i) lastAccel[i] = accelerations[i].length();
+    }
+
+    /**
+     * @brief One pass over leaf groups, re-walking only groups whose cached list went stale.
+     *
+     * Groups are dispatched in the cost zones of `updateCostZones`; a group
+     * belongs to the zone containing its first body.
+     */
+    void evaluateCachedLists(int rootIdx, std::vector<Vector3>& accelerations) {
+        const OctreeStats& st = pool.getStats();
+        if (leavesBuild != st.builds) {
+            pool.collectLeaves(leaves);
+            leavesBuild = st.builds;
+        }
+        if (lists.size() < (size_t)pool.getNodeCount()) lists.resize(pool.getNodeCount());
+
+        leafBounds.clear();
+        size_t leaf = 0;
+        for (size_t z = 0; z < zoneBounds.size(); ++z) {
+            while (leaf < leaves.size() && (size_t)pool[leaves[leaf]].bodyBegin < zoneBounds[z]) ++leaf;
+            leafBounds.push_back(z + 1 == zoneBounds.size() ? leaves.size() : leaf);
+        }
+
+        if (mixedPrecision && packed.size() < leafBounds.size()) packed.resize(leafBounds.size());
+
+        const std::vector<int>& order = pool.getBodyOrder();
+        std::atomic<size_t> walks{0};
+        threads.parallelForRanges(leafBounds, [&](size_t begin, size_t end, size_t zone) {
+            size_t localWalks = 0;
+            for (size_t l = begin; l < end; ++l) {
+                const int leafIdx = leaves[l];
+                InteractionList& list = lists[leafIdx];
+                const OctreeNode& node = pool[leafIdx];
+                if (mixedPrecision) {
+                    PackedInteractionList& scratch = packed[zone];
+                    if (!pool.packInteractionList(leafIdx, theta, list, scratch)) {
+                        pool.buildInteractionList(rootIdx, leafIdx, theta, listRadius, list);
+                        pool.packInteractionList(leafIdx, theta, list, scratch, false);
+                        ++localWalks;
+                    }
+                    for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                        Vector3 a(0, 0, 0);
+                        bodyCost[order[k]] = pool.evaluateInteractionListMixed(scratch, k, softening, a);
+                        accelerations[order[k]] = a;
+                    }
+                    continue;
+                }
+                if (!pool.isInteractionListValid(leafIdx, theta, list)) {
+                    pool.buildInteractionList(rootIdx, leafIdx, theta, listRadius, list);
+                    ++localWalks;
+                }
+                for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                    const int i = order[k];
+                    Vector3 a(0, 0, 0);
+                    bodyCost[i] = pool.evaluateInteractionList(list, i, softening, a);
+                    accelerations[i] = a;
+                }
+            }
+            walks += localWalks;
+        });
+        listWalks = walks;
+        listReuses = leaves.size() - listWalks;
+    }
+
+
+    /**
+     * @brief Splits the bodies, in tree order, into zones of equal predicted cost.
+     *
+     * This is the costzones scheme: per-body work varies by orders of magnitude
+     * (bodies near the Sun and planets open far more nodes than Eris), so
+     * equal-count chunks leave most workers idle. The cost of each body is its
+     * interaction count from the previous pass, which barely changes between
+     * steps. Zones are contiguous in tree order, so each worker walks a compact
+     * region and shares the nodes it touches. Without history (first pass, or
+     * the body count changed) every body costs 1.
+     */
+    void updateCostZones(size_t n) {
+        if (bodyCost.size() != n) bodyCost.assign(n, 1);
+        const std::vector<int>& order = pool.getBodyOrder();
+        const size_t parts = std::min(threads.getWorkerCount(), std::max<size_t>(1, n / MIN_ZONE_BODIES));
+
+        double total = 0.0;
+        for (int c : bodyCost) total += c;
+
+        zoneBounds.assign(1, 0);
+        double running = 0.0;
+        for (size_t k = 0; k < n && zoneBounds.size() < parts; ++k) {
+            running += bodyCost[order[k]];
+            if (running >= total * zoneBounds.size() / parts) zoneBounds.push_back(k + 1);
+        }
+        zoneBounds.push_back(n);
+    }
+
+    static constexpr size_t MIN_ZONE_BODIES = 64;
+
+    ThreadPool& threads;
+    std::vector<int> bodyCost;
+    std::vector<size_t> zoneBounds;
+    OctreePool pool;
+    double theta;
+    bool mixedPrecision = false;
+    bool simdTraversal = false;
+    OpeningCriterion criterion = OpeningCriterion::Geometric;
+    double forceAccuracy = 0.001;
+    std::vector<double> lastAccel;       ///< |a| per body from the previous pass
+    bool listCaching = false;
+    double listRadius = 0.25;
+    std::vector<InteractionList> lists;  ///< Indexed by leaf node
+    std::vector<int> leaves;             ///< Leaves in tree order
+    std::vector<size_t> leafBounds;
+    std::vector<PackedInteractionList> packed;  ///< Mixed-precision scratch per zone
+    size_t leavesBuild = 0;
+    size_t listWalks = 0;
+    size_t listReuses = 0;
+    int reuseEvaluations = 1;
+    double reuseTolerance = 0.25;
+    int evaluationsSinceBuild = 0;
+};
+
+/**
+ * @brief Restricted N-body solver: light bodies feel gravity but do not source it.
+ *
+ * Bodies at or below `massThreshold` (asteroids, by default) are treated as test
+ * particles. Cost drops from $O(N^2)$ to $O(N \cdot M)$ for $M$ massive sources,
+ * which is what makes belt-scale runs tractable. The error is the neglected pull
+ * of the test particles, i.e. of order their total mass.
+ */
+template <typename Real>
+class BasicTestParticleForce final : public BasicForceProvider<Real> {
+public:
+    using VectorType = BasicVector3<Real>;
+
+    /**
+     * @param massThreshold Bodies with mass <= this value (Solar Masses) are test particles
+     * @param pool Worker pool used to split the per-body sweep
+     */
+    explicit BasicTestParticleForce(double massThreshold = 1e-10, ThreadPool& pool = ThreadPool::shared())
+        : massThreshold(massThreshold), pool(pool) {}
+
+    void computeAccelerations(const std::vector<VectorType>& positions,
+                              const std::vector<Real>& masses,
+                              std::vector<VectorType>& accelerations) override {
+        const size_t n = positions.size();
+        sources.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (masses[i] > massThreshold) sources.push(positions[i], masses[i]);
+        }
+        sources.pad();
+
+        accelerations.resize(n);
+        sweepRows(positions, accelerations);
+    }
+
+    void kickDriftAndComputeAccelerations(std::vector<VectorType>& positions,
+                                          std::vector<VectorType>& velocities,
+                                          const std::vector<Real>& masses,
+                                          double kick, double dt,
+                                          std::vector<VectorType>& accelerations) override {
+        sources.loadKickDrift(positions, velocities, accelerations, masses, kick, dt, massThreshold);
+        sweepRows(positions, accelerations);
+    }
+
+    const char* getName() const override { return "Test Particles"; }
+
+    void setMassThreshold(double m) { massThreshold = m; }
+
+private:
+    void sweepRows(const std::vector<VectorType>& positions, std::vector<VectorType>& accelerations) {
+        pool.parallelFor(positions.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) {
+                accelerations[i] = sources.accelerationAt(positions[i], this->softening);
+            }
+        }, 256);
+    }
+
+    double massThreshold;
+    ThreadPool& pool;
+    BasicSourceArrays<Real> sources;
+};
+
+using TestParticleForce = BasicTestParticleForce<double>;
+
+/// Single-precision direct solvers for belt-scale runs (8 sources per AVX2 iteration)
+using DirectForceF = BasicDirectForce<float>;
+using DirectSimdForceF = BasicDirectSimdForce<float>;
+using ThreadedDirectForceF = BasicThreadedDirectForce<float>;
+using TestParticleForceF = BasicTestParticleForce<float>;
+
+} // namespace SolarSim
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <algorithm>
+
+namespace SolarSim {
+
+/**
+ * @brief Per-frame cost breakdown fed to the `FrameGovernor`.
+ */
+struct FrameSample {
+    double frameMs = 0.0;         ///< Whole loop iteration, including buffer swap and limiter sleep
+    double renderMs = 0.0;        ///< 3D scene and labels
+    double guiMs = 0.0;           ///< ImGui build and draw
+    double physicsMs = 0.0;       ///< Integration time of the last physics tick
+    double physicsBudgetMs = 0.0; ///< Wall time available per tick (its period)
+};
+
+/**
+ * @brief Holds the 30 FPS floor by trading fidelity for time at runtime.
+ *
+ * Automates the levers listed in IMPORTANT_INSTRUCTIONS.md. Each lever has a
+ * ladder of levels, level 0 being full quality:
+ *
+ * - Render: sphere segments, then trail sampling (every k-th trail point)
+ * - Physics: Barnes-Hut $\theta$, then the sub-step budget per tick
+ *
+ * Costs are smoothed with an exponential moving average. A lever steps down
+ * only after `DEGRADE_FRAMES` consecutive frames over budget, chosen on the
+ * side that costs more (render vs. physics). Physics also steps down on its
+ * own when ticks overrun their period, since the fixed-step clock would
+ * otherwise fall behind. Quality comes back one step at a time, most recent
+ * reduction first, after `RESTORE_FRAMES` frames comfortably under budget.
+ * Behind a frame limiter every frame lasts at least its period, so frames
+ * ending within `LIMITER_SLACK` of it count as comfortable (see `setFrameLimit`).
+ * Every change starts a cooldown, so one spike never moves two levers and a
+ * borderline scene does not oscillate.
+ */
+class FrameGovernor {
+public:
+    enum Lever { SphereDetail = 0, TrailSampling, Theta, Substeps, LEVER_COUNT };
+
+    static constexpr int DEGRADE_FRAMES = 15;
+    static constexpr int RESTORE_FRAMES = 120;
+    static constexpr int COOLDOWN_FRAMES = 30;
+    static constexpr double SMOOTHING = 0.1;     ///< EMA weight of the newest frame
+    static constexpr double RESTORE_BELOW = 0.6; ///< Fraction of the target that counts as comfortable
+    static constexpr double HEADROOM = 1.2;      ///< Target this much faster than the floor
+    static constexpr double LIMITER_SLACK = 1.1; ///< Frames this close to the limiter period were waiting on it
+
+    /**
+     * @param minFps Frame-rate floor to defend
+     */
+    explicit FrameGovernor(double minFps = 30.0) { setMinFps(minFps); }
+
+    void setMinFps(double fps) { targetMs = 1000.0 / (fps * HEADROOM); }
+    double getTargetMs() const { return targetMs; }
+
+    /**
+     * @brief Declares the display's frame limiter, whose sleep `FrameSample::frameMs` includes.
+     * @param fps Limiter rate, or 0 for none
+     */
+    void setFrameLimit(double fps) { limiterMs = fps > 0.0 ? 1000.0 / fps : 0.0; }
+
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    /** @brief Skips a lever that has no effect right now (e.g. theta without Barnes-Hut). */
+    void setLeverAvailable(Lever lever, bool available) { unavailable[lever] = !available; }
+
+    /**
+     * @brief Feeds one frame and possibly moves one lever.
+     * @returns True if a lever changed
+     */
+    bool update(const FrameSample& sample) {
+        frame = smooth(frame, sample.frameMs);
+        render = smooth(render, sample.renderMs + sample.guiMs);
+        physics = smooth(physics, sample.physicsMs);
+        physicsBudget = sample.physicsBudgetMs;
+        ++frames;
+
+        if (!enabled) {
+            overFrames = underFrames = 0;
+            return false;
+        }
+        if (cooldown > 0) {
+            --cooldown;
+            return false;
+        }
+
+        const bool physicsBehind = physicsBudget > 0.0 && physics > physicsBudget;
+        const double limiterBound = LIMITER_SLACK * limiterMs;
+        const bool over = frame > std::max(targetMs, limiterBound) || physicsBehind;
+        const bool comfortable = frame < std::max(RESTORE_BELOW * targetMs, limiterBound) &&
+                                 (physicsBudget <= 0.0 || physics < RESTORE_BELOW * physicsBudget);
+        overFrames = over ? overFrames + 1 : 0;
+        underFrames = comfortable ? underFrames + 1 : 0;
+
+        if (overFrames >= DEGRADE_FRAMES) {
+            // Physics overrunning its own tick is physics' problem; otherwise blame the larger share
+            bool physicsSide = physicsBehind || physics > render;
+            if (degrade(physicsSide) || degrade(!physicsSide)) return changed();
+            overFrames = 0; // Everything is already at its floor
+        } else if (underFrames >= RESTORE_FRAMES && !history.empty()) {
+            Lever lever = history.back();
+            history.pop_back();
+            --levels[lever];
+            note("Restored", lever);
+            return changed();
+        }
+        return false;
+    }
+
+    /** @brief Returns every lever to full quality. */
+    void reset() {
+        for (int& l : levels) l = 0;
+        history.clear();
+        overFrames = underFrames = cooldown = 0;
+        lastDecision = "Full quality";
+    }
+
+    int getLevel(Lever lever) const { return levels[lever]; }
+    static int getLevelCount(Lever lever) { return ladderSize(lever); }
+
+    /** @returns Latitude/longitude segments for planet spheres */
+    int getSphereSegments() const { return SPHERE_SEGMENTS[levels[SphereDetail]]; }
+    /** @returns Draw every k-th trail point */
+    int getTrailStride() const { return TRAIL_STRIDES[levels[TrailSampling]]; }
+    /** @returns Barnes-Hut opening angle */
+    double getTheta() const { return THETAS[levels[Theta]]; }
+    /** @returns Most integration sub-steps per physics tick (0 = unlimited) */
+    int getMaxSubsteps() const { return SUBSTEP_BUDGETS[levels[Substeps]]; }
+
+    /** @returns Smoothed frame, render + GUI and physics-tick times (ms) */
+    double getFrameMs() const { return frame; }
+    double getRenderMs() const { return render; }
+    double getPhysicsMs() const { return physics; }
+
+    /** @returns Human-readable description of the last change */
+    const std::string& getLastDecision() const { return lastDecision; }
+
+    static const char* leverName(Lever lever) {
+        static const char* names[] = { "sphere detail", "trail sampling", "Barnes-Hut theta", "sub-step budget" };
+        return names[lever];
+    }
+
+private:
+    static constexpr int SPHERE_SEGMENTS[] = { 32, 24, 16, 12, 8 };
+    static constexpr int TRAIL_STRIDES[] = { 1, 2, 4, 8 };
+    static constexpr double THETAS[] = { 0.5, 0.7, 0.9, 1.1 };
+    static constexpr int SUBSTEP_BUDGETS[] = { 0, 128, 32, 8 };
+
+    static int ladderSize(Lever lever) {
+        switch (lever) {
+            case SphereDetail: return (int)(sizeof(SPHERE_SEGMENTS) / sizeof(SPHERE_SEGMENTS[0]));
+            case TrailSampling: return (int)(sizeof(TRAIL_STRIDES) / sizeof(TRAIL_STRIDES[0]));
+            case Theta: return (int)(sizeof(THETAS) / sizeof(THETAS[0]));
+            case Substeps: return (int)(sizeof(SUBSTEP_BUDGETS) / sizeof(SUBSTEP_BUDGETS[0]));
+            default: return 0;
+        }
+    }
+
+    double smooth(double average, double value) const {
+        return frames == 0 ? value : average + SMOOTHING * (value - average);
+    }
+
+    /** @brief Steps the first lever on one side that still has room. */
+    bool degrade(bool physicsSide) {
+        const Lever order[2][2] = { { SphereDetail, TrailSampling }, { Theta, Substeps } };
+        for (Lever lever : order[physicsSide]) {
+            if (!unavailable[lever] && levels[lever] + 1 < ladderSize(lever)) {
+                ++levels[lever];
+                history.push_back(lever);
+                note("Reduced", lever);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool changed() {
+        overFrames = underFrames = 0;
+        cooldown = COOLDOWN_FRAMES;
+        return true;
+    }
+
+    void note(const char* verb, Lever lever) {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "%s %s (frame %.1f ms, physics %.1f ms)", verb, leverName(lever), frame, physics);
+        lastDecision = buf;
+    }
+
+    double targetMs = 1000.0 / 36.0;
+    double limiterMs = 0.0;
+    bool enabled = true;
+
+    double frame = 0.0, render = 0.0, physics = 0.0, physicsBudget = 0.0;
+    long frames = 0;
+    int overFrames = 0, underFrames = 0, cooldown = 0;
+
+    int levels[LEVER_COUNT] = {};
+    bool unavailable[LEVER_COUNT] = {};
+    std::vector<Lever> history; ///< Reductions in order, undone last-first
+    std::string lastDecision = "Full quality";
+};
+
+} // namespace SolarSim
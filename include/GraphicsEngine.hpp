@@ -29,7 +29,10 @@ class GraphicsEngine {
 private:
     sf::RenderWindow& window;
     Camera3D camera;
-    SphereRenderer sphereRenderer{32, 32};  // Balanced quality and performance
+    // Sphere meshes by segment count, built on first use; the frame governor picks one at runtime
+    std::map<int, SphereRenderer> sphereLods;
+    int sphereSegments = 32;  // Balanced quality and performance
+    int trailStride = 1;      // Draw every k-th trail point
     
     ShaderProgram planetShader;
     ShaderProgram sunShader;
@@ -244,7 +247,7 @@ public:
         }
         
         // Initialize sphere renderer
-        sphereRenderer.init();
+        activeSphere();
         
         // Load textures
         auto loadTex = [&](const std::string& name, const std::string& file) {
@@ -302,6 +305,11 @@ public:
         rotZPtr = camera.getYawPtr();
     }
     
+    /** @brief Sphere tessellation for bodies (latitude = longitude segments). */
+    void setSphereSegments(int segments) { sphereSegments = segments; }
+    /** @brief Draw only every k-th trail point. */
+    void setTrailStride(int stride) { trailStride = stride < 1 ? 1 : stride; }
+
     float* getAmbientPtr() { return &ambientStrength; }
     float* getSpecularPtr() { return &specularStrength; }
     float* getShininessPtr() { return &shininess; }
@@ -509,9 +517,15 @@ private:
             shader.setBool("debugUV", debugUV);
         }
         
-        sphereRenderer.draw();
+        activeSphere().draw();
     }
     
+    SphereRenderer& activeSphere() {
+        SphereRenderer& sphere = sphereLods.try_emplace(sphereSegments, sphereSegments, sphereSegments).first->second;
+        sphere.init();
+        return sphere;
+    }
+
     void drawTrails(const std::vector<Body>& bodies, const glm::mat4& view, const glm::mat4& projection) {
         trailShader.use();
         trailShader.setMat4("view", view);
@@ -527,9 +541,11 @@ private:
             
             sf::Color sfColor = bodyColors.count(body.name) ? bodyColors.at(body.name) : sf::Color::White;
             
-            // Build trail vertices with fading alpha and visual scaling
+            // Build trail vertices with fading alpha and visual scaling, sampling every
+            // trailStride-th point but always keeping the head
             std::vector<float> vertices;
-            for (size_t i = 0; i < body.trail.size(); ++i) {
+            const size_t stride = (size_t)trailStride;
+            for (size_t i = (body.trail.size() - 1) % stride; i < body.trail.size(); i += stride) {
                 float alpha = 0.4f * (float)i / (float)body.trail.size();
                 glm::vec3 visualPt = getVisualPosition(body.trail[i], body.name);
                 vertices.push_back(visualPt.x);
@@ -550,7 +566,7 @@ private:
             glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
             glEnableVertexAttribArray(1);
             
-            glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)(body.trail.size()));
+            glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)(vertices.size() / 7));
         }
     }
     
@@ -572,7 +588,8 @@ private:
         // Update instance data
         // IMPORTANT: Bind VAO first, THEN the instance VBO, then set up instance attributes.
         // This ensures instance matrix reads from asteroidInstanceVBO, not the sphere VBO.
-        sphereRenderer.bindVAO();
+        SphereRenderer& sphere = activeSphere();
+        sphere.bindVAO();
         
         glBindBuffer(GL_ARRAY_BUFFER, asteroidInstanceVBO);
         glBufferData(GL_ARRAY_BUFFER, asteroidMatrices.size() * sizeof(glm::mat4), asteroidMatrices.data(), GL_DYNAMIC_DRAW);
@@ -585,7 +602,7 @@ private:
             glVertexAttribDivisor(3 + i, 1);
         }
 
-        sphereRenderer.drawInstanced((unsigned int)asteroidMatrices.size());
+        sphere.drawInstanced((unsigned int)asteroidMatrices.size());
 
         for (int i = 0; i < 4; i++) {
             glDisableVertexAttribArray(3 + i);
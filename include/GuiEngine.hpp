@@ -9,6 +9,7 @@
 #include <string>
 #include <cmath>
 #include <map>
+#include <algorithm>
 #include "Body.hpp"
 #include "PhysicsEngine.hpp"
 #include "StateManager.hpp"
@@ -46,7 +47,10 @@ public:
     struct SimulationState {
         bool paused = false;        ///< Is the physics integration halted?
         float timeRate = 1.0f;      ///< Multiplier for delta time (1.0 = Real-time approx)
-        int integrator = 2;         ///< Chosen integration method (0=Verlet, 1=RK4, 2=Barnes-Hut)
+        int integrator = 2;         ///< Chosen integration method (0=Verlet, 1=RK4, 2=Barnes-Hut, 3=Particle-Mesh)
+        bool singlePrecision = false;///< Integrate direct-sum runs in float (belt-scale presets)
+        int openingCriterion = 0;   ///< Barnes-Hut node acceptance (0=Geometric, 1=Relative error)
+        float forceAccuracy = 0.001f;///< Relative force accuracy for the error-controlled criterion
         bool showTrails = true;     ///< Toggle for orbital path visualization
         bool showLabels = true;     ///< Toggle for body name tags
         bool showAsteroids = true;  ///< Toggle for orbital belt rendering
@@ -54,6 +58,12 @@ public:
         bool showOtherOrbits = false;///< Toggle for other bodies (Pluto, Moons, etc)
         float elapsedYears = 0.0f;  ///< Relative simulation time in years
         int fps = 0;                ///< Monitored frames per second
+        bool autoQuality = true;    ///< Let the frame governor trade fidelity for frame time
+        float frameMs = 0.0f;       ///< Smoothed frame time
+        float renderMs = 0.0f;      ///< Smoothed scene + GUI time
+        float physicsMs = 0.0f;     ///< Smoothed physics tick time
+        std::string qualityLevels;  ///< Governor lever settings, for display
+        std::string qualityDecision;///< Last governor change, for display
         bool debugUV = false;       ///< Debug mode: visualize UV coordinates as RGB
         
         // Body selection
@@ -64,6 +74,17 @@ public:
         int presetRequest = -1;         ///< ID of preset to load (-1 if none)
         bool requestSave = false;       ///< Signal to trigger state export
         bool requestLoad = false;       ///< Signal to trigger state import
+        bool requestTimeReset = false;  ///< Signal to zero the simulation clock
+        bool requestRewind = false;     ///< Signal to go back `rewindYears`
+        float rewindYears = 2.0f;       ///< How far a rewind goes back
+        bool rewinding = false;         ///< Simulation is re-integrating toward a rewind target
+        float historyStart = 0.0f;      ///< Earliest time a rewind can reach
+        bool recording = false;         ///< Stream a trajectory file while running
+        std::string lastRecording;      ///< Most recent trajectory file, for replay
+        bool replay = false;            ///< Show the last recording instead of the live simulation
+        float replayYears = 0.0f;       ///< Scrub position within the recording
+        float replayStart = 0.0f;       ///< Recorded time range
+        float replayEnd = 0.0f;
         char saveFilename[256] = "simulation_state.csv"; ///< Target filename for save/load
 
         // Panel Toggle States (WCAG A11y)
@@ -251,12 +272,12 @@ public:
         if (!state.showTimeControls) return;
         
         ImGuiViewport* viewport = ImGui::GetMainViewport();
-        ImVec2 panelSize(300, 160);
+        ImVec2 panelSize(300, 330);
         ImVec2 panelPos(10, viewport->WorkSize.y - panelSize.y - 10);
         
         ImGui::SetNextWindowPos(panelPos, ImGuiCond_Always);
         ImGui::SetNextWindowSize(panelSize, ImGuiCond_FirstUseEver);
-        ImGui::SetNextWindowSizeConstraints(ImVec2(250, 140), ImVec2(400, 250));
+        ImGui::SetNextWindowSizeConstraints(ImVec2(250, 140), ImVec2(400, 390));
         
         ImGui::Begin("Time Controls", &state.showTimeControls, 
             ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize);
@@ -271,11 +292,20 @@ public:
 
         ImGui::SameLine();
         if (ImGui::Button("Reset", ImVec2(80, 30))) {
-            state.elapsedYears = 0.0f;
+            state.requestTimeReset = true;
             addToast("Time reset to 0", ToastType::Info);
         }
         ImGui::SetItemTooltip("Reset elapsed time to zero");
 
+        ImGui::BeginDisabled(state.rewinding || state.replay || state.elapsedYears <= state.historyStart);
+        if (ImGui::Button("Rewind", ImVec2(80, 0))) state.requestRewind = true;
+        ImGui::EndDisabled();
+        ImGui::SetItemTooltip("Go back in time, as far as the kept history reaches (Backspace)");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(-1);
+        ImGui::SliderFloat("##RewindYears", &state.rewindYears, 0.1f, 20.0f, "by %.1f years", ImGuiSliderFlags_Logarithmic);
+        ImGui::SetItemTooltip("Older history is kept more sparsely; far rewinds take longer to re-integrate");
+
         static const float allowedRates[] = { 0.0f, 0.1f, 0.5f, 1.0f, 2.0f, 4.0f, 10.0f, 25.0f, 50.0f, 150.0f };
         static const int numRates = sizeof(allowedRates) / sizeof(allowedRates[0]);
 
@@ -302,7 +332,42 @@ public:
         ImGui::SetItemTooltip("Adjust the speed of time (Discrete: 0x to 150x)");
 
         ImGui::Spacing();
-        ImGui::Text("Elapsed: %.2f years", state.elapsedYears);
+        static const char* integrators[] = { "Verlet", "RK4", "Barnes-Hut", "Particle-Mesh" };
+        ImGui::SetNextItemWidth(-1);
+        ImGui::Combo("##Integrator", &state.integrator, integrators, IM_ARRAYSIZE(integrators));
+        ImGui::SetItemTooltip("Integration method and gravity solver");
+
+        if (state.integrator == 2) {
+            static const char* criteria[] = { "Opening: Geometric (theta)", "Opening: Relative error" };
+            ImGui::SetNextItemWidth(-1);
+            ImGui::Combo("##Criterion", &state.openingCriterion, criteria, IM_ARRAYSIZE(criteria));
+            ImGui::SetItemTooltip("Relative: accept tree nodes whose error is below a fraction of each body's own acceleration");
+            if (state.openingCriterion == 1) {
+                ImGui::SetNextItemWidth(-1);
+                ImGui::SliderFloat("##Accuracy", &state.forceAccuracy, 0.0001f, 0.01f, "Force accuracy: %.4f",
+                                   ImGuiSliderFlags_Logarithmic);
+                ImGui::SetItemTooltip("Allowed error per accepted node, relative to |a| (lower is more accurate)");
+            }
+        }
+
+        ImGui::Spacing();
+        ImGui::Checkbox("Single Precision", &state.singlePrecision);
+        ImGui::SetItemTooltip("Integrate Verlet/RK4 direct-sum runs in float: half the memory, 2x SIMD lanes");
+
+        if (!state.lastRecording.empty() && !state.recording) {
+            ImGui::Spacing();
+            ImGui::Checkbox("Replay Recording", &state.replay);
+            ImGui::SetItemTooltip("Scrub through the last trajectory recording; the simulation waits (P)");
+            if (state.replay) {
+                ImGui::SetNextItemWidth(-1);
+                ImGui::SliderFloat("##Replay", &state.replayYears, state.replayStart, state.replayEnd, "t = %.2f yr");
+                ImGui::SetItemTooltip("Drag to scrub; Play runs the recording forward");
+            }
+        }
+
+        ImGui::Spacing();
+        if (state.rewinding) ImGui::Text("Elapsed: %.2f years (rewinding...)", state.elapsedYears);
+        else ImGui::Text("Elapsed: %.2f years", state.elapsedYears);
         
         ImGui::Spacing();
         ImGui::Text("FPS: %d | Bodies: Active", state.fps);
@@ -338,6 +403,12 @@ public:
         ImGui::Separator();
         ImGui::Checkbox("Debug UV", &state.debugUV);
         ImGui::SetItemTooltip("Show UV coordinates as Red/Green. If stable, UVs are fixed.");
+        ImGui::Separator();
+        ImGui::Checkbox("Auto Quality", &state.autoQuality);
+        ImGui::SetItemTooltip("Lower sphere detail, trail sampling, theta and sub-steps to hold 30 FPS");
+        ImGui::Text("Frame %.1f ms | Draw %.1f | Physics %.1f", state.frameMs, state.renderMs, state.physicsMs);
+        ImGui::TextWrapped("%s", state.qualityLevels.c_str());
+        ImGui::TextDisabled("%s", state.qualityDecision.c_str());
 
         state.lastVisibilityHeight = ImGui::GetWindowHeight();
         ImGui::End();
@@ -367,14 +438,19 @@ public:
         // A11y: Keyboard navigation hints
     ImGui::TextDisabled("Use Up/Down arrows to navigate");
     
+    // Named bodies in creation (id) order; the store itself may be spatially reordered
+    std::vector<int> listed;
+    for (int i = 0; i < (int)bodies.size(); ++i) {
+        if (bodies[i].name != "Asteroid") listed.push_back(i);
+    }
+    std::sort(listed.begin(), listed.end(), [&](int a, int b) { return bodies[a].id < bodies[b].id; });
+    
     ImGui::SetNextItemWidth(-80);
     if (ImGui::BeginCombo("##SelectBody", 
         state.selectedBody >= 0 && state.selectedBody < (int)bodies.size() 
             ? bodies[state.selectedBody].name.c_str() : "(none)")) {
             
-            for (int i = 0; i < (int)bodies.size(); ++i) {
-                if (bodies[i].name == "Asteroid") continue;
-                
+            for (int i : listed) {
                 bool isSelected = (state.selectedBody == i);
                 if (ImGui::Selectable(bodies[i].name.c_str(), isSelected)) {
                     state.selectedBody = i;
@@ -395,21 +471,13 @@ public:
         
         // A11y: Keyboard body navigation
         if (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows) && !ImGui::IsAnyItemActive()) {
-            int maxBody = -1;
-            for (int i = 0; i < (int)bodies.size(); ++i) {
-                if (bodies[i].name != "Asteroid") maxBody = i;
-            }
+            int pos = (int)(std::find(listed.begin(), listed.end(), state.selectedBody) - listed.begin());
             
-            if (ImGui::IsKeyPressed(ImGuiKey_DownArrow)) {
-                do {
-                    state.selectedBody = std::min(state.selectedBody + 1, maxBody);
-                } while (state.selectedBody >= 0 && state.selectedBody < (int)bodies.size() 
-                         && bodies[state.selectedBody].name == "Asteroid");
+            if (!listed.empty() && ImGui::IsKeyPressed(ImGuiKey_DownArrow)) {
+                state.selectedBody = listed[std::min(pos + 1, (int)listed.size() - 1)];
             }
-            if (ImGui::IsKeyPressed(ImGuiKey_UpArrow)) {
-                do {
-                    state.selectedBody = std::max(state.selectedBody - 1, 0);
-                } while (state.selectedBody >= 0 && bodies[state.selectedBody].name == "Asteroid");
+            if (!listed.empty() && ImGui::IsKeyPressed(ImGuiKey_UpArrow)) {
+                state.selectedBody = listed[pos >= (int)listed.size() ? 0 : std::max(pos - 1, 0)];
             }
         }
         
@@ -547,6 +615,9 @@ public:
             ImGui::Text("Space"); ImGui::NextColumn(); ImGui::Text("Toggle Pause"); ImGui::NextColumn();
             ImGui::Text("T");     ImGui::NextColumn(); ImGui::Text("Toggle Trails"); ImGui::NextColumn();
             ImGui::Text("H");     ImGui::NextColumn(); ImGui::Text("Toggle Help"); ImGui::NextColumn();
+            ImGui::Text("R");     ImGui::NextColumn(); ImGui::Text("Start/Stop Trajectory Recording"); ImGui::NextColumn();
+            ImGui::Text("P");     ImGui::NextColumn(); ImGui::Text("Replay Last Recording"); ImGui::NextColumn();
+            ImGui::Text("Backspace"); ImGui::NextColumn(); ImGui::Text("Rewind"); ImGui::NextColumn();
             ImGui::Columns(1);
             
             ImGui::Spacing();
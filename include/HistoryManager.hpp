@@ -0,0 +1,205 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include "Body.hpp"
+
+namespace SolarSim {
+
+/**
+ * @brief One restorable simulation state, stored compactly.
+ *
+ * Only what integration changes is copied per keyframe, as one flat array of
+ * `STATE_VALUES` doubles per body (80 bytes, against a few hundred for a
+ * `Body` with its strings and trail). The static data (ids, names, masses,
+ * radii, spin, tilt) lives in a catalog shared by consecutive keyframes of the
+ * same body set, so it is stored again only after a merge, reorder or load.
+ */
+struct Keyframe {
+    /** @brief Position, velocity, acceleration, rotation angle. */
+    static constexpr size_t STATE_VALUES = 10;
+
+    double elapsedYears = 0.0;
+    uint64_t tick = 0;              ///< Ticks completed when captured
+    double tickYears = 0.0;         ///< Span of the tick that followed; re-integration steps with it
+    std::shared_ptr<const std::vector<Body>> catalog;
+    std::vector<double> state;      ///< `STATE_VALUES` per body, in catalog order
+
+    size_t bodyCount() const { return catalog ? catalog->size() : 0; }
+};
+
+/**
+ * @brief Keyframes of the simulation's past, for rewinding.
+ *
+ * A keyframe is taken every `interval` of simulated time. When the keyframes
+ * outgrow the memory budget, the one whose removal leaves the smallest gap
+ * relative to its age is dropped, repeatedly:
+ *
+ * $$i^* = \arg\min_i \frac{t_{i+1} - t_{i-1}}{t_{now} - t_i}$$
+ *
+ * so the spacing grows in proportion to age: recent history stays dense and
+ * older history is thinned geometrically, and a budget of $m$ keyframes
+ * covers a span that grows exponentially in $m$. The newest and oldest
+ * keyframes are kept as long as possible. Storage of dropped keyframes is
+ * recycled, so a steady run captures without allocating.
+ *
+ * A rewind restores the newest keyframe at or before the target
+ * (`findBefore`, `restore`); the caller re-integrates the rest of the way.
+ */
+class HistoryManager {
+public:
+    static constexpr double DEFAULT_INTERVAL_YEARS = 10.0 / 365.25;
+    static constexpr size_t DEFAULT_BUDGET_BYTES = size_t(64) << 20;
+
+    explicit HistoryManager(double intervalYears = DEFAULT_INTERVAL_YEARS, size_t budgetBytes = DEFAULT_BUDGET_BYTES)
+        : interval(intervalYears), budget(budgetBytes) {}
+
+    void setInterval(double years) { interval = years; }
+    double getInterval() const { return interval; }
+
+    /** @brief Caps the keyframe memory, thinning at once if it is over. */
+    void setBudget(size_t bytes) {
+        budget = bytes;
+        if (!keyframes.empty()) thin(keyframes.back().elapsedYears);
+    }
+    size_t getBudget() const { return budget; }
+
+    /** @returns True if a keyframe is due at `time`: none yet, or `interval` since the newest */
+    bool isDue(double time) const { return keyframes.empty() || time >= keyframes.back().elapsedYears + interval; }
+
+    /**
+     * @brief Stores the state of `bodies` at `time`, then thins to the budget.
+     * @param tick Ticks completed at `time`
+     * @param tickYears Span of the tick starting at `time`
+     */
+    void capture(const std::vector<Body>& bodies, double time, uint64_t tick, double tickYears) {
+        Keyframe k;
+        if (!spare.empty()) {
+            k = std::move(spare.back());
+            spare.pop_back();
+        }
+        k.elapsedYears = time;
+        k.tick = tick;
+        k.tickYears = tickYears;
+        k.catalog = !keyframes.empty() && sameBodies(*keyframes.back().catalog, bodies) ? keyframes.back().catalog
+                                                                                        : makeCatalog(bodies);
+        k.state.resize(bodies.size() * Keyframe::STATE_VALUES);
+        double* s = k.state.data();
+        for (const Body& b : bodies) {
+            *s++ = b.position.x; *s++ = b.position.y; *s++ = b.position.z;
+            *s++ = b.velocity.x; *s++ = b.velocity.y; *s++ = b.velocity.z;
+            *s++ = b.acceleration.x; *s++ = b.acceleration.y; *s++ = b.acceleration.z;
+            *s++ = b.rotationAngle;
+        }
+        keyframes.push_back(std::move(k));
+        thin(time);
+    }
+
+    /** @returns The newest keyframe at or before `time`, or null if history starts later */
+    const Keyframe* findBefore(double time) const {
+        auto it = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+                                   [](double t, const Keyframe& k) { return t < k.elapsedYears; });
+        return it == keyframes.begin() ? nullptr : &*(it - 1);
+    }
+
+    /** @brief Rebuilds the bodies of `k`, ids included. */
+    static void restore(const Keyframe& k, std::vector<Body>& bodies) {
+        bodies = *k.catalog;
+        const double* s = k.state.data();
+        for (Body& b : bodies) {
+            b.position = Vector3(s[0], s[1], s[2]);
+            b.velocity = Vector3(s[3], s[4], s[5]);
+            b.acceleration = Vector3(s[6], s[7], s[8]);
+            b.rotationAngle = s[9];
+            s += Keyframe::STATE_VALUES;
+        }
+    }
+
+    /** @brief Drops keyframes later than `time` (a rewound run re-captures its own). */
+    void discardAfter(double time) {
+        while (!keyframes.empty() && keyframes.back().elapsedYears > time) recycle(keyframes.size() - 1);
+    }
+
+    void clear() {
+        while (!keyframes.empty()) recycle(keyframes.size() - 1);
+    }
+
+    size_t size() const { return keyframes.size(); }
+    bool empty() const { return keyframes.empty(); }
+    const Keyframe& operator[](size_t i) const { return keyframes[i]; }
+    double getOldestTime() const { return keyframes.empty() ? 0.0 : keyframes.front().elapsedYears; }
+    double getNewestTime() const { return keyframes.empty() ? 0.0 : keyframes.back().elapsedYears; }
+
+    /** @returns Bytes held by the keyframes, shared catalogs counted once */
+    size_t getMemoryBytes() const {
+        size_t bytes = 0;
+        const std::vector<Body>* last = nullptr;
+        for (const Keyframe& k : keyframes) {
+            bytes += sizeof(Keyframe) + k.state.capacity() * sizeof(double);
+            if (k.catalog.get() != last) bytes += catalogBytes(*k.catalog);
+            last = k.catalog.get();
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr size_t MAX_SPARE = 2;
+
+    static bool sameBodies(const std::vector<Body>& catalog, const std::vector<Body>& bodies) {
+        if (catalog.size() != bodies.size()) return false;
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            if (catalog[i].id != bodies[i].id) return false;
+        }
+        return true;
+    }
+
+    static std::shared_ptr<const std::vector<Body>> makeCatalog(const std::vector<Body>& bodies) {
+        auto catalog = std::make_shared<std::vector<Body>>(bodies);
+        for (Body& b : *catalog) b.trail.clear();
+        return catalog;
+    }
+
+    static size_t catalogBytes(const std::vector<Body>& catalog) {
+        size_t bytes = catalog.capacity() * sizeof(Body);
+        for (const Body& b : catalog) bytes += b.name.capacity() + b.parentName.capacity();
+        return bytes;
+    }
+
+    /** @brief Removes keyframe `i`, keeping its state storage for the next capture. */
+    void recycle(size_t i) {
+        Keyframe k = std::move(keyframes[i]);
+        keyframes.erase(keyframes.begin() + (std::ptrdiff_t)i);
+        k.catalog.reset();
+        if (spare.size() < MAX_SPARE) spare.push_back(std::move(k));
+    }
+
+    void thin(double now) {
+        while (keyframes.size() > 1 && getMemoryBytes() > budget) {
+            if (keyframes.size() < 3) {
+                recycle(0); // Not even two fit: keep the newest
+                continue;
+            }
+            size_t victim = 1;
+            double best = 0.0;
+            for (size_t i = 1; i + 1 < keyframes.size(); ++i) {
+                const double age = std::max(now - keyframes[i].elapsedYears, interval);
+                const double score = (keyframes[i + 1].elapsedYears - keyframes[i - 1].elapsedYears) / age;
+                if (i == 1 || score < best) {
+                    best = score;
+                    victim = i;
+                }
+            }
+            recycle(victim);
+        }
+    }
+
+    double interval;
+    size_t budget;
+    std::deque<Keyframe> keyframes; ///< Oldest first
+    std::vector<Keyframe> spare;
+};
+
+} // namespace SolarSim
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Body.hpp"
+#include "PhysicsEngine.hpp"
+#include "ForceProvider.hpp"
+
+namespace SolarSim {
+
+/**
+ * @brief Compact per-call copy of the integrated state.
+ *
+ * `Body` carries names, trails and render data, so sweeping `std::vector<Body>`
+ * drags several cache lines per body through every pass. Integrators that own
+ * their sub-step loop load the kinematic state into these arrays once per
+ * `advance` call and store it back at the end.
+ *
+ * The workspace is the body store the kernels actually sweep, so it takes the
+ * precision of the force model: a float workspace is half the size and feeds
+ * the 8-wide float kernels. `Body` itself always stays double.
+ *
+ * @tparam Real Precision of the integrated state
+ */
+template <typename Real>
+struct BasicIntegrationWorkspace {
+    using VectorType = BasicVector3<Real>;
+
+    std::vector<VectorType> positions;
+    std::vector<VectorType> velocities;
+    std::vector<VectorType> accelerations;
+    std::vector<Real> masses;
+    std::vector<Real> radii;
+    std::vector<int> sweepOrder; ///< Persistent collision sweep order
+
+    void load(const std::vector<Body>& bodies) {
+        const size_t n = bodies.size();
+        positions.resize(n); velocities.resize(n); accelerations.resize(n);
+        masses.resize(n); radii.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            positions[i] = VectorType(bodies[i].position);
+            velocities[i] = VectorType(bodies[i].velocity);
+            accelerations[i] = VectorType(bodies[i].acceleration);
+            masses[i] = Real(bodies[i].mass);
+            radii[i] = Real(bodies[i].radius);
+        }
+    }
+
+    void store(std::vector<Body>& bodies) const {
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            bodies[i].position = Vector3(positions[i]);
+            bodies[i].velocity = Vector3(velocities[i]);
+            bodies[i].acceleration = Vector3(accelerations[i]);
+        }
+    }
+
+    /**
+     * @brief Carries the cached sweep order across a reorder of the body store.
+     * @param oldToNew Remap table from `reorderBodiesMorton`
+     */
+    void remap(const std::vector<int>& oldToNew) {
+        if (sweepOrder.size() != oldToNew.size()) { sweepOrder.clear(); return; }
+        for (int& i : sweepOrder) i = oldToNew[i];
+    }
+
+    static BasicIntegrationWorkspace& local() {
+        static thread_local BasicIntegrationWorkspace ws;
+        return ws;
+    }
+};
+
+using IntegrationWorkspace = BasicIntegrationWorkspace<double>;
+
+/**
+ * @brief Remaps this thread's integration caches after the body store was permuted.
+ */
+inline void remapIntegrationCaches(const std::vector<int>& oldToNew) {
+    BasicIntegrationWorkspace<double>::local().remap(oldToNew);
+    BasicIntegrationWorkspace<float>::local().remap(oldToNew);
+}
+
+/**
+ * @brief Velocity Verlet integrator policy for `advance`.
+ *
+ * Integrator policies expose `run(bodies, force, dt, steps)`, which performs
+ * all sub-steps of one `advance` call. Owning the whole sub-step loop (rather
+ * than a single step) is what lets an integrator fuse work across step
+ * boundaries.
+ *
+ * @details
+ * Runs the fused kick-drift-kick pipeline. Consecutive Verlet steps end and
+ * begin with a half-kick using the same acceleration, so for $n$ steps:
+ *
+ * $$K_{dt/2}\,D\,F\,K_{dt/2}\;K_{dt/2}\,D\,F\,K_{dt/2} \;\to\; K_{dt/2}\,D\,F\;K_{dt}\,D\,F\;K_{dt/2}$$
+ *
+ * Each interior step is then a single sweep (`kickDriftAndComputeAccelerations`)
+ * over the compact workspace instead of five passes over `Body`. Rotation is not
+ * integrated here; `advance` updates it once per call. The workspace runs in
+ * the force model's precision.
+ */
+struct VerletIntegrator {
+    static constexpr const char* name = "Verlet";
+
+    template <typename ForceModel>
+    static void run(std::vector<Body>& bodies, ForceModel& force, double dt, int steps) {
+        using Real = typename ForceModel::RealType;
+        BasicIntegrationWorkspace<Real>& ws = BasicIntegrationWorkspace<Real>::local();
+        ws.load(bodies);
+
+        for (int s = 0; s < steps; ++s) {
+            const double kick = (s == 0) ? dt * 0.5 : dt;
+            force.kickDriftAndComputeAccelerations(ws.positions, ws.velocities, ws.masses, kick, dt, ws.accelerations);
+
+            // Merges are rare: fall back to the Body-level handler, then redo the forces
+            if (PhysicsEngine::detectCollisions(ws.positions, ws.radii, ws.sweepOrder)) {
+                ws.store(bodies);
+                PhysicsEngine::handleCollisions(bodies);
+                ws.load(bodies);
+                ws.sweepOrder.clear();
+                force.computeAccelerations(ws.positions, ws.masses, ws.accelerations);
+            }
+        }
+
+        const Real halfDt = Real(dt * 0.5);
+        for (size_t i = 0; i < ws.velocities.size(); ++i) ws.velocities[i] += ws.accelerations[i] * halfDt;
+        ws.store(bodies);
+    }
+};
+
+/**
+ * @brief 4th-order Runge-Kutta integrator policy for `advance`.
+ */
+struct RK4Integrator {
+    static constexpr const char* name = "RK4";
+
+    template <typename ForceModel>
+    static void run(std::vector<Body>& bodies, ForceModel& force, double dt, int steps) {
+        for (int s = 0; s < steps; ++s) PhysicsEngine::stepRK4(bodies, dt, force);
+    }
+};
+
+/**
+ * @brief Advances the system by a span of simulated time in equal sub-steps.
+ *
+ * The integrator and the force model are template parameters, so the choice is
+ * made once at the call site and every sub-step runs without dispatch. Pair
+ * them freely, e.g. `advance<RK4Integrator>(bodies, barnesHut, T, dt)`. The
+ * force model also fixes the precision: `advance<VerletIntegrator>(bodies,
+ * directSimdF, T, dt)` integrates a float copy of the state.
+ *
+ * The span is split into $n = \lceil T / dt_{max} \rceil$ equal sub-steps, so no
+ * step is longer than `maxDt` and no short remainder step is taken. Body
+ * rotation is advanced once by the whole span after the sub-steps.
+ *
+ * @tparam Integrator Integrator policy (`VerletIntegrator`, `RK4Integrator`)
+ * @tparam ForceModel Gravity solver; a concrete provider type avoids virtual calls
+ * @param bodies Collection of celestial bodies
+ * @param force Gravity solver instance
+ * @param T Simulated time to advance, in years
+ * @param maxDt Largest allowed sub-step, in years
+ * @returns Number of sub-steps taken
+ */
+template <typename Integrator, typename ForceModel>
+int advance(std::vector<Body>& bodies, ForceModel& force, double T, double maxDt) {
+    if (T <= 0.0 || maxDt <= 0.0) return 0;
+    // Small tolerance so T = k * maxDt does not round up to k + 1 steps
+    int steps = std::max(1, (int)std::ceil(T / maxDt - 1e-9));
+    Integrator::run(bodies, force, T / steps, steps);
+
+    // Spin only matters to the renderer: one update per call instead of per sub-step
+    for (auto& b : bodies) b.updateRotation(T);
+    return steps;
+}
+
+} // namespace SolarSim
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SolarSim {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Pages are faulted in from the page cache on first touch, so opening is
+ * constant time and reading a column touches only that column's pages. The
+ * mapping is page-aligned, so any offset aligned to the page size (or to a
+ * smaller power of two) is aligned in memory too.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @returns False if the file cannot be opened or mapped (an empty file maps to nothing)
+     */
+    bool open(const std::string& path) {
+        close();
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) { close(); return false; }
+        void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!p) { close(); return false; }
+        base = static_cast<const unsigned char*>(p);
+        length = (size_t)size.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (p == MAP_FAILED) return false;
+        base = static_cast<const unsigned char*>(p);
+        length = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void close() {
+#if defined(_WIN32)
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base) munmap(const_cast<unsigned char*>(base), length);
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+    const unsigned char* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* base = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+} // namespace SolarSim
@@ -3,177 +3,473 @@
 
 #include <vector>
 #include <memory>
-#include <stack>
+#include <cstdint>
+#include <algorithm>
 #include "Vector3.hpp"
-#include "Body.hpp"
 #include "Constants.hpp"
+#include "VirtualArena.hpp"
+
+#include <immintrin.h>
 
 namespace SolarSim {
 
 /**
- * @brief A node in the spatial partitioning Octree.
- * 
- * Each node represents a cubic volume in 3D space. 
- * - **Leaf Node**: Contains pointers to individual `Body` objects.
- * - **Internal Node**: Contains aggregate data (Center of Mass, Total Mass) for all bodies within its volume.
- * 
+ * @brief Center of mass and total mass of a node: the 32-byte hot record.
+ *
+ * This is all the opening test and the monopole term read, packed as four
+ * doubles so it fills exactly one AVX2 register.
+ */
+struct alignas(32) PointMass {
+    double x, y, z; ///< Center of mass (AU)
+    double mass;    ///< Total mass (Solar Masses)
+
+    Vector3 position() const { return Vector3(x, y, z); }
+};
+
+/**
+ * @brief A node in the spatial partitioning Octree, sized to one 64-byte cache line.
+ *
+ * Each node represents a cubic volume in 3D space.
+ * - **Leaf Node** (`childMask == 0`): Owns a contiguous range of bodies in the
+ *   pool's sorted body arrays.
+ * - **Internal Node**: Its non-empty children are allocated contiguously from
+ *   `firstChild`, in octant order; bit $k$ of `childMask` marks octant $k$.
+ *
+ * The cell bounds are only needed while building, so they live in a separate
+ * cold array (`OctreePool::getMinBounds`) and a traversal touches exactly one
+ * cache line per visited node.
+ *
  * @note This structure is optimized for the Barnes-Hut algorithm.
  */
-struct OctreeNode {
-    Vector3 centerOfMass; ///< Weighted average position of all bodies in this node
-    double totalMass;     ///< Sum of masses of all bodies in this node
-    Vector3 minBounds;    ///< Minimum corner of the cubic volume
-    double size;          ///< Side length of the cubic volume
+struct alignas(64) OctreeNode {
+    PointMass com;       ///< Hot record: center of mass and total mass
+    double size;         ///< Side length of the cubic volume
+    int firstChild;      ///< Pool index of the first child (internal only)
+    int bodyBegin;       ///< First body in the sorted body arrays
+    int bodyCount;       ///< Number of bodies in this subtree
+    uint8_t childMask;   ///< Bit k set if octant k has a child; 0 for leaves
 
-    int children[8]; // Indices in pool, -1 if none
-    Body* bodies[1]; // Using fixed size for simplicity in pooled nodes
-    int numBodies;
-    bool isLeaf;
+    bool isLeaf() const { return childMask == 0; }
 
-    OctreeNode() : centerOfMass(0,0,0), totalMass(0), size(0), numBodies(0), isLeaf(true) {
-        for (int i = 0; i < 8; ++i) children[i] = -1;
+    int childCount() const {
+        unsigned m = childMask;
+        m = m - ((m >> 1) & 0x55u);
+        m = (m & 0x33u) + ((m >> 2) & 0x33u);
+        return (int)((m + (m >> 4)) & 0x0Fu);
     }
+};
 
-    /**
-     * @brief Resets the node state for reuse in the memory pool.
-     * @param minB The minimum corner coordinates of the cubic volume.
-     * @param s The side length of the cubic volume.
-     */
-    void reset(Vector3 minB, double s) {
-        minBounds = minB;
-        size = s;
-        centerOfMass = Vector3(0,0,0);
-        totalMass = 0;
-        numBodies = 0;
-        isLeaf = true;
-        for (int i = 0; i < 8; ++i) children[i] = -1;
-    }
+static_assert(sizeof(OctreeNode) == 64, "OctreeNode must stay one cache line");
+
+/**
+ * @brief Cold per-node data, read only while building or refitting.
+ */
+struct OctreeCell {
+    Vector3 minBounds; ///< Minimum corner of the cubic volume at build time
+    Vector3 builtCom;  ///< Center of mass at build time
+    double size;       ///< Side length at build time (the hot `size` may be inflated)
+};
+
+/**
+ * @brief Node pool usage, for the GUI and benchmarks.
+ */
+struct OctreeStats {
+    size_t nodeCount = 0;      ///< Nodes used by the latest build
+    size_t highWaterMark = 0;  ///< Most nodes any build has used
+    size_t committedNodes = 0; ///< Nodes usable without growing
+    size_t reservedNodes = 0;  ///< Address space reserved, in nodes
+    size_t builds = 0;         ///< Number of builds so far
+    size_t refits = 0;         ///< Evaluations that reused the previous structure
+    bool hugePages = false;    ///< Arena advised for transparent huge pages
+};
+
+/**
+ * @brief Cached Barnes-Hut interaction list of one leaf group.
+ *
+ * Records which nodes the whole group accepted (`far`) and which leaves it
+ * opened (`near`), decided against a validity sphere around the group rather
+ * than against each body. Node indices are only meaningful for the build that
+ * produced them; refits keep them stable.
+ */
+struct InteractionList {
+    std::vector<int> far;   ///< Nodes evaluated as point masses
+    std::vector<int> near;  ///< Leaves summed body by body (includes the group's own leaf)
+    Vector3 center;         ///< Validity sphere center
+    double radius = 0.0;    ///< Validity sphere radius; the group must stay inside
+    size_t build = 0;       ///< `OctreeStats::builds` when walked; 0 = never walked
+};
+
+/**
+ * @brief One group's interaction list gathered for mixed precision (see `OctreePool::packInteractionList`).
+ *
+ * Scratch reused from group to group: far nodes as float offsets from the
+ * list's center with their masses, near bodies as double SoA with their
+ * positions in tree order, both padded to whole AVX2 batches.
+ */
+struct PackedInteractionList {
+    std::vector<float> farX, farY, farZ, farM;
+    std::vector<double> nearX, nearY, nearZ, nearM;
+    std::vector<int64_t> nearSlot;
+    Vector3 center;
+    int interactions = 0;  ///< Terms per body of the group (its own is skipped)
 };
 
 /**
  * @brief Memory-pooled Octree implementation for performance-critical N-body simulations.
- * 
- * To avoid the high cost of dynamic memory allocation and pointer chasing during 
+ *
+ * To avoid the high cost of dynamic memory allocation and pointer chasing during
  * high-frequency tree builds, this class uses a contiguous pool of OctreeNode objects.
- * 
+ *
+ * @details
+ * The tree is built top-down: each node partitions its range of the body order
+ * into octants (a counting sort), allocates its non-empty children as one
+ * contiguous block and recurses. Every subtree therefore owns a contiguous
+ * range of bodies, and a leaf holds up to `LEAF_CAPACITY` of them. Positions and
+ * masses are copied in that order, so a leaf's bodies are adjacent in memory.
+ *
  * @perf
- * - **Heap Stability**: No `new`/`delete` calls during simulation steps.
- * - **Cache Locality**: Nodes are stored contiguously in memory, improving CPU cache hit rates.
- * 
+ * - **Heap Stability**: Nodes live in a `VirtualArena` reserved for the worst
+ *   case of the current body count, so the pool never moves or copies mid-build.
+ *   Each build first commits the previous build's node count plus headroom.
+ * - **Cache Locality**: One cache line per node; siblings are adjacent.
+ *
  * @physics
  * Supports the **Barnes-Hut algorithm**, which approximates gravitational
- * forces from distant clusters as a single force from their center of mass, 
+ * forces from distant clusters as a single force from their center of mass,
  * reducing complexity from $O(N^2)$ to $O(N \log N)$.
  */
 class OctreePool {
+public:
+    static constexpr int LEAF_CAPACITY = 8; ///< Bodies per leaf before it is split
+    static constexpr int MAX_DEPTH = 32;    ///< Depth guard for coincident bodies
+
 private:
-    std::vector<OctreeNode> pool;
+    VirtualArena<OctreeNode> pool;
+    VirtualArena<OctreeCell> cells;           ///< Cold data, parallel to the pool
     int nextFree;
-    mutable std::vector<int> traversalStack;  ///< Reuse stack memory for iterative traversal
+    bool hugePages;
+    OctreeStats stats;
+
+    // Source arrays of the current build; valid until the next build()
+    const Vector3* positions = nullptr;
+    const double* masses = nullptr;
+
+    // Bodies in tree order: each node owns [bodyBegin, bodyBegin + bodyCount)
+    std::vector<int> bodyOrder;
+    std::vector<Vector3> sortedPos;
+    std::vector<double> sortedMass;
+    std::vector<Vector3> builtPos;   ///< Positions the structure was built from (tree order)
+    std::vector<double> spread;      ///< Refit scratch: largest body excursion relative to each cell
+    std::vector<int> partitionScratch;
+    std::vector<uint8_t> octantScratch;
+
+    /**
+     * @brief Per-thread traversal state, so one tree can be walked from many threads.
+     */
+    struct TraversalScratch {
+        std::vector<int> stack;
+    };
+
+    static TraversalScratch& traversalScratch() {
+        static thread_local TraversalScratch scratch;
+        return scratch;
+    }
 
 public:
-    OctreePool(size_t initialCapacity = 1024) : nextFree(0) {
-        pool.resize(initialCapacity);
-        traversalStack.reserve(256);  // Pre-allocate reasonable stack depth
+    /**
+     * @param initialCapacity Nodes to commit up front
+     * @param useHugePages Advise transparent huge pages for the node arena (Linux)
+     */
+    OctreePool(size_t initialCapacity = 1024, bool useHugePages = true) : nextFree(0), hugePages(useHugePages) {
+        reserveFor(0, initialCapacity);
+    }
+
+    /**
+     * @brief Upper bound on the nodes a build over `bodyCount` bodies can use.
+     *
+     * Internal nodes at one depth are disjoint and each hold more than
+     * `LEAF_CAPACITY` bodies, so there are at most $N / (C + 1)$ per level over
+     * `MAX_DEPTH` levels, each with at most 8 children.
+     */
+    static size_t maxNodesFor(size_t bodyCount) {
+        return 1 + 8 * ((size_t)MAX_DEPTH * bodyCount / (LEAF_CAPACITY + 1) + 1);
     }
 
+    const OctreeStats& getStats() const { return stats; }
+
     /**
      * @brief Resets the pool without deallocating memory.
      */
     void clear() { nextFree = 0; }
 
     /**
-     * @brief Allocates a node from the pool.
+     * @brief Allocates `count` contiguous nodes from the pool.
+     *
+     * Growth commits more of the reserved arena; existing nodes never move.
+     *
+     * @returns Index of the first node
      */
-    int allocate(Vector3 minB, double size) {
-        if (nextFree >= (int)pool.size()) {
-            pool.resize(pool.size() * 2);
+    int allocate(int count) {
+        if ((size_t)(nextFree + count) > pool.getCommitted()) {
+            size_t grown = std::min(std::max(pool.getCommitted() * 2, (size_t)(nextFree + count)), pool.getReserved());
+            pool.commit(grown);
+            cells.commit(grown);
         }
-        int idx = nextFree++;
-        pool[idx].reset(minB, size);
+        int idx = nextFree;
+        nextFree += count;
         return idx;
     }
 
     OctreeNode& operator[](int idx) { return pool[idx]; }
     const OctreeNode& operator[](int idx) const { return pool[idx]; }
 
-    void insert(int nodeIdx, Body* body) {
-        if (pool[nodeIdx].isLeaf) {
-            if (pool[nodeIdx].numBodies == 0) {
-                pool[nodeIdx].bodies[0] = body;
-                pool[nodeIdx].numBodies = 1;
-                pool[nodeIdx].totalMass = body->mass;
-                pool[nodeIdx].centerOfMass = body->position;
-            } else {
-                Body* existingBody = pool[nodeIdx].bodies[0];
-                pool[nodeIdx].isLeaf = false;
-                pool[nodeIdx].numBodies = 0;
-                // Re-insert existing body into a child, then insert the new body
-                // The parent's totalMass and centerOfMass are already set for the existingBody (from lines 105-106)
-                // The subsequent insert() call will handle merging the new body's mass.
-                insertIntoChild(nodeIdx, existingBody);
-                insert(nodeIdx, body); 
-            }
-        } else {
-            insertIntoChild(nodeIdx, body);
-            // Update center of mass
-            OctreeNode& node = pool[nodeIdx];
-            node.centerOfMass = (node.centerOfMass * node.totalMass + body->position * body->mass) / (node.totalMass + body->mass);
-            node.totalMass += body->mass;
+    int getNodeCount() const { return nextFree; }
+    const Vector3& getMinBounds(int idx) const { return cells[idx].minBounds; }
+
+    /**
+     * @brief Body indices in tree order (a Morton-like traversal of the leaves).
+     *
+     * Contiguous ranges of this order are spatially compact, which makes them
+     * the natural unit for splitting a force pass across threads.
+     */
+    const std::vector<int>& getBodyOrder() const { return bodyOrder; }
+
+    /**
+     * @brief Follows a permutation of the body store, so the next `refit` still matches.
+     *
+     * Only the body indices change; tree slots, node ranges and therefore
+     * cached interaction lists stay valid.
+     *
+     * @param oldToNew Remap table from `reorderBodiesMorton`
+     */
+    void remapBodies(const std::vector<int>& oldToNew) {
+        if (oldToNew.size() != bodyOrder.size()) return; // The next refit rebuilds anyway
+        for (int& b : bodyOrder) b = oldToNew[b];
+    }
+
+    /**
+     * @brief Rebuilds the tree over a set of point masses.
+     *
+     * The arrays are referenced, not copied, and must outlive any traversal of
+     * this build.
+     *
+     * @param pos Body positions in AU
+     * @param mass Body masses in Solar Masses
+     * @returns Index of the root node
+     */
+    int build(const std::vector<Vector3>& pos, const std::vector<double>& mass) {
+        clear();
+        positions = pos.data();
+        masses = mass.data();
+        const int n = (int)pos.size();
+
+        // Presize before building: the structure barely changes between steps
+        reserveFor(n, std::max(stats.nodeCount + stats.nodeCount / 4, (size_t)n / 2 + 64));
+
+        Vector3 minB(1e18, 1e18, 1e18), maxB(-1e18, -1e18, -1e18);
+        for (const auto& p : pos) {
+            minB.x = std::min(minB.x, p.x); minB.y = std::min(minB.y, p.y); minB.z = std::min(minB.z, p.z);
+            maxB.x = std::max(maxB.x, p.x); maxB.y = std::max(maxB.y, p.y); maxB.z = std::max(maxB.z, p.z);
+        }
+        double s = std::max({maxB.x - minB.x, maxB.y - minB.y, maxB.z - minB.z}) * 0.5 + 0.1;
+        Vector3 mid = (minB + maxB) * 0.5;
+
+        bodyOrder.resize(n);
+        for (int i = 0; i < n; ++i) bodyOrder[i] = i;
+        partitionScratch.resize(n);
+        octantScratch.resize(n);
+
+        int rootIdx = allocate(1);
+        buildNode(rootIdx, 0, n, mid - Vector3(s, s, s), s * 2.0, 0);
+
+        sortedPos.resize(n);
+        sortedMass.resize(n);
+        for (int k = 0; k < n; ++k) {
+            sortedPos[k] = pos[bodyOrder[k]];
+            sortedMass[k] = mass[bodyOrder[k]];
         }
+        builtPos = sortedPos;
+        for (int i = 0; i < nextFree; ++i) cells[i].builtCom = pool[i].com.position();
+
+        stats.nodeCount = nextFree;
+        stats.highWaterMark = std::max(stats.highWaterMark, stats.nodeCount);
+        stats.committedNodes = pool.getCommitted();
+        ++stats.builds;
+        return rootIdx;
     }
 
     /**
-     * @brief Inserts a body into the appropriate octant of a node.
-     * 
+     * @brief Partitions `bodyOrder[begin, end)` into a subtree rooted at `nodeIdx`.
+     *
      * @details
      * The octant index (0-7) is determined using bit-masking on the coordinates:
      * - **Bit 0 (1)**: X-axis (0: left, 1: right)
      * - **Bit 1 (2)**: Y-axis (0: bottom, 1: top)
      * - **Bit 2 (4)**: Z-axis (0: back, 1: front)
-     * 
+     *
      * For example, an index of 3 (binary 011) represents (+X, +Y, -Z).
-     * 
-     * @param nodeIdx Index of parent node in pool
-     * @param body Pointer to body to insert
      */
-    void insertIntoChild(int nodeIdx, Body* body) {
-        double halfSize = pool[nodeIdx].size * 0.5;
-        Vector3 mid = pool[nodeIdx].minBounds + Vector3(halfSize, halfSize, halfSize);
-        
-        int idx = 0;
-        if (body->position.x >= mid.x) idx |= 1;
-        if (body->position.y >= mid.y) idx |= 2;
-        if (body->position.z >= mid.z) idx |= 4;
+    void buildNode(int nodeIdx, int begin, int end, const Vector3& minB, double size, int depth) {
+        cells[nodeIdx].minBounds = minB;
+        cells[nodeIdx].size = size;
+        {
+            OctreeNode& node = pool[nodeIdx];
+            node.size = size;
+            node.firstChild = -1;
+            node.bodyBegin = begin;
+            node.bodyCount = end - begin;
+            node.childMask = 0;
+        }
+
+        if (end - begin <= LEAF_CAPACITY || depth >= MAX_DEPTH) {
+            double m = 0.0;
+            Vector3 weighted(0, 0, 0);
+            for (int k = begin; k < end; ++k) {
+                const int b = bodyOrder[k];
+                weighted += positions[b] * masses[b];
+                m += masses[b];
+            }
+            setCenterOfMass(pool[nodeIdx], weighted, m, begin < end ? positions[bodyOrder[begin]] : minB);
+            return;
+        }
+
+        // Counting sort of the range by octant
+        const double halfSize = size * 0.5;
+        const Vector3 mid = minB + Vector3(halfSize, halfSize, halfSize);
+        int counts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (int k = begin; k < end; ++k) {
+            const Vector3& p = positions[bodyOrder[k]];
+            uint8_t o = (uint8_t)((p.x >= mid.x ? 1 : 0) | (p.y >= mid.y ? 2 : 0) | (p.z >= mid.z ? 4 : 0));
+            octantScratch[k] = o;
+            ++counts[o];
+        }
+        int offsets[9];
+        offsets[0] = begin;
+        for (int o = 0; o < 8; ++o) offsets[o + 1] = offsets[o] + counts[o];
+        int cursor[8];
+        std::copy(offsets, offsets + 8, cursor);
+        for (int k = begin; k < end; ++k) partitionScratch[cursor[octantScratch[k]]++] = bodyOrder[k];
+        std::copy(partitionScratch.begin() + begin, partitionScratch.begin() + end, bodyOrder.begin() + begin);
+
+        uint8_t mask = 0;
+        for (int o = 0; o < 8; ++o) if (counts[o] > 0) mask |= (uint8_t)(1u << o);
+        pool[nodeIdx].childMask = mask;
+        const int first = allocate(pool[nodeIdx].childCount()); // May grow the pool: no references held across
+        pool[nodeIdx].firstChild = first;
+
+        double m = 0.0;
+        Vector3 weighted(0, 0, 0);
+        int child = first;
+        for (int o = 0; o < 8; ++o) {
+            if (counts[o] == 0) continue;
+            Vector3 cMin = minB;
+            if (o & 1) cMin.x += halfSize;
+            if (o & 2) cMin.y += halfSize;
+            if (o & 4) cMin.z += halfSize;
+            buildNode(child, offsets[o], offsets[o + 1], cMin, halfSize, depth + 1);
+            const PointMass& c = pool[child].com;
+            weighted += c.position() * c.mass;
+            m += c.mass;
+            ++child;
+        }
+        setCenterOfMass(pool[nodeIdx], weighted, m, mid);
+    }
+
+    /**
+     * @brief Reuses the current tree structure for moved bodies.
+     *
+     * Every center of mass is recomputed bottom-up from the new positions
+     * (children always follow their parent in the pool, so a reverse sweep
+     * visits children first). Each cell is carried along with its own center
+     * of mass, i.e. drifted by the node's mass-weighted velocity, so only the
+     * velocity dispersion *inside* a node degrades it: if $\rho$ bounds how far
+     * any body moved relative to its cell, the bodies still fit in a cube of
+     * side $s + 2\rho$, and the opening test uses that conservatively inflated
+     * size. $\rho$ is propagated upwards with the triangle inequality,
+     * $\rho_{parent} = \max_c(\rho_c + |D_c - D_{parent}|)$ for cell drifts $D$.
+     *
+     * @param pos Body positions in AU (same bodies and order as the last build)
+     * @param mass Body masses in Solar Masses
+     * @param tolerance Largest $\rho / s$ tolerated for an internal node; leaves
+     *        fall back to exact sums when opened, so they are not limited
+     * @returns Index of the root node, or -1 if the structure is no longer
+     *          worth reusing (body count changed or a node spread too far); then
+     *          call `build`
+     */
+    int refit(const std::vector<Vector3>& pos, const std::vector<double>& mass, double tolerance) {
+        const int n = (int)pos.size();
+        if (nextFree == 0 || n != (int)bodyOrder.size()) return -1;
+
+        for (int k = 0; k < n; ++k) {
+            sortedPos[k] = pos[bodyOrder[k]];
+            sortedMass[k] = mass[bodyOrder[k]];
+        }
+        spread.resize(nextFree);
+
+        for (int nodeIdx = nextFree - 1; nodeIdx >= 0; --nodeIdx) {
+            OctreeNode& node = pool[nodeIdx];
+            const OctreeCell& cell = cells[nodeIdx];
+            double m = 0.0;
+            Vector3 weighted(0, 0, 0);
+            if (node.isLeaf()) {
+                for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                    weighted += sortedPos[k] * sortedMass[k];
+                    m += sortedMass[k];
+                }
+            } else {
+                for (int c = node.firstChild; c < node.firstChild + node.childCount(); ++c) {
+                    weighted += pool[c].com.position() * pool[c].com.mass;
+                    m += pool[c].com.mass;
+                }
+            }
+            setCenterOfMass(node, weighted, m, node.com.position());
+            const Vector3 drift = node.com.position() - cell.builtCom;
 
-        if (pool[nodeIdx].children[idx] == -1) {
-            Vector3 cMin = pool[nodeIdx].minBounds;
-            if (idx & 1) cMin.x += halfSize;
-            if (idx & 2) cMin.y += halfSize;
-            if (idx & 4) cMin.z += halfSize;
-            int childIdx = allocate(cMin, halfSize);
-            pool[nodeIdx].children[idx] = childIdx;
+            double rho = 0.0;
+            if (node.isLeaf()) {
+                for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                    rho = std::max(rho, (sortedPos[k] - builtPos[k] - drift).length());
+                }
+            } else {
+                for (int c = node.firstChild; c < node.firstChild + node.childCount(); ++c) {
+                    const Vector3 childDrift = pool[c].com.position() - cells[c].builtCom;
+                    rho = std::max(rho, spread[c] + (childDrift - drift).length());
+                }
+                if (rho > tolerance * cell.size) return -1;
+            }
+            spread[nodeIdx] = rho;
+            node.size = cell.size + 2.0 * rho;
         }
-        insert(pool[nodeIdx].children[idx], body);
+
+        positions = pos.data();
+        masses = mass.data();
+        ++stats.refits;
+        return 0;
     }
 
     /**
-     * @brief Calculates gravitational force on a body using an iterative tree traversal.
-     * 
+     * @brief Calculates the gravitational acceleration on a body using an iterative tree traversal.
+     *
      * Uses the Barnes-Hut approximation:
-     * If the distance $d$ between the body and node's center of mass satisfies 
-     * $s/d < \theta$ (where $s$ is node size), the entire subtree is treated as a 
-     * single particle at the center of mass.
-     * 
+     * If the distance $d$ between the body and node's center of mass satisfies
+     * $s/d < \theta$ (where $s$ is node size, inflated after a `refit`), the
+     * entire subtree is treated as a single particle at the center of mass. A
+     * leaf that fails the test is summed body by body.
+     *
      * @param rootIdx Index of the tree root in the pool
-     * @param body The body to calculate forces for
+     * @param bodyIdx Index of the body to calculate the acceleration for
      * @param theta Accuracy threshold (Openness parameter)
-     * @param totalForce Output accumulator for the force vector
+     * @param softening Squared softening length added to every $r^2$
+     * @param totalAcceleration Output accumulator for the acceleration vector
+     * @returns Interactions evaluated (accepted nodes plus body-body terms), the
+     *          per-body cost used for load balancing
      */
-    void calculateForceIterative(int rootIdx, Body* body, double theta, Vector3& totalForce) const {
-        // Use the global softening parameter to maintain consistency
-        const double SOFTENING_SQUARED = Constants::SOFTENING_EPSILON;
+    int calculateForceIterative(int rootIdx, int bodyIdx, double theta, double softening,
+                                Vector3& totalAcceleration) const {
+        const Vector3& pos = positions[bodyIdx];
+        int interactions = 0;
 
+        std::vector<int>& traversalStack = traversalScratch().stack;
         traversalStack.clear();
         traversalStack.push_back(rootIdx);
 
@@ -182,28 +478,539 @@ public:
             traversalStack.pop_back();
             const OctreeNode& node = pool[nodeIdx];
 
-            if (node.isLeaf) {
-                if (node.numBodies > 0 && node.bodies[0] != body) {
-                    Vector3 r = node.bodies[0]->position - body->position;
-                    double d2 = r.lengthSquared() + SOFTENING_SQUARED;
+            Vector3 r = node.com.position() - pos;
+            double dist = r.length();
+            // Guard against division-by-zero: if body is at center of mass, open the node
+            if (dist >= 1e-10 && node.size < theta * dist) {
+                double d2 = r.lengthSquared() + softening;
+                double invD3 = 1.0 / (d2 * std::sqrt(d2));
+                totalAcceleration += r * (Constants::G * node.com.mass * invD3);
+                ++interactions;
+            } else if (node.isLeaf()) {
+                for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                    if (bodyOrder[k] == bodyIdx) continue;
+                    Vector3 rb = sortedPos[k] - pos;
+                    double d2 = rb.lengthSquared() + softening;
                     double invD3 = 1.0 / (d2 * std::sqrt(d2));
-                    totalForce += r * (Constants::G * body->mass * node.bodies[0]->mass * invD3);
+                    totalAcceleration += rb * (Constants::G * sortedMass[k] * invD3);
+                    ++interactions;
                 }
             } else {
-                double dist = (node.centerOfMass - body->position).length();
-                // Guard against division-by-zero: if body is at center of mass, traverse children
-                if (dist < 1e-10 || node.size / dist >= theta) {
-                    for (int i = 0; i < 8; ++i) {
-                        if (node.children[i] != -1) traversalStack.push_back(node.children[i]);
-                    }
-                } else {
-                    Vector3 r = node.centerOfMass - body->position;
-                    double d2 = r.lengthSquared() + SOFTENING_SQUARED;
-                    double invD3 = 1.0 / (d2 * std::sqrt(d2));
-                    totalForce += r * (Constants::G * body->mass * node.totalMass * invD3);
+                for (int c = node.firstChild + node.childCount() - 1; c >= node.firstChild; --c) {
+                    traversalStack.push_back(c);
+                }
+            }
+        }
+        return interactions;
+    }
+
+    /**
+     * @brief Traversal with the relative (error-controlled) opening criterion.
+     *
+     * Instead of a fixed opening angle, a node of mass $M$ and size $s$ is
+     * accepted when its leading truncation error is below a fraction $\alpha$ of
+     * the body's total acceleration from the previous step:
+     *
+     * $$\frac{G M}{d^2}\left(\frac{s}{d}\right)^2 \le \alpha\,|a_{old}|
+     *   \quad\Longleftrightarrow\quad M s^2 \le \frac{\alpha |a_{old}|}{G}\, d^4$$
+     *
+     * Bodies whose field is dominated by one distant mass (most of the Solar
+     * System: everything is a small perturbation on the Sun) then accept large,
+     * close nodes, while bodies in strong-gradient regions keep opening. As a
+     * guard against accepting a node the body is inside of, $s < d$ is also
+     * required. Evaluated on squared distances, no sqrt.
+     *
+     * @param tolerance $\alpha |a_{old}| / G$ for this body, in Solar Masses per AU$^2$
+     * @returns Interactions evaluated, as for `calculateForceIterative`
+     */
+    int calculateForceRelative(int rootIdx, int bodyIdx, double tolerance, double softening,
+                               Vector3& totalAcceleration) const {
+        const Vector3& pos = positions[bodyIdx];
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        int interactions = 0;
+
+        std::vector<int>& traversalStack = traversalScratch().stack;
+        traversalStack.clear();
+        traversalStack.push_back(rootIdx);
+
+        while (!traversalStack.empty()) {
+            const OctreeNode& node = pool[traversalStack.back()];
+            traversalStack.pop_back();
+
+            double rx = node.com.x - pos.x, ry = node.com.y - pos.y, rz = node.com.z - pos.z;
+            double d2 = rx * rx + ry * ry + rz * rz;
+            double s2 = node.size * node.size;
+            if (d2 >= 1e-20 && s2 < d2 && node.com.mass * s2 <= tolerance * d2 * d2) {
+                double e2 = d2 + softening;
+                double sc = node.com.mass / (e2 * std::sqrt(e2));
+                ax += rx * sc; ay += ry * sc; az += rz * sc;
+                ++interactions;
+            } else if (node.isLeaf()) {
+                for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                    if (bodyOrder[k] == bodyIdx) continue;
+                    Vector3 rb = sortedPos[k] - pos;
+                    double e2 = rb.lengthSquared() + softening;
+                    double sc = sortedMass[k] / (e2 * std::sqrt(e2));
+                    ax += rb.x * sc; ay += rb.y * sc; az += rb.z * sc;
+                    ++interactions;
+                }
+            } else {
+                for (int c = node.firstChild + node.childCount() - 1; c >= node.firstChild; --c) {
+                    traversalStack.push_back(c);
                 }
             }
         }
+        totalAcceleration += Vector3(ax, ay, az) * Constants::G;
+        return interactions;
+    }
+
+    /**
+     * @brief Barnes-Hut traversal that tests all children of an opened node at once.
+     *
+     * Same result as `calculateForceIterative`, but the walk is organized around
+     * opened nodes: when a node is opened, its (contiguous) children are tested
+     * four at a time in AVX2. The four 32-byte `PointMass` records are loaded
+     * and transposed into x/y/z/m registers, and the opening criterion is
+     * evaluated on squared quantities,
+     *
+     * $$s^2 < \theta^2 d^2 \quad (d^2 \ge 10^{-20}),$$
+     *
+     * so no square root is needed to decide. Accepted children are accumulated
+     * right away under a lane mask; only opened children are pushed, and an
+     * opened leaf is summed body by body when popped. Without AVX2 this falls
+     * back to `calculateForceIterative`.
+     *
+     * @returns Interactions evaluated, as for `calculateForceIterative`
+     */
+    int calculateForceSimd(int rootIdx, int bodyIdx, double theta, double softening,
+                           Vector3& totalAcceleration) const {
+#if defined(__AVX2__)
+        const Vector3& pos = positions[bodyIdx];
+        const double theta2 = theta * theta;
+        int interactions = 0;
+
+        // The root has no parent to test it
+        {
+            const OctreeNode& root = pool[rootIdx];
+            Vector3 r = root.com.position() - pos;
+            double d2 = r.lengthSquared();
+            if (d2 >= 1e-20 && root.size * root.size < theta2 * d2) {
+                double s2 = d2 + softening;
+                totalAcceleration += r * (Constants::G * root.com.mass / (s2 * std::sqrt(s2)));
+                return 1;
+            }
+        }
+
+        static const PointMass empty = { 0.0, 0.0, 0.0, 0.0 };
+        const __m256d px = _mm256_set1_pd(pos.x), py = _mm256_set1_pd(pos.y), pz = _mm256_set1_pd(pos.z);
+        const __m256d th2 = _mm256_set1_pd(theta2);
+        const __m256d minD2 = _mm256_set1_pd(1e-20);
+        const __m256d eps = _mm256_set1_pd(softening);
+        __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+        double lx = 0.0, ly = 0.0, lz = 0.0; // Leaf body-body terms
+
+        std::vector<int>& traversalStack = traversalScratch().stack;
+        traversalStack.clear();
+        traversalStack.push_back(rootIdx);
+
+        while (!traversalStack.empty()) {
+            const OctreeNode& node = pool[traversalStack.back()];
+            traversalStack.pop_back();
+
+            if (node.isLeaf()) {
+                for (int k = node.bodyBegin; k < node.bodyBegin + node.bodyCount; ++k) {
+                    if (bodyOrder[k] == bodyIdx) continue;
+                    Vector3 rb = sortedPos[k] - pos;
+                    double d2 = rb.lengthSquared() + softening;
+                    double sc = sortedMass[k] / (d2 * std::sqrt(d2));
+                    lx += rb.x * sc; ly += rb.y * sc; lz += rb.z * sc;
+                    ++interactions;
+                }
+                continue;
+            }
+
+            const int first = node.firstChild;
+            const int count = node.childCount();
+            for (int g = 0; g < count; g += 4) {
+                const int lanes = std::min(4, count - g);
+                const OctreeNode* c = &pool[first + g];
+
+                // Transpose four (x, y, z, m) records into x/y/z/m registers
+                __m256d r0 = _mm256_load_pd(&c[0].com.x);
+                __m256d r1 = _mm256_load_pd(lanes > 1 ? &c[1].com.x : &empty.x);
+                __m256d r2 = _mm256_load_pd(lanes > 2 ? &c[2].com.x : &empty.x);
+                __m256d r3 = _mm256_load_pd(lanes > 3 ? &c[3].com.x : &empty.x);
+                __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+                __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+                __m256d cx = _mm256_permute2f128_pd(t0, t2, 0x20);
+                __m256d cz = _mm256_permute2f128_pd(t0, t2, 0x31);
+                __m256d cy = _mm256_permute2f128_pd(t1, t3, 0x20);
+                __m256d cm = _mm256_permute2f128_pd(t1, t3, 0x31);
+                __m256d size = _mm256_set_pd(lanes > 3 ? c[3].size : 0.0, lanes > 2 ? c[2].size : 0.0,
+                                             lanes > 1 ? c[1].size : 0.0, c[0].size);
+
+                __m256d dx = _mm256_sub_pd(cx, px), dy = _mm256_sub_pd(cy, py), dz = _mm256_sub_pd(cz, pz);
+                __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                           _mm256_mul_pd(dz, dz));
+                __m256d accept = _mm256_and_pd(_mm256_cmp_pd(_mm256_mul_pd(size, size), _mm256_mul_pd(th2, d2), _CMP_LT_OQ),
+                                               _mm256_cmp_pd(d2, minD2, _CMP_GE_OQ));
+
+                // Monopole for accepted lanes; padded lanes have zero mass
+                __m256d s2 = _mm256_add_pd(d2, eps);
+                __m256d sc = _mm256_div_pd(cm, _mm256_mul_pd(s2, _mm256_sqrt_pd(s2)));
+                sc = _mm256_and_pd(sc, accept);
+                ax = _mm256_add_pd(ax, _mm256_mul_pd(dx, sc));
+                ay = _mm256_add_pd(ay, _mm256_mul_pd(dy, sc));
+                az = _mm256_add_pd(az, _mm256_mul_pd(dz, sc));
+
+                const int valid = (1 << lanes) - 1;
+                const int acceptedBits = _mm256_movemask_pd(accept) & valid;
+                interactions += __builtin_popcount((unsigned)acceptedBits);
+                int opened = ~acceptedBits & valid;
+                while (opened) {
+                    int lane = 31 - __builtin_clz((unsigned)opened); // Highest first: lowest is popped first
+                    traversalStack.push_back(first + g + lane);
+                    opened &= ~(1 << lane);
+                }
+            }
+        }
+
+        alignas(32) double bx[4], by[4], bz[4];
+        _mm256_store_pd(bx, ax); _mm256_store_pd(by, ay); _mm256_store_pd(bz, az);
+        totalAcceleration += Vector3(bx[0] + bx[1] + bx[2] + bx[3] + lx,
+                                     by[0] + by[1] + by[2] + by[3] + ly,
+                                     bz[0] + bz[1] + bz[2] + bz[3] + lz) * Constants::G;
+        return interactions;
+#else
+        return calculateForceIterative(rootIdx, bodyIdx, theta, softening, totalAcceleration);
+#endif
+    }
+
+    /**
+     * @brief Leaf indices sorted by their first body in tree order.
+     */
+    void collectLeaves(std::vector<int>& leaves) const {
+        leaves.clear();
+        for (int i = 0; i < nextFree; ++i) {
+            if (pool[i].isLeaf()) leaves.push_back(i);
+        }
+        std::sort(leaves.begin(), leaves.end(),
+                  [this](int a, int b) { return pool[a].bodyBegin < pool[b].bodyBegin; });
+    }
+
+    /**
+     * @brief Walks the tree once for all bodies of a leaf and records the result.
+     *
+     * The opening criterion is applied to a sphere of radius
+     * $\rho = r_{group} + \text{margin} \cdot s_{leaf}$ around the group:
+     *
+     * $$s < \theta\,(|c_N - c| - \rho)$$
+     *
+     * Every body inside the sphere is at least $|c_N - c| - \rho$ from the node,
+     * so an accepted node also passes the per-body test of
+     * `calculateForceIterative`. The margin is what lets the list outlive small
+     * motions (see `isInteractionListValid`).
+     *
+     * @param leafIdx Leaf whose bodies form the group
+     * @param margin Validity radius beyond the group's extent, as a fraction of the leaf size
+     * @returns Nodes visited
+     */
+    int buildInteractionList(int rootIdx, int leafIdx, double theta, double margin,
+                             InteractionList& list) const {
+        double groupRadius;
+        groupSphere(pool[leafIdx], list.center, groupRadius);
+        list.radius = groupRadius + margin * pool[leafIdx].size;
+        list.build = stats.builds;
+        list.far.clear();
+        list.near.clear();
+
+        int visited = 0;
+        std::vector<int>& traversalStack = traversalScratch().stack;
+        traversalStack.clear();
+        traversalStack.push_back(rootIdx);
+
+        while (!traversalStack.empty()) {
+            int nodeIdx = traversalStack.back();
+            traversalStack.pop_back();
+            const OctreeNode& node = pool[nodeIdx];
+            ++visited;
+
+            double gap = (node.com.position() - list.center).length() - list.radius;
+            if (gap >= 1e-10 && node.size < theta * gap) {
+                list.far.push_back(nodeIdx);
+            } else if (node.isLeaf()) {
+                list.near.push_back(nodeIdx);
+            } else {
+                for (int c = node.firstChild + node.childCount() - 1; c >= node.firstChild; --c) {
+                    traversalStack.push_back(c);
+                }
+            }
+        }
+        return visited;
+    }
+
+    /**
+     * @brief Whether a cached list still satisfies the opening criterion.
+     *
+     * Valid while the tree has only been refitted since the walk, the group
+     * still lies inside its validity sphere, and every far node (whose center
+     * of mass drifts and whose size grows with refits) still passes the test
+     * against that sphere. The near set needs no check: together with the far
+     * nodes it partitions the bodies for as long as the structure is unchanged.
+     */
+    bool isInteractionListValid(int leafIdx, double theta, const InteractionList& list) const {
+        if (list.build != stats.builds || list.build == 0) return false;
+
+        Vector3 c;
+        double r;
+        groupSphere(pool[leafIdx], c, r);
+        if ((c - list.center).length() + r > list.radius) return false;
+
+        for (int nodeIdx : list.far) {
+            const OctreeNode& node = pool[nodeIdx];
+            double gap = (node.com.position() - list.center).length() - list.radius;
+            if (!(gap >= 1e-10 && node.size < theta * gap)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Evaluates a cached list for one body of its group.
+     * @returns Interactions evaluated, as for `calculateForceIterative`
+     */
+    int evaluateInteractionList(const InteractionList& list, int bodyIdx, double softening,
+                                Vector3& totalAcceleration) const {
+        const Vector3& pos = positions[bodyIdx];
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        int interactions = (int)list.far.size();
+
+        for (int nodeIdx : list.far) {
+            const PointMass& com = pool[nodeIdx].com;
+            double rx = com.x - pos.x, ry = com.y - pos.y, rz = com.z - pos.z;
+            double d2 = rx * rx + ry * ry + rz * rz + softening;
+            double sc = com.mass / (d2 * std::sqrt(d2));
+            ax += rx * sc; ay += ry * sc; az += rz * sc;
+        }
+        for (int leafIdx : list.near) {
+            const OctreeNode& leaf = pool[leafIdx];
+            for (int k = leaf.bodyBegin; k < leaf.bodyBegin + leaf.bodyCount; ++k) {
+                if (bodyOrder[k] == bodyIdx) continue;
+                Vector3 rb = sortedPos[k] - pos;
+                double d2 = rb.lengthSquared() + softening;
+                double sc = sortedMass[k] / (d2 * std::sqrt(d2));
+                ax += rb.x * sc; ay += rb.y * sc; az += rb.z * sc;
+                ++interactions;
+            }
+        }
+        totalAcceleration += Vector3(ax, ay, az) * Constants::G;
+        return interactions;
+    }
+
+    /**
+     * @brief `isInteractionListValid` fused with packing the list for `evaluateInteractionListMixed`.
+     *
+     * Runs once per pass for the whole group, whose bodies then share `out`. Each far node is stored as the float offset of its center of mass
+     * from the list's center. The group lies inside the validity sphere, so a
+     * body's offset from the same center is shorter than its distance to any
+     * far node, and float rounding of both offsets stays relative to that
+     * distance ($\sim 10^{-7}$) rather than to the extent of the tree, which
+     * would lose the moons. The bodies of the near leaves are copied as double
+     * SoA. Centers of mass move with every refit, so lists are repacked every
+     * pass into scratch that stays in cache; the validity test reads the same
+     * nodes, so it comes almost free.
+     *
+     * @param check Test validity as `isInteractionListValid` does (a freshly built list passes)
+     * @returns False, with `out` incomplete, if the list must be rebuilt
+     */
+    bool packInteractionList(int leafIdx, double theta, const InteractionList& list, PackedInteractionList& out,
+                             bool check = true) const {
+        if (check) {
+            if (list.build != stats.builds || list.build == 0) return false;
+            Vector3 c;
+            double r;
+            groupSphere(pool[leafIdx], c, r);
+            if ((c - list.center).length() + r > list.radius) return false;
+        }
+
+        const size_t farCount = list.far.size(), farPadded = (farCount + 7) & ~size_t(7);
+        out.farX.resize(farPadded);
+        out.farY.resize(farPadded);
+        out.farZ.resize(farPadded);
+        out.farM.resize(farPadded);
+        for (size_t k = 0; k < farCount; ++k) {
+            const OctreeNode& node = pool[list.far[k]];
+            const double dx = node.com.x - list.center.x, dy = node.com.y - list.center.y, dz = node.com.z - list.center.z;
+            if (check) {
+                const double gap = std::sqrt(dx * dx + dy * dy + dz * dz) - list.radius;
+                if (!(gap >= 1e-10 && node.size < theta * gap)) return false;
+            }
+            out.farX[k] = (float)dx;
+            out.farY[k] = (float)dy;
+            out.farZ[k] = (float)dz;
+            out.farM[k] = (float)node.com.mass;
+        }
+        // Padding: zero mass at unit distance contributes nothing
+        for (size_t k = farCount; k < farPadded; ++k) {
+            out.farX[k] = 1.0f; out.farY[k] = 0.0f; out.farZ[k] = 0.0f; out.farM[k] = 0.0f;
+        }
+
+        int nearCount = 0;
+        for (int nearLeaf : list.near) nearCount += pool[nearLeaf].bodyCount;
+        const size_t nearPadded = ((size_t)nearCount + 3) & ~size_t(3);
+        out.nearX.resize(nearPadded);
+        out.nearY.resize(nearPadded);
+        out.nearZ.resize(nearPadded);
+        out.nearM.resize(nearPadded);
+        out.nearSlot.resize(nearPadded);
+        size_t n = 0;
+        for (int nearLeaf : list.near) {
+            const OctreeNode& leaf = pool[nearLeaf];
+            for (int k = leaf.bodyBegin; k < leaf.bodyBegin + leaf.bodyCount; ++k, ++n) {
+                out.nearX[n] = sortedPos[k].x;
+                out.nearY[n] = sortedPos[k].y;
+                out.nearZ[n] = sortedPos[k].z;
+                out.nearM[n] = sortedMass[k];
+                out.nearSlot[n] = k;
+            }
+        }
+        // Padding: zero mass away from the group, never the body itself
+        for (; n < nearPadded; ++n) {
+            out.nearX[n] = list.center.x + 1.0; out.nearY[n] = list.center.y; out.nearZ[n] = list.center.z;
+            out.nearM[n] = 0.0;
+            out.nearSlot[n] = -1;
+        }
+        out.center = list.center;
+        out.interactions = (int)farCount + nearCount - 1;
+        return true;
+    }
+
+    /**
+     * @brief Evaluates a packed list (see `packInteractionList`) for the body at `slot` in tree order.
+     *
+     * The far field is evaluated 8 nodes at a time in AVX2 float, each batch
+     * widened into double accumulators; far-field terms carry a monopole error
+     * of order $\theta^2$, so float stays well inside the existing budget. The
+     * near field stays in double, 4 bodies at a time, with the body itself
+     * masked out. Without AVX2 the same arrays are summed one term at a time.
+     *
+     * @param slot Position of the body in tree order (see `getBodyOrder`)
+     * @returns Interactions evaluated, as for `calculateForceIterative`
+     */
+    int evaluateInteractionListMixed(const PackedInteractionList& list, int slot, double softening,
+                                     Vector3& totalAcceleration) const {
+#if defined(__AVX2__)
+        const Vector3& pos = sortedPos[slot];
+
+        const __m256 px = _mm256_set1_ps((float)(pos.x - list.center.x));
+        const __m256 py = _mm256_set1_ps((float)(pos.y - list.center.y));
+        const __m256 pz = _mm256_set1_ps((float)(pos.z - list.center.z));
+        const __m256 epsF = _mm256_set1_ps((float)softening);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        __m256d accX = _mm256_setzero_pd(), accY = _mm256_setzero_pd(), accZ = _mm256_setzero_pd();
+        for (size_t k = 0; k < list.farM.size(); k += 8) {
+            const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&list.farX[k]), px);
+            const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&list.farY[k]), py);
+            const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&list.farZ[k]), pz);
+            const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                                            _mm256_add_ps(_mm256_mul_ps(dz, dz), epsF));
+            const __m256 invD = _mm256_div_ps(one, _mm256_sqrt_ps(d2));
+            const __m256 sc = _mm256_mul_ps(_mm256_mul_ps(invD, _mm256_mul_ps(invD, invD)), _mm256_loadu_ps(&list.farM[k]));
+            const __m256 fx = _mm256_mul_ps(dx, sc), fy = _mm256_mul_ps(dy, sc), fz = _mm256_mul_ps(dz, sc);
+
+            // Widen both halves into the double accumulators
+            accX = _mm256_add_pd(accX, _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(fx)),
+                                                     _mm256_cvtps_pd(_mm256_extractf128_ps(fx, 1))));
+            accY = _mm256_add_pd(accY, _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(fy)),
+                                                     _mm256_cvtps_pd(_mm256_extractf128_ps(fy, 1))));
+            accZ = _mm256_add_pd(accZ, _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(fz)),
+                                                     _mm256_cvtps_pd(_mm256_extractf128_ps(fz, 1))));
+        }
+
+        const __m256d bx = _mm256_set1_pd(pos.x), by = _mm256_set1_pd(pos.y), bz = _mm256_set1_pd(pos.z);
+        const __m256d eps = _mm256_set1_pd(softening);
+        const __m256i self = _mm256_set1_epi64x(slot);
+        for (size_t k = 0; k < list.nearM.size(); k += 4) {
+            const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&list.nearX[k]), bx);
+            const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&list.nearY[k]), by);
+            const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&list.nearZ[k]), bz);
+            const __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                             _mm256_add_pd(_mm256_mul_pd(dz, dz), eps));
+            __m256d sc = _mm256_div_pd(_mm256_loadu_pd(&list.nearM[k]), _mm256_mul_pd(d2, _mm256_sqrt_pd(d2)));
+            // The body's own lane may be inf or NaN without softening; clear it
+            const __m256i mine = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&list.nearSlot[k])), self);
+            sc = _mm256_andnot_pd(_mm256_castsi256_pd(mine), sc);
+            accX = _mm256_add_pd(accX, _mm256_mul_pd(dx, sc));
+            accY = _mm256_add_pd(accY, _mm256_mul_pd(dy, sc));
+            accZ = _mm256_add_pd(accZ, _mm256_mul_pd(dz, sc));
+        }
+
+        alignas(32) double sx[4], sy[4], sz[4];
+        _mm256_store_pd(sx, accX); _mm256_store_pd(sy, accY); _mm256_store_pd(sz, accZ);
+        totalAcceleration += Vector3(sx[0] + sx[1] + sx[2] + sx[3], sy[0] + sy[1] + sy[2] + sy[3],
+                                     sz[0] + sz[1] + sz[2] + sz[3]) * Constants::G;
+#else
+        const Vector3& pos = sortedPos[slot];
+        const float px = (float)(pos.x - list.center.x), py = (float)(pos.y - list.center.y),
+                    pz = (float)(pos.z - list.center.z), epsF = (float)softening;
+        Vector3 acc(0, 0, 0);
+        for (size_t k = 0; k < list.farM.size(); ++k) {
+            const float dx = list.farX[k] - px, dy = list.farY[k] - py, dz = list.farZ[k] - pz;
+            const float d2 = dx * dx + dy * dy + dz * dz + epsF;
+            const float sc = list.farM[k] / (d2 * std::sqrt(d2));
+            acc += Vector3(dx * sc, dy * sc, dz * sc);
+        }
+        for (size_t k = 0; k < list.nearM.size(); ++k) {
+            if (list.nearSlot[k] == slot) continue;
+            const Vector3 d(list.nearX[k] - pos.x, list.nearY[k] - pos.y, list.nearZ[k] - pos.z);
+            const double d2 = d.lengthSquared() + softening;
+            acc += d * (list.nearM[k] / (d2 * std::sqrt(d2)));
+        }
+        totalAcceleration += acc * Constants::G;
+#endif
+        return list.interactions;
+    }
+
+private:
+    /**
+     * @brief Bounding sphere of a leaf's current bodies (box center, farthest body).
+     */
+    void groupSphere(const OctreeNode& leaf, Vector3& center, double& radius) const {
+        if (leaf.bodyCount == 0) { center = leaf.com.position(); radius = 0.0; return; }
+        Vector3 lo = sortedPos[leaf.bodyBegin], hi = lo;
+        for (int k = leaf.bodyBegin + 1; k < leaf.bodyBegin + leaf.bodyCount; ++k) {
+            const Vector3& p = sortedPos[k];
+            lo.x = std::min(lo.x, p.x); lo.y = std::min(lo.y, p.y); lo.z = std::min(lo.z, p.z);
+            hi.x = std::max(hi.x, p.x); hi.y = std::max(hi.y, p.y); hi.z = std::max(hi.z, p.z);
+        }
+        center = (lo + hi) * 0.5;
+        radius = 0.0;
+        for (int k = leaf.bodyBegin; k < leaf.bodyBegin + leaf.bodyCount; ++k) {
+            radius = std::max(radius, (sortedPos[k] - center).length());
+        }
+    }
+
+    /**
+     * @brief Reserves the worst case for `bodyCount` bodies and commits `expectedNodes`.
+     */
+    void reserveFor(size_t bodyCount, size_t expectedNodes) {
+        size_t bound = maxNodesFor(bodyCount);
+        if (bound > pool.getReserved()) {
+            // Only between builds: a new reservation discards the old nodes
+            size_t target = std::max(bound, pool.getReserved() * 2);
+            pool.reserve(target, hugePages);
+            cells.reserve(target, hugePages);
+        }
+        size_t commit = std::min(expectedNodes, pool.getReserved());
+        pool.commit(commit);
+        cells.commit(commit);
+        stats.reservedNodes = pool.getReserved();
+        stats.committedNodes = pool.getCommitted();
+        stats.hugePages = pool.usesHugePages();
+    }
+
+    static void setCenterOfMass(OctreeNode& node, const Vector3& weighted, double m, const Vector3& fallback) {
+        Vector3 c = m > 0.0 ? weighted / m : fallback;
+        node.com = { c.x, c.y, c.z, m };
     }
 };
 
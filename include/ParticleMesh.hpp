@@ -0,0 +1,349 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "Vector3.hpp"
+#include "Constants.hpp"
+#include "FFT.hpp"
+#include "ForceProvider.hpp"
+#include "ThreadPool.hpp"
+
+namespace SolarSim {
+
+/**
+ * @brief Particle-mesh gravity solver, $O(N + M^3 \log M)$ for an $M^3$ mesh.
+ *
+ * For million-body presets (galaxy disks, debris clouds) even a tree walk per
+ * body is too slow at interactive rates. The particle-mesh method trades
+ * short-range resolution for a cost that is linear in $N$:
+ *
+ * 1. **Deposit**: cloud-in-cell (CIC) assignment of every mass onto the mesh.
+ * 2. **Solve**: the potential is the convolution of the mesh mass with the
+ *    Green's function $-G/r$, done as a product of spectra. The mesh is
+ *    zero-padded to $(2M)^3$ so the convolution is not periodic, i.e. the
+ *    domain is isolated (Hockney & Eastwood).
+ * 3. **Differentiate**: 4-point central differences of the potential give the
+ *    acceleration at every node.
+ * 4. **Interpolate**: CIC again, back to the bodies. Using the same stencil
+ *    for deposit and interpolation cancels self-forces.
+ *
+ * The mesh is fitted to the bounding box of the bodies on every call (with a
+ * four-cell margin for the stencils). Forces are accurate for separations of a
+ * few cells and above; the cell size replaces `softening` as the effective
+ * smoothing length, so this solver is meant for large diffuse systems, not
+ * for resolving planets around the Sun.
+ *
+ * Deposit and interpolation are split across the `ThreadPool` (deposit into
+ * per-part meshes, then a parallel reduction), as are the FFT line passes.
+ */
+class ParticleMeshForce final : public ForceProvider {
+public:
+    using Complex = FFT::Complex;
+
+    /**
+     * @param gridSize Mesh nodes per axis $M$; a power of two, at least 16
+     * @param pool Worker pool for deposit, FFT passes and interpolation
+     * @throws std::invalid_argument if `gridSize` is not a power of two >= 16
+     */
+    explicit ParticleMeshForce(int gridSize = 64, ThreadPool& pool = ThreadPool::shared()) : threads(pool) {
+        setGridSize(gridSize);
+    }
+
+    void computeAccelerations(const std::vector<Vector3>& positions,
+                              const std::vector<double>& masses,
+                              std::vector<Vector3>& accelerations) override {
+        const size_t n = positions.size();
+        accelerations.resize(n);
+        if (n == 0) return;
+
+        fitMesh(positions);
+        deposit(positions, masses);
+        forward(density.data(), N);
+        const size_t bins = spectrum.size();
+        threads.parallelFor(bins, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) spectrum[i] *= greens[i];
+        }, 4096);
+        inverse(potential.data(), N);
+        differentiate();
+        interpolate(positions, accelerations);
+    }
+
+    const char* getName() const override { return "Particle-Mesh"; }
+
+    /**
+     * @throws std::invalid_argument if `gridSize` is not a power of two >= 16
+     */
+    void setGridSize(int gridSize) {
+        if (gridSize < 16 || !FFT::isPowerOfTwo((size_t)gridSize)) {
+            throw std::invalid_argument("ParticleMeshForce: grid size must be a power of two >= 16");
+        }
+        if (gridSize == N) return;
+        N = gridSize;
+        P = 2 * N;
+        H = P / 2 + 1;
+        const size_t cells = (size_t)N * N * N;
+        density.assign(cells, 0.0);
+        potential.assign(cells, 0.0);
+        field.assign(cells, Vector3(0, 0, 0));
+        spectrum.assign((size_t)P * P * H, Complex(0.0, 0.0));
+        partDensity.clear();
+        computeGreens();
+    }
+    int getGridSize() const { return N; }
+
+    /**
+     * @brief Mesh spacing of the last call, in AU (the force resolution).
+     */
+    double getCellSize() const { return cellSize; }
+
+private:
+    size_t cell(int x, int y, int z) const { return ((size_t)z * N + y) * N + x; }
+
+    /**
+     * @brief Fits a cubic mesh to the bodies, leaving four cells on every side.
+     */
+    void fitMesh(const std::vector<Vector3>& positions) {
+        Vector3 lo = positions[0], hi = positions[0];
+        for (const auto& p : positions) {
+            lo.x = std::min(lo.x, p.x); lo.y = std::min(lo.y, p.y); lo.z = std::min(lo.z, p.z);
+            hi.x = std::max(hi.x, p.x); hi.y = std::max(hi.y, p.y); hi.z = std::max(hi.z, p.z);
+        }
+        double extent = std::max({hi.x - lo.x, hi.y - lo.y, hi.z - lo.z, 1e-12});
+        cellSize = extent / (N - 2 * MARGIN);
+        origin = lo - Vector3(MARGIN, MARGIN, MARGIN) * cellSize;
+    }
+
+    /**
+     * @brief Mesh coordinates of a body: cell `i` and offset `f` per axis.
+     */
+    void locate(const Vector3& p, int i[3], double f[3]) const {
+        const double inv = 1.0 / cellSize;
+        double u[3] = { (p.x - origin.x) * inv, (p.y - origin.y) * inv, (p.z - origin.z) * inv };
+        for (int a = 0; a < 3; ++a) {
+            u[a] = std::clamp(u[a], (double)MARGIN, (double)(N - MARGIN) - 1e-9);
+            i[a] = (int)u[a];
+            f[a] = u[a] - i[a];
+        }
+    }
+
+    /**
+     * @brief CIC mass assignment. Each part deposits into its own mesh; the
+     * meshes are then summed in parallel over cells.
+     */
+    void deposit(const std::vector<Vector3>& positions, const std::vector<double>& masses) {
+        const size_t cells = density.size();
+        const size_t workers = threads.getWorkerCount();
+        if (partDensity.size() != workers - 1) partDensity.assign(workers - 1, std::vector<double>(cells));
+
+        std::fill(density.begin(), density.end(), 0.0);
+        for (auto& grid : partDensity) std::fill(grid.begin(), grid.end(), 0.0);
+
+        threads.parallelFor(positions.size(), [&](size_t begin, size_t end, size_t part) {
+            double* grid = part == 0 ? density.data() : partDensity[part - 1].data();
+            for (size_t b = begin; b < end; ++b) {
+                int i[3];
+                double f[3];
+                locate(positions[b], i, f);
+                const double m = masses[b];
+                for (int dz = 0; dz < 2; ++dz) {
+                    const double wz = dz ? f[2] : 1.0 - f[2];
+                    for (int dy = 0; dy < 2; ++dy) {
+                        const double wyz = wz * (dy ? f[1] : 1.0 - f[1]);
+                        double* row = grid + cell(i[0], i[1] + dy, i[2] + dz);
+                        row[0] += m * wyz * (1.0 - f[0]);
+                        row[1] += m * wyz * f[0];
+                    }
+                }
+            }
+        }, 4096);
+
+        if (partDensity.empty()) return;
+        threads.parallelFor(cells, [&](size_t begin, size_t end, size_t) {
+            for (const auto& grid : partDensity) {
+                for (size_t c = begin; c < end; ++c) density[c] += grid[c];
+            }
+        }, 4096);
+    }
+
+    /**
+     * @brief 3D real-to-complex FFT of an `n`^3 array zero-padded to `P`^3.
+     *
+     * Rows and planes that are entirely padding transform to zero and are
+     * cleared instead of transformed.
+     */
+    void forward(const double* src, int n) {
+        const size_t plane = (size_t)P * H;
+
+        // x: real rows -> half spectra
+        threads.parallelFor(P, [&](size_t begin, size_t end, size_t) {
+            std::vector<double>& row = realLine();
+            row.assign(P, 0.0);
+            for (size_t z = begin; z < end; ++z) {
+                Complex* slab = spectrum.data() + z * plane;
+                if ((int)z >= n) { std::fill(slab, slab + plane, Complex(0.0, 0.0)); continue; }
+                for (int y = 0; y < P; ++y) {
+                    if (y >= n) { std::fill(slab + (size_t)y * H, slab + (size_t)(y + 1) * H, Complex(0.0, 0.0)); continue; }
+                    std::copy(src + ((size_t)z * n + y) * n, src + ((size_t)z * n + y + 1) * n, row.begin());
+                    FFT::realToComplex(row.data(), slab + (size_t)y * H, P);
+                }
+            }
+        }, 1);
+
+        // y: only planes that hold data
+        threads.parallelFor(n, [&](size_t begin, size_t end, size_t) {
+            for (size_t z = begin; z < end; ++z) transformLines(spectrum.data() + z * plane, H, P, H, false);
+        }, 1);
+
+        // z
+        threads.parallelFor(P, [&](size_t begin, size_t end, size_t) {
+            for (size_t y = begin; y < end; ++y) transformLines(spectrum.data() + y * H, H, P, plane, false);
+        }, 1);
+    }
+
+    /**
+     * @brief Inverse of `forward`, normalized, keeping only the `n`^3 corner.
+     */
+    void inverse(double* dst, int n) {
+        const size_t plane = (size_t)P * H;
+        const double scale = 1.0 / ((double)P * P * P);
+
+        threads.parallelFor(P, [&](size_t begin, size_t end, size_t) {
+            for (size_t y = begin; y < end; ++y) transformLines(spectrum.data() + y * H, H, P, plane, true);
+        }, 1);
+
+        threads.parallelFor(n, [&](size_t begin, size_t end, size_t) {
+            for (size_t z = begin; z < end; ++z) transformLines(spectrum.data() + z * plane, H, P, H, true);
+        }, 1);
+
+        threads.parallelFor(n, [&](size_t begin, size_t end, size_t) {
+            std::vector<double>& row = realLine();
+            row.resize(P);
+            for (size_t z = begin; z < end; ++z) {
+                for (int y = 0; y < n; ++y) {
+                    FFT::complexToReal(spectrum.data() + z * plane + (size_t)y * H, row.data(), P);
+                    double* out = dst + ((size_t)z * n + y) * n;
+                    for (int x = 0; x < n; ++x) out[x] = row[x] * scale;
+                }
+            }
+        }, 1);
+    }
+
+    /**
+     * @brief Transforms `count` lines of length `P`; line `k` starts at `base + k`
+     * and its elements are `stride` apart.
+     */
+    void transformLines(Complex* base, int count, int length, size_t stride, bool inverseDir) {
+        std::vector<Complex>& line = complexLine();
+        line.resize(length);
+        for (int k = 0; k < count; ++k) {
+            Complex* p = base + k;
+            for (int j = 0; j < length; ++j) line[j] = p[j * stride];
+            FFT::transform(line.data(), length, inverseDir);
+            for (int j = 0; j < length; ++j) p[j * stride] = line[j];
+        }
+    }
+
+    /**
+     * @brief Spectrum of the unit Green's function $-1/|d|$ on the padded mesh.
+     *
+     * Distances are in cells and wrap at $P/2$, so every pair of nodes inside
+     * the $M^3$ corner sees its true separation. The kernel is even, so its
+     * spectrum is real. Depends only on the mesh size: the physical scale
+     * $G/h$ is applied in `differentiate`. The self term uses one cell.
+     */
+    void computeGreens() {
+        std::vector<double> kernel((size_t)P * P * P);
+        for (int z = 0; z < P; ++z) {
+            const double dz = z < N ? z : z - P;
+            for (int y = 0; y < P; ++y) {
+                const double dy = y < N ? y : y - P;
+                for (int x = 0; x < P; ++x) {
+                    const double dx = x < N ? x : x - P;
+                    const double r = std::sqrt(dx * dx + dy * dy + dz * dz);
+                    kernel[((size_t)z * P + y) * P + x] = -1.0 / std::max(r, 1.0);
+                }
+            }
+        }
+        forward(kernel.data(), P);
+        greens.resize(spectrum.size());
+        for (size_t i = 0; i < spectrum.size(); ++i) greens[i] = spectrum[i].real();
+    }
+
+    /**
+     * @brief Node accelerations $a = -\nabla \phi$ from 4-point central differences.
+     *
+     * Bodies only touch nodes `MARGIN` .. `N - MARGIN`, so the stencil never
+     * leaves the mesh for any node that is read back.
+     */
+    void differentiate() {
+        const double scale = -Constants::G / (cellSize * cellSize * 12.0);
+        const size_t sx = 1, sy = N, sz = (size_t)N * N;
+        threads.parallelFor(N, [&](size_t begin, size_t end, size_t) {
+            for (size_t z = begin; z < end; ++z) {
+                for (int y = 0; y < N; ++y) {
+                    for (int x = 0; x < N; ++x) {
+                        const size_t c = cell(x, y, (int)z);
+                        if (x < 2 || y < 2 || (int)z < 2 || x >= N - 2 || y >= N - 2 || (int)z >= N - 2) {
+                            field[c] = Vector3(0, 0, 0);
+                            continue;
+                        }
+                        const double* phi = potential.data();
+                        auto d = [phi, c](size_t s) {
+                            return 8.0 * (phi[c + s] - phi[c - s]) - (phi[c + 2 * s] - phi[c - 2 * s]);
+                        };
+                        field[c] = Vector3(d(sx), d(sy), d(sz)) * scale;
+                    }
+                }
+            }
+        }, 1);
+    }
+
+    void interpolate(const std::vector<Vector3>& positions, std::vector<Vector3>& accelerations) {
+        threads.parallelFor(positions.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t b = begin; b < end; ++b) {
+                int i[3];
+                double f[3];
+                locate(positions[b], i, f);
+                Vector3 a(0, 0, 0);
+                for (int dz = 0; dz < 2; ++dz) {
+                    const double wz = dz ? f[2] : 1.0 - f[2];
+                    for (int dy = 0; dy < 2; ++dy) {
+                        const double wyz = wz * (dy ? f[1] : 1.0 - f[1]);
+                        const Vector3* row = field.data() + cell(i[0], i[1] + dy, i[2] + dz);
+                        a += row[0] * (wyz * (1.0 - f[0])) + row[1] * (wyz * f[0]);
+                    }
+                }
+                accelerations[b] = a;
+            }
+        }, 1024);
+    }
+
+    static std::vector<double>& realLine() {
+        static thread_local std::vector<double> line;
+        return line;
+    }
+
+    static std::vector<Complex>& complexLine() {
+        static thread_local std::vector<Complex> line;
+        return line;
+    }
+
+    static constexpr int MARGIN = 4; ///< Empty cells around the bodies for the stencils
+
+    ThreadPool& threads;
+    int N = 0;  ///< Mesh nodes per axis
+    int P = 0;  ///< Padded FFT length per axis (2N)
+    int H = 0;  ///< Non-redundant complex outputs per padded row (P/2 + 1)
+    double cellSize = 1.0;
+    Vector3 origin;
+    std::vector<double> density;                  ///< Mass per node (M^3)
+    std::vector<std::vector<double>> partDensity; ///< Private deposit meshes of parts 1..n
+    std::vector<double> potential;                ///< Convolution of density with the unit kernel (M^3)
+    std::vector<Vector3> field;                   ///< Node accelerations (M^3)
+    std::vector<Complex> spectrum;                ///< Half spectrum of the padded mesh (P x P x H)
+    std::vector<double> greens;                   ///< Real spectrum of the unit kernel
+};
+
+} // namespace SolarSim
@@ -7,6 +7,8 @@
 #include "Body.hpp"
 #include "Constants.hpp"
 #include "Octree.hpp"
+#include "ForceProvider.hpp"
+#include "ParticleMesh.hpp"
 
 #include <immintrin.h>
 
@@ -16,6 +18,25 @@ namespace SolarSim {
  * @brief Static physics library for gravitational calculations.
  */
 class PhysicsEngine {
+private:
+    /**
+     * @brief Reusable gather/scatter buffers so steps do not allocate.
+     *
+     * One set per precision: the gathered arrays use the force model's `RealType`.
+     */
+    template <typename Real>
+    struct ForceScratch {
+        std::vector<BasicVector3<Real>> positions;
+        std::vector<BasicVector3<Real>> accelerations;
+        std::vector<Real> masses;
+    };
+
+    template <typename Real>
+    static ForceScratch<Real>& scratch() {
+        static thread_local ForceScratch<Real> s;
+        return s;
+    }
+
 public:
     /**
      * @brief Calculates gravitational force between two bodies using Newton's Law of Universal Gravitation.
@@ -38,71 +59,39 @@ public:
     }
 
     /**
-     * @brief Calculates accelerations for all bodies with optimized cache access.
+     * @brief Calculates accelerations for all bodies using the given force provider.
      * 
-     * Optimization notes:
-     * - **Cache Locality**: Extracts position components to local variables to minimize pointer 
-     *   chasing and struct-of-arrays overhead.
-     * - **Local Accumulation**: Accumulates accelerations in registers (axi/ayi/azi) before 
-     *   writing back to memory to reduce bus contention.
-     * - **InvDist Optimization**: Computes `invDist` once and derives `invDist3` (faster than 
-     *   `pow(d, -1.5)`).
+     * Gathers positions and masses into contiguous arrays, lets the provider fill
+     * the accelerations, and scatters them back into `Body::acceleration`. The
+     * arrays are gathered in the provider's precision (`ForceModel::RealType`).
      * 
-     * @note This is an O(N^2) implementation. For large N, use Barnes-Hut.
+     * @tparam ForceModel A concrete provider (calls are devirtualized) or `ForceProvider`
+     * @param bodies Collection of celestial bodies
+     * @param force Gravity solver (direct, SIMD, threaded, Barnes-Hut, ...)
      */
-    static void calculateAccelerations(std::vector<Body>& bodies) {
-        for (auto& body : bodies) body.resetAcceleration();
-        
+    template <typename ForceModel>
+    static void calculateAccelerations(std::vector<Body>& bodies, ForceModel& force) {
+        using Real = typename ForceModel::RealType;
+        ForceScratch<Real>& s = scratch<Real>();
         const size_t n = bodies.size();
+        s.positions.resize(n);
+        s.masses.resize(n);
         for (size_t i = 0; i < n; ++i) {
-            Body& bi = bodies[i];
-            // Cache position components locally for better cache performance
-            const double xi = bi.position.x;
-            const double yi = bi.position.y;
-            const double zi = bi.position.z;
-            const double mi = bi.mass;
-            
-            // Local accumulator for acceleration
-            double axi = 0.0, ayi = 0.0, azi = 0.0;
-            
-            for (size_t j = i + 1; j < n; ++j) {
-                Body& bj = bodies[j];
-                
-                // No longer skipping moon interactions - every body should interact with every other body
-                // for correct orbital physics (e.g. Earth's Moon must still be attracted to the Sun)
-                
-                const double mj = bj.mass;
-                
-                // Compute delta components
-                const double dx = bj.position.x - xi;
-                const double dy = bj.position.y - yi;
-                const double dz = bj.position.z - zi;
-                
-                // Distance calculation with softening
-                const double distSq = dx*dx + dy*dy + dz*dz + Constants::SOFTENING_EPSILON;
-                const double invDist = 1.0 / std::sqrt(distSq);
-                const double invDist3 = invDist * invDist * invDist;
-                const double f = Constants::G * invDist3;
-                
-                // Accumulate forces (scaled by respective masses)
-                const double fx = dx * f;
-                const double fy = dy * f;
-                const double fz = dz * f;
-                
-                axi += fx * mj;
-                ayi += fy * mj;
-                azi += fz * mj;
-                
-                bj.acceleration.x -= fx * mi;
-                bj.acceleration.y -= fy * mi;
-                bj.acceleration.z -= fz * mi;
-            }
-            
-            // Write back accumulated acceleration
-            bi.acceleration.x += axi;
-            bi.acceleration.y += ayi;
-            bi.acceleration.z += azi;
+            s.positions[i] = BasicVector3<Real>(bodies[i].position);
+            s.masses[i] = Real(bodies[i].mass);
         }
+        force.computeAccelerations(s.positions, s.masses, s.accelerations);
+        for (size_t i = 0; i < n; ++i) bodies[i].acceleration = Vector3(s.accelerations[i]);
+    }
+
+    /**
+     * @brief Calculates accelerations for all bodies by direct summation.
+     * 
+     * @note This is an O(N^2) implementation (see `DirectForce`). For large N, use Barnes-Hut.
+     */
+    static void calculateAccelerations(std::vector<Body>& bodies) {
+        DirectForce direct;
+        calculateAccelerations(bodies, direct);
     }
 
     /**
@@ -139,6 +128,53 @@ public:
         }
     }
 
+    /**
+     * @brief Reports whether any two bodies overlap, without modifying them.
+     * 
+     * Sweep-and-prune along X: bodies are ordered by the lower edge of their
+     * extent $x - r$, and a pair can only touch if the later body starts before the
+     * earlier one ends. `order` persists between calls, and because bodies barely
+     * move between sub-steps an insertion sort restores it in near-linear time.
+     * 
+     * @param positions Body positions in AU
+     * @param radii Body radii in AU
+     * @param order In/out sweep order; rebuilt if its size does not match
+     * @returns True if `handleCollisions` would merge at least one pair
+     */
+    template <typename Real>
+    static bool detectCollisions(const std::vector<BasicVector3<Real>>& positions, const std::vector<Real>& radii,
+                                 std::vector<int>& order) {
+        const int n = (int)positions.size();
+        auto lower = [&](int i) { return positions[i].x - radii[i]; };
+        if ((int)order.size() != n) {
+            // Fresh order: full sort once, insertion sort only for the incremental updates
+            order.resize(n);
+            for (int i = 0; i < n; ++i) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return lower(a) < lower(b); });
+        }
+        for (int k = 1; k < n; ++k) {
+            int idx = order[k];
+            Real key = lower(idx);
+            int m = k - 1;
+            while (m >= 0 && lower(order[m]) > key) {
+                order[m + 1] = order[m];
+                --m;
+            }
+            order[m + 1] = idx;
+        }
+
+        for (int a = 0; a < n; ++a) {
+            const int i = order[a];
+            const Real upper = positions[i].x + radii[i];
+            for (int b = a + 1; b < n && lower(order[b]) <= upper; ++b) {
+                const int j = order[b];
+                Real radiusSum = radii[i] + radii[j];
+                if ((positions[j] - positions[i]).lengthSquared() < radiusSum * radiusSum) return true;
+            }
+        }
+        return false;
+    }
+
     /**
      * @brief Calculates a safe adaptive timestep based on the proximity of bodies.
      * 
@@ -184,15 +220,25 @@ public:
      * 
      * @param bodies Collection of celestial bodies
      * @param dt Timestep in years
+     * @param force Gravity solver used for $a(t+dt)$
      */
-    static void stepVerlet(std::vector<Body>& bodies, double dt) {
+    template <typename ForceModel>
+    static void stepVerlet(std::vector<Body>& bodies, double dt, ForceModel& force) {
         for (auto& b : bodies) b.velocity += b.acceleration * (dt * 0.5);
         for (auto& b : bodies) b.updatePosition(dt);
         handleCollisions(bodies);
-        calculateAccelerations(bodies);
+        calculateAccelerations(bodies, force);
         for (auto& b : bodies) b.velocity += b.acceleration * (dt * 0.5);
     }
 
+    /**
+     * @brief Velocity Verlet step with direct-summation gravity.
+     */
+    static void stepVerlet(std::vector<Body>& bodies, double dt) {
+        DirectForce direct;
+        stepVerlet(bodies, dt, direct);
+    }
+
     /**
      * @brief Integrates system state using 4th-order Runge-Kutta (RK4).
      * 
@@ -213,45 +259,44 @@ public:
      * 
      * @param bodies Collection of celestial bodies
      * @param dt Timestep in years
+     * @param force Gravity solver evaluated at each of the four stages; the stages
+     *        run in its `RealType`, the result is accumulated into the double state
      */
-    static void stepRK4(std::vector<Body>& bodies, double dt) {
+    template <typename ForceModel>
+    static void stepRK4(std::vector<Body>& bodies, double dt, ForceModel& force) {
+        using Real = typename ForceModel::RealType;
+        using Vec = BasicVector3<Real>;
+        const Real h = Real(dt), half = Real(dt * 0.5);
         size_t n = bodies.size();
-        std::vector<Vector3> kp(n), kv(n), p(n), v(n), a(n), tmp_p(n);
-        std::vector<double> m(n);
-
-        for(size_t i=0; i<n; ++i) { p[i] = bodies[i].position; v[i] = bodies[i].velocity; m[i] = bodies[i].mass; }
-
-        auto getA = [&](const std::vector<Vector3>& pos, std::vector<Vector3>& acc) {
-            for(auto& ac : acc) ac = Vector3(0,0,0);
-            for(size_t i=0; i<n; ++i) for(size_t j=i+1; j<n; ++j) {
-                // Every body should interact with every other body (including moons and the Sun)
-                
-                Vector3 r = pos[j] - pos[i];
-                double distSq = r.lengthSquared() + Constants::SOFTENING_EPSILON;
-                double invDist3 = 1.0 / (distSq * std::sqrt(distSq));
-                double f_over_r = Constants::G * invDist3;
-                Vector3 force_scaled = r * f_over_r;
-                acc[i] += force_scaled * m[j]; acc[j] -= force_scaled * m[i];
-            }
-        };
+        std::vector<Vec> p(n), v(n), tmp_p(n);
+        std::vector<Real> m(n);
 
+        for(size_t i=0; i<n; ++i) { p[i] = Vec(bodies[i].position); v[i] = Vec(bodies[i].velocity); m[i] = Real(bodies[i].mass); }
 
-        std::vector<Vector3> k1_v(n), k1_a(n), k2_v(n), k2_a(n), k3_v(n), k3_a(n), k4_v(n), k4_a(n);
+        std::vector<Vec> k1_v(n), k1_a(n), k2_v(n), k2_a(n), k3_v(n), k3_a(n), k4_v(n), k4_a(n);
 
-        getA(p, k1_a); for(size_t i=0; i<n; ++i) k1_v[i] = v[i];
-        for(size_t i=0; i<n; ++i) tmp_p[i] = p[i] + k1_v[i] * (dt*0.5);
-        getA(tmp_p, k2_a); for(size_t i=0; i<n; ++i) k2_v[i] = v[i] + k1_a[i] * (dt*0.5);
-        for(size_t i=0; i<n; ++i) tmp_p[i] = p[i] + k2_v[i] * (dt*0.5);
-        getA(tmp_p, k3_a); for(size_t i=0; i<n; ++i) k3_v[i] = v[i] + k2_a[i] * (dt*0.5);
-        for(size_t i=0; i<n; ++i) tmp_p[i] = p[i] + k3_v[i] * dt;
-        getA(tmp_p, k4_a); for(size_t i=0; i<n; ++i) k4_v[i] = v[i] + k3_a[i] * dt;
+        force.computeAccelerations(p, m, k1_a); for(size_t i=0; i<n; ++i) k1_v[i] = v[i];
+        for(size_t i=0; i<n; ++i) tmp_p[i] = p[i] + k1_v[i] * half;
+        force.computeAccelerations(tmp_p, m, k2_a); for(size_t i=0; i<n; ++i) k2_v[i] = v[i] + k1_a[i] * half;
+        for(size_t i=0; i<n; ++i) tmp_p[i] = p[i] + k2_v[i] * half;
+        force.computeAccelerations(tmp_p, m, k3_a); for(size_t i=0; i<n; ++i) k3_v[i] = v[i] + k2_a[i] * half;
+        for(size_t i=0; i<n; ++i) tmp_p[i] = p[i] + k3_v[i] * h;
+        force.computeAccelerations(tmp_p, m, k4_a); for(size_t i=0; i<n; ++i) k4_v[i] = v[i] + k3_a[i] * h;
 
         for(size_t i=0; i<n; ++i) {
-            bodies[i].position += (k1_v[i] + k2_v[i]*2.0 + k3_v[i]*2.0 + k4_v[i]) * (dt/6.0);
-            bodies[i].velocity += (k1_a[i] + k2_a[i]*2.0 + k3_a[i]*2.0 + k4_a[i]) * (dt/6.0);
+            bodies[i].position += Vector3(k1_v[i] + k2_v[i]*Real(2) + k3_v[i]*Real(2) + k4_v[i]) * (dt/6.0);
+            bodies[i].velocity += Vector3(k1_a[i] + k2_a[i]*Real(2) + k3_a[i]*Real(2) + k4_a[i]) * (dt/6.0);
         }
         handleCollisions(bodies);
-        calculateAccelerations(bodies);
+        calculateAccelerations(bodies, force);
+    }
+
+    /**
+     * @brief RK4 step with direct-summation gravity.
+     */
+    static void stepRK4(std::vector<Body>& bodies, double dt) {
+        DirectForce direct;
+        stepRK4(bodies, dt, direct);
     }
 
     /**
@@ -261,6 +306,9 @@ public:
      * partitions space into an Octree. For distant clusters of bodies, we calculate
      * the force from the cluster's center of mass rather than individual bodies.
      * 
+     * This is Velocity Verlet paired with `BarnesHutForce`; the tree is rebuilt
+     * from the drifted positions so it matches the bodies it is evaluated for.
+     * 
      * @logic
      * 1. Rebuild Octree from current body positions.
      * 2. Calculate COM (Center of Mass) and Total Mass for every node.
@@ -273,32 +321,25 @@ public:
      * @param theta Accuracy parameter ($\theta$); lower is more accurate (typically 0.5)
      */
     static void stepBarnesHut(std::vector<Body>& bodies, double dt, double theta = 0.5) {
-        static OctreePool pool;
-        pool.clear();
-
-        Vector3 minB(1e18, 1e18, 1e18), maxB(-1e18, -1e18, -1e18);
-        for (const auto& b : bodies) {
-            minB.x = std::min(minB.x, b.position.x); minB.y = std::min(minB.y, b.position.y); minB.z = std::min(minB.z, b.position.z);
-            maxB.x = std::max(maxB.x, b.position.x); maxB.y = std::max(maxB.y, b.position.y); maxB.z = std::max(maxB.z, b.position.z);
-        }
-        double s = std::max({maxB.x - minB.x, maxB.y - minB.y, maxB.z - minB.z}) * 0.5 + 0.1;
-        Vector3 mid = (minB + maxB) * 0.5;
-        
-        int rootIdx = pool.allocate(mid - Vector3(s,s,s), s * 2.0);
-        for (auto& b : bodies) pool.insert(rootIdx, &b);
-
-        for (auto& b : bodies) b.velocity += b.acceleration * (dt * 0.5);
-        for (auto& b : bodies) b.updatePosition(dt);
-        handleCollisions(bodies);
-        for (auto& b : bodies) { 
-            // Regular body: use Barnes-Hut approximation
-            // Moons are now included in the same Barnes-Hut hierarchy as planets
-            Vector3 f(0,0,0); 
-            pool.calculateForceIterative(rootIdx, &b, theta, f); 
-            b.acceleration = f / b.mass; 
-        }
-        for (auto& b : bodies) b.velocity += b.acceleration * (dt * 0.5);
+        static BarnesHutForce barnesHut;
+        barnesHut.setTheta(theta);
+        stepVerlet(bodies, dt, barnesHut);
+    }
 
+    /**
+     * @brief Performs a single Velocity Verlet step with particle-mesh gravity.
+     *
+     * For very large N (1M+ bodies), where even a tree walk per body is too
+     * slow. Forces are mesh-resolution accurate only; see `ParticleMeshForce`.
+     *
+     * @param bodies Collection of celestial bodies
+     * @param dt Timestep in years
+     * @param gridSize Mesh nodes per axis (power of two)
+     */
+    static void stepParticleMesh(std::vector<Body>& bodies, double dt, int gridSize = 64) {
+        static ParticleMeshForce particleMesh;
+        particleMesh.setGridSize(gridSize);
+        stepVerlet(bodies, dt, particleMesh);
     }
 
     /**
@@ -0,0 +1,626 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include "Body.hpp"
+#include "PhysicsEngine.hpp"
+#include "Integrators.hpp"
+#include "ParticleMesh.hpp"
+#include "SpatialOrder.hpp"
+#include "StateManager.hpp"
+#include "Checkpoint.hpp"
+#include "Trajectory.hpp"
+#include "HistoryManager.hpp"
+#include "SystemData.hpp"
+
+namespace SolarSim {
+
+/**
+ * @brief Lock-free single-writer, single-reader triple buffer.
+ *
+ * The writer fills `back()` and calls `publish()`; the reader calls `fetch()`
+ * and then reads `front()`. Each side owns one buffer and the third is parked
+ * in an atomic slot that both exchange into, so neither side ever waits for
+ * the other and the reader always gets the most recently published value.
+ * Intermediate values are dropped when the writer is faster.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /** @brief Writer side: the buffer to fill next. */
+    T& back() { return buffers[backIndex]; }
+
+    /** @brief Writer side: makes `back()` the newest value and takes a fresh back buffer. */
+    void publish() {
+        uint8_t previous = middle.exchange(uint8_t(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = previous & INDEX;
+    }
+
+    /**
+     * @brief Reader side: swaps in the newest value if one was published since the last fetch.
+     * @returns True if `front()` changed
+     */
+    bool fetch() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX;
+        return true;
+    }
+
+    /** @brief Reader side: the value obtained by the last successful `fetch()`. */
+    const T& front() const { return buffers[frontIndex]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T buffers[3];
+    uint8_t backIndex = 0;                 ///< Owned by the writer
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t frontIndex = 2;    ///< Owned by the reader
+};
+
+/**
+ * @brief Lock-free bounded single-producer, single-consumer queue.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    /** @returns False (and drops nothing) if the queue is full */
+    bool push(T item) {
+        const size_t head = writeIndex.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) % Capacity;
+        if (next == readIndex.load(std::memory_order_acquire)) return false;
+        slots[head] = std::move(item);
+        writeIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /** @returns False if the queue is empty */
+    bool pop(T& out) {
+        const size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire)) return false;
+        out = std::move(slots[tail]);
+        readIndex.store((tail + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> slots;
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+/**
+ * @brief Request from the UI to the simulation thread.
+ *
+ * The physics thread never reads the GUI's `SimulationState`; every change the
+ * user makes is sent as one of these instead.
+ */
+struct SimulationCommand {
+    enum class Type {
+        SetPaused,            ///< `option` != 0 pauses
+        SetTimeRate,          ///< `value` is the time multiplier
+        SetIntegrator,        ///< `option`: 0=Verlet, 1=RK4, 2=Barnes-Hut, 3=Particle-Mesh
+        SetSinglePrecision,   ///< `option` != 0 runs direct sums in float
+        SetOpeningCriterion,  ///< `option`: 0=Geometric, 1=Relative; `value` is the force accuracy
+        SetTheta,             ///< `value` is the Barnes-Hut opening angle
+        SetSubstepBudget,     ///< `option` caps integration sub-steps per tick (0 = unlimited)
+        ResetTime,            ///< Sets elapsed time to zero
+        LoadPreset,           ///< `option` is a `PresetType`
+        LoadState,            ///< Loads `filename` (CSV, or a `Checkpoint`, which also restores time)
+        SaveState,            ///< Saves to `filename` (a `Checkpoint` if it ends in `.ssck`)
+        StartRecording,       ///< Records every tick to trajectory `filename`; `option` is the asteroid stride
+        StopRecording,        ///< Finishes the trajectory file
+        Rewind,               ///< Goes back `value` years (as far as the history reaches)
+        ConfigureHistory      ///< `value` is the keyframe interval in years, `option` the memory budget in MiB
+    };
+
+    Type type = Type::SetPaused;
+    double value = 0.0;
+    int option = 0;
+    std::string filename;
+};
+
+/**
+ * @brief Per-body state published every tick: the part of a `Body` that changes.
+ *
+ * Velocity is included because the renderer derives orbit ellipses from it.
+ */
+struct BodyState {
+    Vector3 position;
+    Vector3 velocity;
+    double rotationAngle;
+    uint32_t id;
+};
+
+/**
+ * @brief Everything the render thread needs from one simulation tick.
+ *
+ * `states` follows the order of `catalog`. The catalog holds the static body
+ * data (names, radii, tilts) and is only replaced when the body set or its
+ * order changes (merges, reorders, loads), which bumps `generation`; copying
+ * the snapshot otherwise copies one pointer.
+ */
+struct RenderSnapshot {
+    std::vector<BodyState> states;
+    std::shared_ptr<const std::vector<Body>> catalog;
+    uint64_t generation = 0;
+    uint64_t tick = 0;          ///< Physics ticks completed
+    double elapsedYears = 0.0;
+    std::chrono::steady_clock::time_point stateTime; ///< Wall time the fixed-step clock had reached
+    double tickSeconds = 0.0;   ///< Wall time per physics tick
+    bool paused = false;
+    int integrator = 0;
+    double tickMs = 0.0;        ///< Wall time of the last tick's integration
+    bool rewinding = false;     ///< Re-integrating toward a rewind target; `elapsedYears` shows progress
+    double historyStart = 0.0;  ///< Earliest time a rewind can reach
+};
+
+/**
+ * @brief Render-thread copy of the bodies, updated from snapshots.
+ *
+ * Keeps `GraphicsEngine` and `GuiEngine` working on `std::vector<Body>` while
+ * the authoritative bodies live on the simulation thread. Trails are render
+ * data, so they are extended here from each new tick's positions (the trail
+ * heads) and carried over by id when the catalog changes.
+ *
+ * Physics ticks more slowly than the display, so `interpolate()` places the
+ * bodies between the last two ticks, one tick behind real time. Positions use
+ * the cubic Hermite curve through both states and velocities:
+ *
+ * $$p(s) = h_{00}\,p_0 + h_{10}\,\Delta t\,v_0 + h_{01}\,p_1 + h_{11}\,\Delta t\,v_1$$
+ *
+ * which follows curved orbits where a straight lerp would cut across them.
+ */
+class RenderMirror {
+public:
+    /**
+     * @param snapshot Newly fetched snapshot
+     * @param extendTrails Append the new positions to the trails
+     * @returns True if the body set or order changed (cached indices are stale)
+     */
+    bool apply(const RenderSnapshot& snapshot, bool extendTrails) {
+        bool rebuilt = false;
+        if (snapshot.generation != generation && snapshot.catalog) {
+            std::unordered_map<uint32_t, std::deque<Vector3>> trails;
+            for (auto& b : bodies) trails[b.id] = std::move(b.trail);
+            bodies = *snapshot.catalog;
+            for (auto& b : bodies) {
+                auto it = trails.find(b.id);
+                if (it != trails.end()) b.trail = std::move(it->second);
+            }
+            generation = snapshot.generation;
+            rebuilt = true;
+        }
+
+        const bool advanced = snapshot.tick != toTick;
+        if (rebuilt || advanced) {
+            // Interpolate only between states of the same bodies moving forward in time
+            const bool continuous = !rebuilt && snapshot.elapsedYears > toYears &&
+                                    to.size() == snapshot.states.size();
+            if (continuous) {
+                std::swap(from, to);
+                fromYears = toYears;
+                fromTime = toTime;
+            }
+            to = snapshot.states;
+            toYears = snapshot.elapsedYears;
+            toTime = snapshot.stateTime;
+            toTick = snapshot.tick;
+            if (!continuous) {
+                from = to;
+                fromYears = toYears;
+                fromTime = toTime;
+            }
+            delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(snapshot.tickSeconds));
+        }
+
+        const size_t n = std::min(bodies.size(), snapshot.states.size());
+        for (size_t i = 0; i < n; ++i) {
+            const BodyState& s = snapshot.states[i];
+            Body& b = bodies[i];
+            b.position = s.position;
+            b.velocity = s.velocity;
+            b.rotationAngle = s.rotationAngle;
+            if (extendTrails && advanced) b.updateTrail();
+        }
+        return rebuilt;
+    }
+
+    /**
+     * @brief Places the bodies at render time `now - tickSeconds`, between the last two ticks.
+     *
+     * Clamps to the newest tick if the physics falls behind, so motion holds
+     * still rather than extrapolating.
+     */
+    void interpolate(std::chrono::steady_clock::time_point now) {
+        const double h = toYears - fromYears;
+        double s = 1.0;
+        if (h > 0.0 && toTime > fromTime) {
+            s = std::chrono::duration<double>(now - delay - fromTime).count() /
+                std::chrono::duration<double>(toTime - fromTime).count();
+            s = std::clamp(s, 0.0, 1.0);
+        }
+        const double s2 = s * s, s3 = s2 * s;
+        const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+        const double h10 = (s3 - 2.0 * s2 + s) * h;
+        const double h01 = -2.0 * s3 + 3.0 * s2;
+        const double h11 = (s3 - s2) * h;
+
+        const size_t n = std::min(bodies.size(), std::min(from.size(), to.size()));
+        for (size_t i = 0; i < n; ++i) {
+            const BodyState& a = from[i];
+            const BodyState& c = to[i];
+            Body& b = bodies[i];
+            b.position = a.position * h00 + a.velocity * h10 + c.position * h01 + c.velocity * h11;
+            b.velocity = a.velocity + (c.velocity - a.velocity) * s;
+            double angle = std::fmod(a.rotationAngle + b.rotationSpeed * s * h, 360.0);
+            b.rotationAngle = angle < 0.0 ? angle + 360.0 : angle;
+        }
+    }
+
+    std::vector<Body> bodies;
+
+private:
+    uint64_t generation = 0;
+
+    // The two newest ticks and the wall times they belong to
+    std::vector<BodyState> from, to;
+    double fromYears = 0.0, toYears = 0.0;
+    std::chrono::steady_clock::time_point fromTime, toTime;
+    std::chrono::steady_clock::duration delay{0};
+    uint64_t toTick = 0;
+};
+
+/**
+ * @brief Runs integration on a dedicated thread with a fixed timestep.
+ *
+ * Previously physics sub-stepping ran inside the render loop, so any physics
+ * spike at a high time rate dropped the frame rate with it. Here wall time is
+ * accumulated and consumed in fixed ticks of `1 / tickRate` seconds, each
+ * advancing `yearsPerSecond * timeRate / tickRate` of simulated time, so the
+ * simulation speed no longer depends on the frame rate or its jitter. After
+ * the ticks due are run, a `RenderSnapshot` is published through a
+ * `TripleBuffer`; the render thread draws the newest one without waiting and
+ * interpolates between ticks (see `RenderMirror`), so the physics rate can sit
+ * well below the display rate. At most `MAX_CATCH_UP` ticks run per wake; any
+ * larger backlog is dropped, so an overloaded simulation slows down instead of
+ * spiralling.
+ *
+ * The thread owns the bodies and every force model. UI changes arrive through
+ * `post()`.
+ *
+ * A `HistoryManager` keyframes the state every few simulated days. A rewind
+ * restores the newest keyframe before the target and re-integrates the rest
+ * of the way with the keyframe's tick span, in slices of one tick period so
+ * snapshots keep flowing meanwhile. Force-model history is reset on restore,
+ * so rewinding to a time always yields the same state; direct-sum runs at an
+ * unchanged time rate reproduce the original run bit for bit.
+ */
+class SimulationThread {
+public:
+    static constexpr size_t COMMAND_CAPACITY = 64;
+    static constexpr int REORDER_INTERVAL = 120;   ///< Ticks between Morton reorders
+    static constexpr int MAX_CATCH_UP = 4;         ///< Ticks run per wake before the backlog is dropped
+    static constexpr double MAX_STEP = 1.0 / 365.25; ///< Largest integration sub-step (1 day)
+
+    /**
+     * @param initialBodies Starting system (barycentric, accelerations computed)
+     * @param yearsPerSecond Simulated years per wall-clock second at a time rate of 1
+     * @param tickRate Physics ticks per wall-clock second
+     */
+    SimulationThread(std::vector<Body> initialBodies, double yearsPerSecond, double tickRate = 30.0)
+        : bodies(std::move(initialBodies)), tickYears(yearsPerSecond / tickRate), tickSeconds(1.0 / tickRate),
+          tickPeriod(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(tickSeconds))),
+          barnesHutForce(0.5), particleMeshForce(64) {
+        barnesHutForce.setTreeReuse(8); // Refit between rebuilds; amortizes tree builds at high time rates
+        barnesHutForce.setSimdTraversal(true);
+        publish(std::chrono::steady_clock::now());
+    }
+
+    ~SimulationThread() { stop(); }
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start() {
+        if (worker.joinable()) return;
+        running = true;
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        running = false;
+        if (worker.joinable()) worker.join();
+        recorder.close();
+    }
+
+    /**
+     * @brief Queues a command for the next tick. Call from one thread only.
+     * @returns False if the queue is full; retry on a later frame
+     */
+    bool post(SimulationCommand command) { return commands.push(std::move(command)); }
+
+    /**
+     * @brief Reader side of the snapshot buffer. Call from one thread only.
+     */
+    TripleBuffer<RenderSnapshot>& snapshots() { return published; }
+
+    /**
+     * @brief Runs one tick synchronously (commands, integration, publish).
+     *
+     * For tests and headless use; must not be mixed with `start()`.
+     */
+    void tick() {
+        drainCommands();
+        if (rewinding) rewindStep();
+        else if (!paused && timeRate > 0.0) advanceTick(tickYears * timeRate);
+        publish(std::chrono::steady_clock::now());
+    }
+
+private:
+    void run() {
+        using Clock = std::chrono::steady_clock;
+        auto last = Clock::now();
+        Clock::duration accumulator{0};
+        while (running) {
+            auto now = Clock::now();
+            accumulator = std::min(accumulator + (now - last), tickPeriod * MAX_CATCH_UP);
+            last = now;
+
+            drainCommands();
+            if (rewinding) {
+                // Re-integrate for about one tick period, then publish the progress
+                const auto sliceEnd = Clock::now() + tickPeriod;
+                do rewindStep(); while (rewinding && Clock::now() < sliceEnd);
+                accumulator = Clock::duration{0};
+                now = Clock::now();
+                last = now;
+            }
+            while (accumulator >= tickPeriod) {
+                if (!paused && timeRate > 0.0) advanceTick(tickYears * timeRate);
+                accumulator -= tickPeriod;
+            }
+            // The state belongs to the fixed-step clock, which trails wall time by the remainder
+            publish(now - accumulator);
+            std::this_thread::sleep_until(now + (tickPeriod - accumulator));
+        }
+    }
+
+    void drainCommands() {
+        SimulationCommand c;
+        while (commands.pop(c)) {
+            switch (c.type) {
+                case SimulationCommand::Type::SetPaused: paused = c.option != 0; break;
+                case SimulationCommand::Type::SetTimeRate: timeRate = c.value; break;
+                case SimulationCommand::Type::SetIntegrator: integrator = c.option; break;
+                case SimulationCommand::Type::SetSinglePrecision: singlePrecision = c.option != 0; break;
+                case SimulationCommand::Type::SetOpeningCriterion:
+                    barnesHutForce.setOpeningCriterion(c.option == 1 ? OpeningCriterion::Relative
+                                                                     : OpeningCriterion::Geometric, c.value);
+                    break;
+                case SimulationCommand::Type::SetTheta: barnesHutForce.setTheta(c.value); break;
+                case SimulationCommand::Type::SetSubstepBudget: maxSubsteps = c.option; break;
+                case SimulationCommand::Type::ResetTime:
+                    recordEpoch += elapsedYears; // Recorded times must not run backwards
+                    elapsedYears = 0.0;
+                    history.clear();
+                    rewinding = false;
+                    break;
+                case SimulationCommand::Type::LoadPreset:
+                    replaceBodies(StateManager::loadPreset(static_cast<PresetType>(c.option)));
+                    break;
+                case SimulationCommand::Type::LoadState: loadState(c.filename); break;
+                case SimulationCommand::Type::SaveState: saveState(c.filename); break;
+                case SimulationCommand::Type::StartRecording:
+                    recorder.open(c.filename, bodies, TrajectoryWriter::stridesByKind(bodies, (uint32_t)std::max(c.option, 1)));
+                    recordEpoch = 0.0;
+                    break;
+                case SimulationCommand::Type::StopRecording: recorder.close(); break;
+                case SimulationCommand::Type::Rewind: rewind(elapsedYears - c.value); break;
+                case SimulationCommand::Type::ConfigureHistory:
+                    if (c.value > 0.0) history.setInterval(c.value);
+                    if (c.option > 0) history.setBudget((size_t)c.option << 20);
+                    break;
+            }
+        }
+    }
+
+    void replaceBodies(std::vector<Body> loaded) {
+        if (loaded.empty()) return;
+        recorder.close(); // The recording's catalog ends with the old system
+        bodies = std::move(loaded);
+        convertToBarycentric(bodies);
+        PhysicsEngine::calculateAccelerations(bodies);
+        elapsedYears = 0.0;
+        history.clear();
+        rewinding = false;
+        catalogDirty = true;
+    }
+
+    void loadState(const std::string& filename) {
+        if (!Checkpoint::isCheckpoint(filename)) {
+            replaceBodies(StateManager::loadState(filename));
+            return;
+        }
+        // Checkpoints restore the exact state, so skip the barycentric fix-up
+        std::vector<Body> loaded;
+        CheckpointMeta meta;
+        if (!loadCheckpoint(filename, loaded, meta) || loaded.empty()) return;
+        recorder.close();
+        bodies = std::move(loaded);
+        elapsedYears = meta.elapsedYears;
+        history.clear();
+        rewinding = false;
+        catalogDirty = true;
+    }
+
+    /**
+     * @brief Restores the newest keyframe at or before `target` (else the oldest) and
+     *        starts re-integrating toward `target`.
+     */
+    void rewind(double target) {
+        if (history.empty()) return;
+        const Keyframe* k = history.findBefore(target);
+        if (!k) {
+            k = &history[0];
+            target = k->elapsedYears;
+        }
+        recorder.close(); // Its times would run backwards
+        HistoryManager::restore(*k, bodies);
+        elapsedYears = k->elapsedYears;
+        ticks = k->tick;
+        ticksSinceReorder = (int)(ticks % REORDER_INTERVAL);
+        rewindSpan = k->tickYears > 0.0 ? k->tickYears : tickYears;
+        rewindTarget = target;
+        history.discardAfter(elapsedYears);
+        barnesHutForce.resetHistory();
+        rewinding = elapsedYears < rewindTarget;
+        catalogDirty = true;
+    }
+
+    void rewindStep() {
+        // Full ticks as long as they fit, so the original run's time sums repeat exactly
+        advanceTick(elapsedYears + rewindSpan <= rewindTarget ? rewindSpan : rewindTarget - elapsedYears);
+        // Stop short of a sliver tick left by rounding
+        if (!(rewindTarget - elapsedYears > rewindSpan * 1e-9)) rewinding = false;
+    }
+
+    void saveState(const std::string& filename) {
+        if (!Checkpoint::hasExtension(filename)) {
+            StateManager::saveState(bodies, filename);
+            return;
+        }
+        CheckpointMeta meta;
+        meta.elapsedYears = elapsedYears;
+        meta.tick = ticks;
+        meta.config.integrator = integrator;
+        meta.config.singlePrecision = singlePrecision;
+        meta.config.openingCriterion = barnesHutForce.getOpeningCriterion() == OpeningCriterion::Relative;
+        meta.config.gridSize = particleMeshForce.getGridSize();
+        meta.config.maxSubsteps = maxSubsteps;
+        meta.config.theta = barnesHutForce.getTheta();
+        meta.config.forceAccuracy = barnesHutForce.getForceAccuracy();
+        meta.config.maxStep = MAX_STEP;
+        Checkpoint::save(bodies, meta, filename);
+    }
+
+    void advanceTick(double span) {
+        auto start = std::chrono::steady_clock::now();
+        if (history.isDue(elapsedYears)) history.capture(bodies, elapsedYears, ticks, span);
+        const size_t countBefore = bodies.size();
+        double adt = PhysicsEngine::getAdaptiveTimestep(bodies, MAX_STEP);
+        if (maxSubsteps > 0) adt = std::max(adt, span / maxSubsteps); // Budget beats accuracy under load
+
+        // Integrator is dispatched once per tick; advance() runs all sub-steps
+        switch (integrator) {
+            case 0:
+                if (singlePrecision) advance<VerletIntegrator>(bodies, directForceF, span, adt);
+                else advance<VerletIntegrator>(bodies, directForce, span, adt);
+                break;
+            case 1:
+                if (singlePrecision) advance<RK4Integrator>(bodies, directForceF, span, adt);
+                else advance<RK4Integrator>(bodies, directForce, span, adt);
+                break;
+            case 2: advance<VerletIntegrator>(bodies, barnesHutForce, span, adt); break;
+            case 3: advance<VerletIntegrator>(bodies, particleMeshForce, span, adt); break;
+        }
+        elapsedYears += span;
+        if (bodies.size() != countBefore) catalogDirty = true; // Merged
+
+        // Restore spatial locality for the collision sweep every few seconds; bodies drift apart
+        // along their orbits. Barnes-Hut orders its own copy, so it keeps its reused tree instead.
+        if (++ticksSinceReorder >= REORDER_INTERVAL) {
+            ticksSinceReorder = 0;
+            if (integrator != 2 && bodies.size() >= MORTON_REORDER_MIN_BODIES && reorderBodiesMorton(bodies, bodyRemap)) {
+                remapIntegrationCaches(bodyRemap);
+                barnesHutForce.remapBodies(bodyRemap);
+                catalogDirty = true;
+            }
+        }
+        if (recorder.isOpen()) recorder.record(bodies, recordEpoch + elapsedYears);
+        tickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ++ticks;
+    }
+
+    void publish(std::chrono::steady_clock::time_point stateTime) {
+        if (catalogDirty || !currentCatalog) {
+            auto catalog = std::make_shared<std::vector<Body>>(bodies);
+            for (auto& b : *catalog) b.trail.clear();
+            currentCatalog = std::move(catalog);
+            ++generation;
+            catalogDirty = false;
+        }
+
+        RenderSnapshot& s = published.back();
+        s.catalog = currentCatalog;
+        s.generation = generation;
+        s.states.resize(bodies.size());
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            s.states[i] = { bodies[i].position, bodies[i].velocity, bodies[i].rotationAngle, bodies[i].id };
+        }
+        s.tick = ticks;
+        s.elapsedYears = elapsedYears;
+        s.stateTime = stateTime;
+        s.tickSeconds = tickSeconds;
+        s.paused = paused;
+        s.integrator = integrator;
+        s.tickMs = tickMs;
+        s.rewinding = rewinding;
+        s.historyStart = history.getOldestTime();
+        published.publish();
+    }
+
+    std::vector<Body> bodies;
+    const double tickYears;   ///< Simulated years per tick at a time rate of 1
+    const double tickSeconds;
+    const std::chrono::steady_clock::duration tickPeriod;
+
+    // Gravity solvers, paired with an integrator once per tick
+    DirectForce directForce;
+    DirectSimdForceF directForceF; // Single-precision path for belt-scale runs
+    BarnesHutForce barnesHutForce;
+    ParticleMeshForce particleMeshForce;
+
+    // Settings, changed only through commands
+    bool paused = false;
+    double timeRate = 1.0;
+    int integrator = 2;
+    bool singlePrecision = false;
+    int maxSubsteps = 0;
+
+    double elapsedYears = 0.0;
+    double tickMs = 0.0;
+    uint64_t ticks = 0;
+    int ticksSinceReorder = 0;
+    std::vector<int> bodyRemap;
+    TrajectoryWriter recorder;
+    double recordEpoch = 0.0; ///< Clock resets during the recording, so its times keep increasing
+    HistoryManager history;
+    bool rewinding = false;
+    double rewindTarget = 0.0;
+    double rewindSpan = 0.0;  ///< Tick span of the restored keyframe
+
+    std::shared_ptr<const std::vector<Body>> currentCatalog;
+    uint64_t generation = 0;
+    bool catalogDirty = false;
+
+    SpscQueue<SimulationCommand, COMMAND_CAPACITY> commands;
+    TripleBuffer<RenderSnapshot> published;
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+} // namespace SolarSim
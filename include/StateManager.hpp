@@ -5,8 +5,16 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "Body.hpp"
 #include "EphemerisLoader.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
 
 namespace SolarSim {
 
@@ -38,12 +46,18 @@ public:
      * - `px/py/pz`: Position in AU (Barycentric)
      * - `vx/vy/vz`: Velocity in AU/Year
      * 
+     * Numbers are written by `std::to_chars` in their shortest round-trip
+     * form, so loading the file gives back the same doubles (standard
+     * libraries without floating-point `to_chars`, such as libstdc++ before
+     * 11 or libc++ before 20, fall back to `%.17g`, which also round-trips).
+     * Blocks of rows are formatted in parallel and written in order.
+     * 
      * @param bodies Current body vector
      * @param filename Output filename
      * @return True if save succeeded
      */
     static bool saveState(const std::vector<Body>& bodies, const std::string& filename) {
-        std::ofstream file(filename);
+        std::ofstream file(filename, std::ios::binary);
         if (!file.is_open()) {
             std::cerr << "Failed to open file for saving: " << filename << std::endl;
             return false;
@@ -52,67 +66,92 @@ public:
         // Header
         file << "name,mass,radius,px,py,pz,vx,vy,vz,rotAngle,rotSpeed,axialTilt\n";
 
-        // Write each body
-        for (const auto& body : bodies) {
-            file << body.name << ","
-                 << body.mass << ","
-                 << body.radius << ","
-                 << body.position.x << "," << body.position.y << "," << body.position.z << ","
-                 << body.velocity.x << "," << body.velocity.y << "," << body.velocity.z << ","
-                 << body.rotationAngle << "," << body.rotationSpeed << "," << body.axialTilt << "\n";
+        // One round formats a block per worker; memory stays bounded for any row count
+        ThreadPool& pool = ThreadPool::shared();
+        std::vector<std::string> blocks(pool.getWorkerCount());
+        const size_t roundRows = CSV_BLOCK_ROWS * blocks.size();
+        for (size_t first = 0; first < bodies.size(); first += roundRows) {
+            const size_t last = std::min(bodies.size(), first + roundRows);
+            const size_t count = (last - first + CSV_BLOCK_ROWS - 1) / CSV_BLOCK_ROWS;
+            pool.run(count, [&](size_t b) {
+                formatRows(bodies, first + b * CSV_BLOCK_ROWS, std::min(last, first + (b + 1) * CSV_BLOCK_ROWS), blocks[b]);
+            });
+            for (size_t b = 0; b < count; ++b) file.write(blocks[b].data(), (std::streamsize)blocks[b].size());
         }
 
         file.close();
+        if (!file) {
+            std::cerr << "Failed to write state: " << filename << std::endl;
+            return false;
+        }
         std::cout << "Saved simulation state to: " << filename << std::endl;
         return true;
     }
 
     /**
      * @brief Loads simulation state from a CSV file.
+     * 
+     * @details
+     * The file is memory-mapped and cut into line-aligned chunks, which are
+     * parsed in parallel with `std::from_chars`, or `strtod` where the
+     * library lacks it (no per-line strings or streams); bodies are then
+     * created in file order. Fields may carry
+     * surrounding blanks and lines may end in CRLF; columns past the twelfth
+     * are ignored. Lines with fewer fields or a malformed number are skipped
+     * with a warning.
+     * 
      * @param filename Input filename
      * @return Vector of bodies (empty if load failed)
      */
     static std::vector<Body> loadState(const std::string& filename) {
         std::vector<Body> bodies;
-        std::ifstream file(filename);
-        if (!file.is_open()) {
+        MappedFile file;
+        if (!file.open(filename)) {
             std::cerr << "Failed to open file for loading: " << filename << std::endl;
             return bodies;
         }
+        const char* text = reinterpret_cast<const char*>(file.data());
+        const char* end = text + file.size();
+        const char* rows = std::find(text, end, '\n'); // Skip header
+        rows = rows == end ? end : rows + 1;
 
-        std::string line;
-        std::getline(file, line); // Skip header
+        ThreadPool& pool = ThreadPool::shared();
+        const size_t bytes = (size_t)(end - rows);
+        const size_t chunkCount = std::max<size_t>(1, std::min(bytes / CSV_CHUNK_BYTES, pool.getWorkerCount() * 4));
+        std::vector<const char*> cuts(chunkCount + 1, end);
+        cuts[0] = rows;
+        for (size_t k = 1; k < chunkCount; ++k) {
+            const char* p = std::find(std::max(rows + bytes * k / chunkCount, cuts[k - 1]), end, '\n');
+            cuts[k] = p == end ? end : p + 1;
+        }
+        std::vector<CsvChunk> chunks(chunkCount);
+        pool.run(chunkCount, [&](size_t k) { parseChunk(cuts[k], cuts[k + 1], text, chunks[k]); });
 
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
-            std::string token;
-            std::vector<std::string> tokens;
-            
-            while (std::getline(ss, token, ',')) {
-                tokens.push_back(token);
+        size_t total = 0;
+        for (const CsvChunk& c : chunks) total += c.rows.size();
+        bodies.reserve(total);
+        size_t line = 2, reported = 0, malformed = 0;
+        for (const CsvChunk& c : chunks) {
+            for (const CsvRow& r : c.rows) {
+                Body& body = bodies.emplace_back(std::string(text + r.name, r.nameLength), r.values[0], r.values[1],
+                                                 Vector3(r.values[2], r.values[3], r.values[4]),
+                                                 Vector3(r.values[5], r.values[6], r.values[7]));
+                body.rotationAngle = r.values[8];
+                body.rotationSpeed = r.values[9];
+                body.axialTilt = r.values[10];
             }
-
-            if (tokens.size() >= 12) {
-                try {
-                    Body body(
-                        tokens[0],                           // name
-                        std::stod(tokens[1]),                // mass
-                        std::stod(tokens[2]),                // radius
-                        Vector3(std::stod(tokens[3]), std::stod(tokens[4]), std::stod(tokens[5])),  // position
-                        Vector3(std::stod(tokens[6]), std::stod(tokens[7]), std::stod(tokens[8]))   // velocity
-                    );
-                    body.rotationAngle = std::stod(tokens[9]);
-                    body.rotationSpeed = std::stod(tokens[10]);
-                    body.axialTilt = std::stod(tokens[11]);
-                    bodies.push_back(body);
-                } catch (const std::exception& e) {
-                    std::cerr << "Warning: Skipping malformed line in " << filename 
-                              << ": " << e.what() << std::endl;
+            for (size_t bad : c.malformed) {
+                if (reported++ < MAX_REPORTED_LINES) {
+                    std::cerr << "Warning: Skipping malformed line " << line + bad << " in " << filename << std::endl;
                 }
             }
+            malformed += c.malformed.size();
+            line += c.lines;
+        }
+        if (malformed > MAX_REPORTED_LINES) {
+            std::cerr << "Warning: Skipped " << malformed << " malformed lines in " << filename << std::endl;
         }
 
-        file.close();
         std::cout << "Loaded " << bodies.size() << " bodies from: " << filename << std::endl;
         return bodies;
     }
@@ -210,6 +249,96 @@ public:
             default: return "Unknown";
         }
     }
+
+private:
+    static constexpr size_t CSV_VALUES = 11;             ///< Numeric columns after the name
+    static constexpr size_t CSV_BLOCK_ROWS = 16384;      ///< Rows formatted per task
+    static constexpr size_t CSV_CHUNK_BYTES = 1 << 20;   ///< Smallest chunk worth a parse task
+    static constexpr size_t MAX_REPORTED_LINES = 10;
+
+    struct CsvRow {
+        size_t name;        ///< Offset of the name in the file
+        size_t nameLength;
+        double values[CSV_VALUES];
+    };
+
+    struct CsvChunk {
+        std::vector<CsvRow> rows;
+        std::vector<size_t> malformed; ///< Line indices within the chunk
+        size_t lines = 0;
+    };
+
+    static void formatRows(const std::vector<Body>& bodies, size_t first, size_t last, std::string& out) {
+        out.clear();
+        out.reserve((last - first) * 256);
+        char number[32]; // Shortest round-trip doubles take at most 24 characters
+        for (size_t i = first; i < last; ++i) {
+            const Body& b = bodies[i];
+            const double values[CSV_VALUES] = {
+                b.mass, b.radius, b.position.x, b.position.y, b.position.z, b.velocity.x, b.velocity.y, b.velocity.z,
+                b.rotationAngle, b.rotationSpeed, b.axialTilt
+            };
+            out += b.name;
+            for (double v : values) {
+                out += ',';
+#if defined(__cpp_lib_to_chars)
+                out.append(number, std::to_chars(number, number + sizeof(number), v).ptr);
+#else
+                out.append(number, (size_t)std::snprintf(number, sizeof(number), "%.17g", v));
+#endif
+            }
+            out += '\n';
+        }
+    }
+
+    /** @brief Parses one number, allowing surrounding blanks and a leading '+'. */
+    static bool parseNumber(const char* first, const char* last, double& value) {
+        while (first < last && (*first == ' ' || *first == '\t')) ++first;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t')) --last;
+        if (first < last && *first == '+') ++first;
+#if defined(__cpp_lib_to_chars)
+        const std::from_chars_result r = std::from_chars(first, last, value);
+        return r.ec == std::errc() && r.ptr == last;
+#else
+        // No floating-point from_chars: strtod on a terminated copy of the field
+        char field[64];
+        const size_t length = (size_t)(last - first);
+        if (length == 0 || length >= sizeof(field)) return false;
+        std::memcpy(field, first, length);
+        field[length] = '\0';
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtod(field, &end);
+        return end == field + length && errno != ERANGE;
+#endif
+    }
+
+    static void parseChunk(const char* p, const char* end, const char* text, CsvChunk& out) {
+        out.rows.reserve((size_t)(end - p) / 128);
+        for (; p < end; ++out.lines) {
+            const char* lineEnd = std::find(p, end, '\n');
+            const char* next = lineEnd == end ? end : lineEnd + 1;
+            if (lineEnd > p && lineEnd[-1] == '\r') --lineEnd;
+            if (p == lineEnd) {
+                p = next;
+                continue;
+            }
+
+            CsvRow row;
+            const char* field = std::find(p, lineEnd, ',');
+            row.name = (size_t)(p - text);
+            row.nameLength = (size_t)(field - p);
+            bool ok = field != lineEnd;
+            for (size_t c = 0; ok && c < CSV_VALUES; ++c) {
+                const char* first = field + 1;
+                field = std::find(first, lineEnd, ',');
+                ok = (field != lineEnd || c + 1 == CSV_VALUES) && parseNumber(first, field, row.values[c]);
+            }
+            if (ok) out.rows.push_back(row);
+            else out.malformed.push_back(out.lines);
+            p = next;
+        }
+    }
 };
 
 } // namespace SolarSim
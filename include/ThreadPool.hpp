@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+namespace SolarSim {
+
+/**
+ * @brief Persistent worker pool for data-parallel physics kernels.
+ *
+ * Spawning `std::thread`s inside a sub-step costs tens of microseconds per thread,
+ * which is more than a whole direct-sum step for a few hundred bodies. The pool
+ * keeps its workers parked on a condition variable and hands out coarse tasks.
+ * The calling thread participates as well, so a pool of size 1 runs inline.
+ *
+ * @note Jobs must not call back into the same pool. Concurrent callers from
+ * different threads are serialized.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Range job signature: `(begin, end, partIndex)`.
+     *
+     * `partIndex` is unique per range within one call, so kernels can use it to
+     * index per-part scratch buffers without locking.
+     */
+    using RangeJob = std::function<void(size_t, size_t, size_t)>;
+
+    explicit ThreadPool(size_t threadCount = 0) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        workerCount = threadCount;
+        for (size_t i = 1; i < workerCount; ++i) {
+            threads.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Process-wide pool sized to the hardware concurrency.
+     */
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    size_t getWorkerCount() const { return workerCount; }
+
+    /**
+     * @brief Runs `task(i)` for every `i` in `[0, taskCount)` and blocks until all finish.
+     */
+    void run(size_t taskCount, const std::function<void(size_t)>& task) {
+        if (taskCount == 0) return;
+        if (taskCount == 1 || workerCount == 1) {
+            for (size_t i = 0; i < taskCount; ++i) task(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> callLock(callMutex);
+        std::unique_lock<std::mutex> lock(mutex);
+        job = &task;
+        jobCount = taskCount;
+        nextTask = 0;
+        pending = taskCount;
+        lock.unlock();
+        wake.notify_all();
+
+        // The caller drains tasks too instead of idling
+        lock.lock();
+        while (nextTask < jobCount) {
+            size_t t = nextTask++;
+            lock.unlock();
+            task(t);
+            lock.lock();
+            --pending;
+        }
+        done.wait(lock, [this] { return pending == 0; });
+        job = nullptr;
+    }
+
+    /**
+     * @brief Splits `[0, count)` into equal contiguous ranges, one per worker.
+     * @param minGrain Smallest range worth a task; small inputs run on fewer workers
+     */
+    void parallelFor(size_t count, const RangeJob& rangeJob, size_t minGrain = 64) {
+        if (count == 0) return;
+        size_t parts = std::min(workerCount, std::max<size_t>(1, count / std::max<size_t>(1, minGrain)));
+        run(parts, [&](size_t part) {
+            size_t begin = count * part / parts;
+            size_t end = count * (part + 1) / parts;
+            rangeJob(begin, end, part);
+        });
+    }
+
+    /**
+     * @brief Runs one task per caller-supplied range `[bounds[k], bounds[k+1])`.
+     *
+     * Used when ranges are not equal in size, e.g. cost-balanced zones.
+     */
+    void parallelForRanges(const std::vector<size_t>& bounds, const RangeJob& rangeJob) {
+        if (bounds.size() < 2) return;
+        run(bounds.size() - 1, [&](size_t part) {
+            rangeJob(bounds[part], bounds[part + 1], part);
+        });
+    }
+
+private:
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || (job && nextTask < jobCount); });
+            if (stopping) return;
+            size_t t = nextTask++;
+            const std::function<void(size_t)>* fn = job;
+            lock.unlock();
+            (*fn)(t);
+            lock.lock();
+            if (--pending == 0) done.notify_all();
+        }
+    }
+
+    size_t workerCount = 1;
+    std::vector<std::thread> threads;
+    std::mutex callMutex;  ///< Serializes concurrent `run` callers
+    std::mutex mutex;      ///< Guards the job fields below
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    size_t nextTask = 0;
+    size_t pending = 0;
+    bool stopping = false;
+};
+
+} // namespace SolarSim
@@ -0,0 +1,1363 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+#include "Body.hpp"
+#include "Checkpoint.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace SolarSim {
+
+/**
+ * @brief On-disk layout of a trajectory recording (`.sstraj`).
+ *
+ * | Part | Content |
+ * |------|---------|
+ * | Header | Magic, version, byte-order mark, body count, chunk size, catalog table |
+ * | Catalog | Per-body stride, mass, radius and name |
+ * | Chunks | `ChunkHeader`, then one block per field: times, then x/y/z positions and velocities |
+ * | Index | One `IndexEntry` per chunk: time range, first frame, file range |
+ * | Trailer | Index offset, chunk and frame counts, index magic (last 32 bytes) |
+ *
+ * A frame is one snapshot in time. Body `s` of the catalog appears in frame
+ * `f` if `recorded(stride[s], f)`, so planets can be stored every frame and
+ * asteroids every Nth. Within a chunk each field block holds the samples of
+ * all its frames in order, each frame listing its recorded bodies in catalog
+ * order; the sample layout is implied by the strides and never stored.
+ * Bodies merged away after the recording started are written as `MISSING`.
+ *
+ * Blocks start on 64-byte boundaries and carry a codec id (see
+ * `TrajectoryCodec`), so a chunk can be mapped and decoded on its own; the
+ * index at the end finds the chunk for a given time without scanning the file.
+ */
+struct TrajectoryFormat {
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t ALIGNMENT = Checkpoint::ALIGNMENT;
+    static constexpr const char* EXTENSION = ".sstraj";
+
+    enum CatalogColumn : uint32_t { Strides, Masses, Radii, NameOffsets, Names, CATALOG_COUNT };
+    enum Field : uint32_t { Times, PositionX, PositionY, PositionZ, VelocityX, VelocityY, VelocityZ, FIELD_COUNT };
+    enum Codec : uint32_t { Raw = 0, Predictive = 1, Quantized = 2 }; ///< See `TrajectoryCodec`
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t bodyCount;
+        uint32_t framesPerChunk;
+        uint32_t reserved;
+        Checkpoint::ColumnEntry catalog[CATALOG_COUNT];
+    };
+
+    struct Block {
+        uint64_t offset;    ///< From the start of the chunk
+        uint64_t bytes;     ///< Stored (encoded) size
+        uint64_t values;    ///< Decoded number of doubles
+        double quantum;     ///< Grid spacing of a `Quantized` block, else 0
+        uint32_t codec;
+        uint32_t reserved;
+    };
+
+    struct ChunkHeader {
+        char magic[8];
+        uint64_t firstFrame;
+        uint64_t sampleCount; ///< Values per position/velocity block
+        uint32_t frameCount;
+        uint32_t reserved;
+        Block blocks[FIELD_COUNT];
+    };
+
+    struct IndexEntry {
+        double firstTime;
+        double lastTime;
+        uint64_t firstFrame;
+        uint64_t offset;
+        uint64_t bytes;
+        uint32_t frameCount;
+        uint32_t reserved;
+    };
+
+    struct Trailer {
+        uint64_t indexOffset;
+        uint64_t chunkCount;
+        uint64_t frameCount;
+        char magic[8];
+    };
+
+    static_assert(std::is_trivially_copyable<Header>::value && std::is_trivially_copyable<ChunkHeader>::value &&
+                  std::is_trivially_copyable<IndexEntry>::value && std::is_trivially_copyable<Trailer>::value,
+                  "Trajectory records are written as raw bytes");
+
+    static constexpr char MAGIC[8] = { 'S', 'S', 'I', 'M', 'T', 'R', 'A', 'J' };
+    static constexpr char CHUNK_MAGIC[8] = { 'S', 'S', 'I', 'M', 'C', 'H', 'N', 'K' };
+    static constexpr char INDEX_MAGIC[8] = { 'S', 'S', 'I', 'M', 'T', 'I', 'D', 'X' };
+
+    /** @brief Placeholder for a body that no longer exists (quiet NaN). */
+    static constexpr double MISSING = std::numeric_limits<double>::quiet_NaN();
+
+    /** @brief NaN test on the bit pattern; `std::isnan` is unreliable under -ffast-math. */
+    static bool isMissing(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull && (bits & 0x000FFFFFFFFFFFFFull) != 0;
+    }
+
+    /** @returns True if a body with `stride` is stored in frame `frame` (stride 0 = never) */
+    static bool recorded(uint32_t stride, uint64_t frame) { return stride != 0 && frame % stride == 0; }
+};
+
+/**
+ * @brief Smoothness-exploiting coder for trajectory chunks.
+ *
+ * Orbits are smooth, so each sample is predicted from the same body's
+ * earlier samples in the chunk and only the difference is stored:
+ *
+ * - Position and velocity: extrapolation of the polynomial through the
+ *   body's last six samples. Early in a chunk the order drops; a position
+ *   with a single earlier sample is predicted as $x + v\,\Delta t$
+ * - Time: linear extrapolation of the two previous times
+ *
+ * (Positions are not integrated from the stored velocities: the integrators
+ * do not make them consistent beyond second order, while each column on its
+ * own is as smooth as the orbit.)
+ *
+ * `Predictive` XORs the bits of the value and its prediction (as in Gorilla
+ * and FPC): a good prediction shares sign, exponent and leading mantissa bits,
+ * leaving a small integer. `Quantized` rounds to a grid of `2 * tolerance`
+ * instead and codes the difference of grid indices, so the reconstruction is
+ * within `tolerance` of the original (plus a rounding error of the value's
+ * magnitude times 2^-53). Both bit-pack each residual into 64-bit words as
+ * its significant bits, preceded by a 6-bit width unless the previous width
+ * (the Gorilla "window") still fits.
+ *
+ * Predictions are computed from reconstructed values on both sides, through
+ * the same functions, so encoder and decoder stay in lockstep. A body's
+ * prediction reads only its own history within the chunk, so each chunk, and
+ * each axis of it, codes independently; the three axes run in parallel.
+ *
+ * Lockstep has to hold to the last bit, also between the program that wrote
+ * a file and another build that reads it: one differing prediction silently
+ * corrupts every later sample of a lossless block. Under `-ffast-math` /
+ * `/fp:fast` the compiler may reassociate, vectorize or FMA-contract the
+ * same expression differently at each call site, so the codec is compiled
+ * with precise, uncontracted IEEE arithmetic, which fixes every prediction
+ * by the source alone.
+ */
+#if defined(__clang__)
+#pragma float_control(precise, on, push)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("no-fast-math", "fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma float_control(precise, on, push)
+#pragma fp_contract(off)
+#endif
+class TrajectoryCodec {
+public:
+    struct Settings {
+        uint32_t codec = TrajectoryFormat::Predictive;
+        double positionTolerance = 0.0; ///< Largest position error in AU (`Quantized` only)
+        double velocityTolerance = 0.0; ///< Largest velocity error in AU/yr (`Quantized` only)
+    };
+
+    /**
+     * @brief Sample order of a chunk, derived from the per-body strides.
+     */
+    struct Layout {
+        std::vector<int64_t> previous; ///< Same body's previous sample in the chunk, -1 if none
+        std::vector<uint32_t> frame;   ///< Frame of each sample within the chunk
+        std::vector<uint32_t> slot;    ///< Catalog slot of each sample
+
+        void build(const uint32_t* strides, size_t bodyCount, uint64_t firstFrame, uint32_t frameCount) {
+            previous.clear();
+            frame.clear();
+            slot.clear();
+            last.assign(bodyCount, -1);
+            for (uint32_t f = 0; f < frameCount; ++f) {
+                for (size_t s = 0; s < bodyCount; ++s) {
+                    if (!TrajectoryFormat::recorded(strides[s], firstFrame + f)) continue;
+                    previous.push_back(last[s]);
+                    last[s] = (int64_t)frame.size();
+                    frame.push_back(f);
+                    slot.push_back((uint32_t)s);
+                }
+            }
+        }
+
+        size_t size() const { return frame.size(); }
+
+    private:
+        std::vector<int64_t> last;
+    };
+
+    /** @brief Decoded chunk: times and one column per position/velocity component. */
+    struct ChunkData {
+        uint64_t firstFrame = 0;
+        std::vector<double> times;
+        std::vector<double> columns[TrajectoryFormat::FIELD_COUNT - 1];
+    };
+
+    /** @brief One coded block. */
+    struct Encoded {
+        std::vector<uint64_t> words;
+        uint64_t values = 0;
+        double quantum = 0.0;
+        uint32_t codec = TrajectoryFormat::Raw;
+    };
+
+    /** @brief Times are always lossless: `Raw` if `codec` is, else `Predictive`. */
+    static void encodeTimes(const std::vector<double>& times, uint32_t codec, Encoded& out) {
+        if (codec == TrajectoryFormat::Raw) {
+            start(out, times.size(), TrajectoryFormat::Raw, 0.0);
+            out.words.resize(times.size());
+            std::memcpy(out.words.data(), times.data(), times.size() * sizeof(double));
+            return;
+        }
+        start(out, times.size(), TrajectoryFormat::Predictive, 0.0);
+        BitWriter bits(out.words);
+        int window = 0;
+        for (size_t i = 0; i < times.size(); ++i) putWord(bits, toBits(times[i]) ^ toBits(predictTime(times.data(), i)), window);
+        bits.flush();
+    }
+
+    /**
+     * @brief Codes one axis: velocity component `vel` first, then position component `pos`.
+     */
+    static void encodeAxis(const std::vector<double>& pos, const std::vector<double>& vel, const std::vector<double>& times,
+                           const Layout& layout, const Settings& settings, Encoded& posOut, Encoded& velOut,
+                           std::vector<double>& scratch) {
+        // Velocity reconstruction first: the position predictor reads it
+        const double* velRecon = encodeColumn(vel, nullptr, times, layout, settings.codec, settings.velocityTolerance, velOut, scratch);
+        std::vector<double> positions;
+        encodeColumn(pos, velRecon, times, layout, settings.codec, settings.positionTolerance, posOut, positions);
+    }
+
+    /**
+     * @brief Encodes a whole chunk; the three axes run on `pool`.
+     * @param blocks Receives `FIELD_COUNT` blocks in `TrajectoryFormat::Field` order
+     */
+    static void encodeChunk(const ChunkData& chunk, const Layout& layout, const Settings& settings,
+                            Encoded (&blocks)[TrajectoryFormat::FIELD_COUNT], ThreadPool& pool) {
+        using F = TrajectoryFormat;
+        encodeTimes(chunk.times, settings.codec, blocks[F::Times]);
+        pool.run(3, [&](size_t axis) {
+            std::vector<double> scratch;
+            encodeAxis(chunk.columns[axis], chunk.columns[3 + axis], chunk.times, layout, settings,
+                       blocks[F::PositionX + axis], blocks[F::VelocityX + axis], scratch);
+        });
+    }
+
+    /**
+     * @brief Decodes the chunk starting at `chunk` (`bytes` long), rebuilding `layout` for it.
+     * @param wanted Optional per-slot mask: other bodies' residuals are skipped over, not
+     *               reconstructed, and their samples read as `MISSING`
+     * @return False if the chunk is corrupt or does not match the strides
+     */
+    static bool decodeChunk(const unsigned char* chunk, uint64_t bytes, const uint32_t* strides, size_t bodyCount,
+                            ChunkData& out, Layout& layout, ThreadPool& pool, const uint8_t* wanted = nullptr) {
+        using F = TrajectoryFormat;
+        if (bytes < sizeof(F::ChunkHeader)) return false;
+        F::ChunkHeader header;
+        std::memcpy(&header, chunk, sizeof(header));
+        if (std::memcmp(header.magic, F::CHUNK_MAGIC, sizeof(header.magic)) != 0) return false;
+        for (const F::Block& b : header.blocks) {
+            if (b.offset % F::ALIGNMENT != 0 || b.offset + b.bytes > bytes || b.bytes % sizeof(uint64_t) != 0) return false;
+        }
+        if (header.blocks[F::Times].values != header.frameCount) return false;
+
+        layout.build(strides, bodyCount, header.firstFrame, header.frameCount);
+        if (layout.size() != header.sampleCount) return false;
+        out.firstFrame = header.firstFrame;
+        if (!decodeBlock(chunk, header.blocks[F::Times], out.times, [](size_t i, const double* t, int) { return predictTime(t, i); })) {
+            return false;
+        }
+
+        // A body's predictions read only its own samples, so skipped bodies cannot disturb the wanted ones
+        std::vector<uint8_t> keep;
+        if (wanted) {
+            keep.resize(layout.size());
+            for (size_t i = 0; i < keep.size(); ++i) keep[i] = wanted[layout.slot[i]];
+        }
+        const uint8_t* mask = wanted ? keep.data() : nullptr;
+
+        bool ok[3] = { true, true, true };
+        Weights weights[3];
+        pool.run(3, [&](size_t axis) {
+            std::vector<double>& v = out.columns[3 + axis];
+            std::vector<double>& x = out.columns[axis];
+            ok[axis] = header.blocks[F::VelocityX + axis].values == layout.size() &&
+                       header.blocks[F::PositionX + axis].values == layout.size() &&
+                       decodeBlock(chunk, header.blocks[F::VelocityX + axis], v, [&](size_t i, const double* rec, int order) {
+                           return predict(rec, nullptr, out.times.data(), layout, i, order, weights[axis]);
+                       }, mask) &&
+                       decodeBlock(chunk, header.blocks[F::PositionX + axis], x, [&](size_t i, const double* rec, int order) {
+                           return predict(rec, v.data(), out.times.data(), layout, i, order, weights[axis]);
+                       }, mask);
+        });
+        return ok[0] && ok[1] && ok[2];
+    }
+
+private:
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint64_t>& words) : words(words) {}
+
+        void put(uint64_t value, int bits) {
+            if (bits == 0) return;
+            accumulator |= value << used;
+            if (used + bits >= 64) {
+                words.push_back(accumulator);
+                const int consumed = 64 - used;
+                accumulator = consumed < 64 ? value >> consumed : 0;
+                used += bits - 64;
+            } else {
+                used += bits;
+            }
+        }
+
+        void flush() {
+            if (used > 0) words.push_back(accumulator);
+            accumulator = 0;
+            used = 0;
+        }
+
+    private:
+        std::vector<uint64_t>& words;
+        uint64_t accumulator = 0;
+        int used = 0;
+    };
+
+    class BitReader {
+    public:
+        BitReader(const uint64_t* words, size_t count) : words(words), count(count) {}
+
+        uint64_t get(int bits) {
+            if (bits == 0) return 0;
+            const size_t word = (size_t)(position >> 6);
+            const int offset = (int)(position & 63);
+            if (word >= count || (offset + bits > 64 && word + 1 >= count)) {
+                overrun = true;
+                return 0;
+            }
+            uint64_t value = words[word] >> offset;
+            if (offset + bits > 64) value |= words[word + 1] << (64 - offset);
+            position += (uint64_t)bits;
+            return bits < 64 ? value & ((1ull << bits) - 1) : value;
+        }
+
+        bool overrun = false;
+
+    private:
+        const uint64_t* words;
+        size_t count;
+        uint64_t position = 0;
+    };
+
+    static constexpr int LENGTH_BITS = 6;
+    static constexpr int WINDOW_SLACK = 4; ///< Wasted payload bits accepted to skip a width field
+    static constexpr double MAX_GRID_INDEX = 4.5e15; ///< Grid indices stay exact in a double
+
+    static uint64_t toBits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static double fromBits(uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static int bitLength(uint64_t x) {
+        if (x == 0) return 0;
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, x);
+        return (int)index + 1;
+#else
+        return 64 - __builtin_clzll(x);
+#endif
+    }
+
+    /**
+     * @brief Codes a residual in the previous payload width if it fits with little waste
+     *        (one control bit), else as control bit, 6-bit width and payload.
+     *
+     * Width code 63 stands for 64 bits, so 6 bits cover every width.
+     */
+    static void putWord(BitWriter& bits, uint64_t word, int& window) {
+        int length = bitLength(word);
+        if (length == 63) length = 64;
+        if (length <= window && window - length <= WINDOW_SLACK) {
+            bits.put(0, 1);
+            bits.put(word, window);
+            return;
+        }
+        bits.put(1, 1);
+        bits.put(length == 64 ? 63 : (uint64_t)length, LENGTH_BITS);
+        bits.put(word, length);
+        window = length;
+    }
+
+    static uint64_t getWord(BitReader& bits, int& window) {
+        if (bits.get(1)) {
+            const int code = (int)bits.get(LENGTH_BITS);
+            window = code == 63 ? 64 : code;
+        }
+        return bits.get(window);
+    }
+
+    static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+    static int64_t unzigzag(uint64_t w) { return (int64_t)(w >> 1) ^ -(int64_t)(w & 1); }
+
+    static double predictTime(const double* t, size_t i) {
+        if (i == 0) return 0.0;
+        if (i == 1) return t[0];
+        return t[i - 1] + (t[i - 1] - t[i - 2]);
+    }
+
+    static constexpr int HISTORY = 6;           ///< Samples per extrapolating polynomial (lossless)
+    static constexpr int QUANTIZED_HISTORY = 3; ///< Grid noise grows with the order, so quantized data uses fewer
+
+    /**
+     * @brief Lagrange extrapolation weights, memoized for the last history pattern.
+     *
+     * Bodies with the same stride share their history frames, and samples are
+     * ordered frame by frame, so consecutive predictions mostly reuse one set
+     * of weights instead of recomputing their 30 divisions.
+     */
+    struct Weights {
+        uint32_t frames[HISTORY + 1] = {}; ///< Target frame, then history frames
+        int points = -1;
+        double w[HISTORY] = {};
+
+        const double* get(const uint32_t* key, int count, const double* times) {
+            if (count != points || !std::equal(key, key + count + 1, frames)) {
+                std::copy(key, key + count + 1, frames);
+                points = count;
+                const double at = times[key[0]];
+                for (int k = 0; k < count; ++k) {
+                    double weight = 1.0;
+                    for (int m = 0; m < count; ++m) {
+                        if (m != k) weight *= (at - times[key[1 + m]]) / (times[key[1 + k]] - times[key[1 + m]]);
+                    }
+                    w[k] = weight;
+                }
+            }
+            return w;
+        }
+    };
+
+    /**
+     * @brief Prediction of sample `i` from reconstructed samples only.
+     *
+     * Extrapolates the polynomial through the body's last `order` samples of
+     * the same column. With a single earlier sample, a position is predicted
+     * as $x + v\,\Delta t$ from that sample's velocity.
+     *
+     * @param x Reconstructed column being coded
+     * @param v Reconstructed velocity column for a position column, null for a velocity column
+     */
+    static double predict(const double* x, const double* v, const double* times, const Layout& layout, size_t i,
+                          int order, Weights& weights) {
+        using F = TrajectoryFormat;
+        const int64_t a = layout.previous[i];
+        if (a < 0 || F::isMissing(x[a])) return 0.0;
+
+        // Most recent first, strictly decreasing in time
+        uint32_t key[HISTORY + 1];
+        double values[HISTORY];
+        key[0] = layout.frame[i];
+        int points = 0;
+        for (int64_t p = a; p >= 0 && points < order; p = layout.previous[p]) {
+            const uint32_t frame = layout.frame[p];
+            if (F::isMissing(x[p]) || (points > 0 && !(times[key[points]] > times[frame]))) break;
+            key[1 + points] = frame;
+            values[points++] = x[p];
+        }
+        if (points == 1 && v && !F::isMissing(v[a])) return x[a] + v[a] * (times[key[0]] - times[key[1]]);
+        const double* w = weights.get(key, points, times);
+        double sum = 0.0;
+        for (int k = 0; k < points; ++k) sum += w[k] * values[k];
+        return sum;
+    }
+
+    static void start(Encoded& out, size_t values, uint32_t codec, double quantum) {
+        out.words.clear();
+        out.values = values;
+        out.codec = codec;
+        out.quantum = quantum;
+    }
+
+    /**
+     * @brief Codes one column and returns its reconstruction (the input itself when lossless).
+     */
+    static const double* encodeColumn(const std::vector<double>& x, const double* velRecon, const std::vector<double>& times,
+                                      const Layout& layout, uint32_t codec, double tolerance, Encoded& out,
+                                      std::vector<double>& recon) {
+        using F = TrajectoryFormat;
+        const size_t n = x.size();
+        double quantum = 2.0 * tolerance;
+        if (codec == F::Quantized) {
+            double largest = 0.0;
+            for (double value : x) {
+                if (!F::isMissing(value)) largest = std::max(largest, std::fabs(value));
+            }
+            // Grid too fine for the values: keep this block lossless
+            if (!(quantum > 0.0) || largest / quantum >= MAX_GRID_INDEX) codec = F::Predictive;
+        }
+        if (codec == F::Raw) {
+            start(out, n, F::Raw, 0.0);
+            out.words.resize(n);
+            std::memcpy(out.words.data(), x.data(), n * sizeof(double));
+            return x.data();
+        }
+
+        BitWriter bits(out.words);
+        int window = 0;
+        Weights weights;
+        if (codec == F::Predictive) {
+            start(out, n, F::Predictive, 0.0);
+            for (size_t i = 0; i < n; ++i) {
+                putWord(bits, toBits(x[i]) ^ toBits(predict(x.data(), velRecon, times.data(), layout, i, HISTORY, weights)), window);
+            }
+            bits.flush();
+            return x.data();
+        }
+
+        start(out, n, F::Quantized, quantum);
+        recon.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (F::isMissing(x[i])) {
+                putWord(bits, 0, window);
+                recon[i] = F::MISSING;
+                continue;
+            }
+            const int64_t q = std::llround(x[i] / quantum);
+            const int64_t r = q - gridIndex(predict(recon.data(), velRecon, times.data(), layout, i, QUANTIZED_HISTORY, weights), quantum);
+            putWord(bits, zigzag(r) + 1, window);
+            recon[i] = (double)q * quantum;
+        }
+        bits.flush();
+        return recon.data();
+    }
+
+    static int64_t gridIndex(double value, double quantum) {
+        const double q = value / quantum;
+        return std::fabs(q) < MAX_GRID_INDEX ? std::llround(q) : 0;
+    }
+
+    /**
+     * @brief Decodes one block; `predictor(i, reconstructed, order)` must match the encoder's.
+     * @param keep Optional per-sample mask; unkept samples are parsed past and set to `MISSING`
+     */
+    template <typename Predictor>
+    static bool decodeBlock(const unsigned char* chunk, const TrajectoryFormat::Block& block, std::vector<double>& out,
+                            Predictor predictor, const uint8_t* keep = nullptr) {
+        using F = TrajectoryFormat;
+        const size_t n = (size_t)block.values;
+        const size_t words = (size_t)(block.bytes / sizeof(uint64_t));
+        out.resize(n);
+        if (block.codec == F::Raw) {
+            if (words != n) return false;
+            std::memcpy(out.data(), chunk + block.offset, n * sizeof(double));
+            for (size_t i = 0; keep && i < n; ++i) {
+                if (!keep[i]) out[i] = F::MISSING;
+            }
+            return true;
+        }
+        if (block.codec != F::Predictive && (block.codec != F::Quantized || !(block.quantum > 0.0))) return false;
+
+        // Blocks are 64-byte aligned in a mapped file, so the words can be read in place
+        BitReader bits(reinterpret_cast<const uint64_t*>(chunk + block.offset), words);
+        int window = 0;
+        if (block.codec == F::Predictive) {
+            for (size_t i = 0; i < n; ++i) {
+                const uint64_t w = getWord(bits, window);
+                out[i] = keep && !keep[i] ? F::MISSING : fromBits(w ^ toBits(predictor(i, out.data(), HISTORY)));
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                const uint64_t w = getWord(bits, window);
+                if (w == 0 || (keep && !keep[i])) {
+                    out[i] = F::MISSING;
+                    continue;
+                }
+                const int64_t q = gridIndex(predictor(i, out.data(), QUANTIZED_HISTORY), block.quantum) + unzigzag(w - 1);
+                out[i] = (double)q * block.quantum;
+            }
+        }
+        return !bits.overrun;
+    }
+};
+#if defined(__clang__)
+#pragma float_control(pop)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#elif defined(_MSC_VER)
+#pragma float_control(pop)
+#if defined(_M_FP_FAST)
+#pragma fp_contract(on)
+#endif
+#endif
+
+/**
+ * @brief Streams snapshots to a chunked trajectory file from a background thread.
+ *
+ * `record()` runs on the simulation thread and only copies the recorded
+ * bodies into the chunk being filled. Full chunks go through a bounded queue
+ * to an I/O thread that encodes them (see `TrajectoryCodec`) and writes them, so integration never waits
+ * for the disk. If the disk falls behind far enough to fill the queue, frames
+ * are dropped (and counted) until a slot frees up, keeping memory bounded;
+ * stored frame times show any gap. `close()` flushes the queue and appends the
+ * time index.
+ *
+ * Bodies are matched by id, so the Morton reorders of the body store do not
+ * disturb the catalog order.
+ */
+class TrajectoryWriter {
+public:
+    static constexpr uint32_t DEFAULT_FRAMES_PER_CHUNK = 64;
+    static constexpr size_t DEFAULT_QUEUE_CHUNKS = 8;
+
+    TrajectoryWriter() = default;
+    ~TrajectoryWriter() { close(); }
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    /**
+     * @brief Records every body in `bodies` every frame, except `Asteroid`s every `asteroidStride` frames.
+     */
+    static std::vector<uint32_t> stridesByKind(const std::vector<Body>& bodies, uint32_t asteroidStride) {
+        std::vector<uint32_t> strides(bodies.size(), 1);
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            if (bodies[i].name == "Asteroid") strides[i] = asteroidStride;
+        }
+        return strides;
+    }
+
+    /**
+     * @brief Creates `filename` and starts the I/O thread.
+     * @param catalog Bodies to follow; later frames are matched to them by id
+     * @param strides Per-body recording stride in frames (0 = never); empty records everything
+     * @param framesPerChunk Frames per chunk, the unit of indexing and decoding
+     * @param queueChunks Full chunks allowed in flight before frames are dropped
+     * @return False if the file cannot be created
+     */
+    bool open(const std::string& filename, const std::vector<Body>& catalog, std::vector<uint32_t> strides = {},
+              uint32_t framesPerChunk = DEFAULT_FRAMES_PER_CHUNK, size_t queueChunks = DEFAULT_QUEUE_CHUNKS) {
+        close();
+        const size_t n = catalog.size();
+        if (strides.size() != n) strides.assign(n, 1);
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for recording: " << filename << std::endl;
+            return false;
+        }
+        path = filename;
+        chunkFrames = framesPerChunk > 0 ? framesPerChunk : 1;
+        capacity = queueChunks > 0 ? queueChunks : 1;
+        slotStrides = std::move(strides);
+        slotOfId.clear();
+        for (size_t s = 0; s < n; ++s) slotOfId[catalog[s].id] = s;
+        seenIds.clear();
+        bodyOfSlot.assign(n, -1);
+        frames = dropped = 0;
+        chunksWritten = 0;
+        failed = false;
+        index.clear();
+        fileBytes = 0;
+        rawBytes = 0;
+        settings = nextSettings;
+        if (!codecPool) codecPool = std::make_unique<ThreadPool>(std::min(3u, std::max(1u, std::thread::hardware_concurrency())));
+
+        writeCatalog(catalog);
+        closing = false;
+        io = std::thread([this] { ioLoop(); });
+        return true;
+    }
+
+    bool isOpen() const { return io.joinable(); }
+
+    /** @brief Block coding for the next `open()` (default: lossless `Predictive`). */
+    void setCodec(const TrajectoryCodec::Settings& codec) { nextSettings = codec; }
+
+    /**
+     * @brief Appends one frame at simulated time `time`. Never waits for the disk.
+     * @return False if the frame was dropped (queue full) or no recording is open
+     */
+    bool record(const std::vector<Body>& bodies, double time) {
+        if (!isOpen()) return false;
+        if (full && !submit(std::move(full), false)) {
+            ++dropped;
+            return false;
+        }
+        if (!filling) filling = acquire();
+
+        mapBodies(bodies);
+        Chunk& c = *filling;
+        const uint64_t frame = frames++;
+        if (c.times.empty()) c.firstFrame = frame;
+        c.times.push_back(time);
+        for (size_t s = 0; s < slotStrides.size(); ++s) {
+            if (!TrajectoryFormat::recorded(slotStrides[s], frame)) continue;
+            const int i = bodyOfSlot[s];
+            if (i < 0) {
+                for (auto& column : c.columns) column.push_back(TrajectoryFormat::MISSING);
+                continue;
+            }
+            const Body& b = bodies[i];
+            c.columns[0].push_back(b.position.x);
+            c.columns[1].push_back(b.position.y);
+            c.columns[2].push_back(b.position.z);
+            c.columns[3].push_back(b.velocity.x);
+            c.columns[4].push_back(b.velocity.y);
+            c.columns[5].push_back(b.velocity.z);
+        }
+        if (c.times.size() >= chunkFrames) {
+            full = std::move(filling);
+            submit(std::move(full), false);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Flushes every frame, writes the time index and joins the I/O thread.
+     * @return True if the whole recording reached the disk
+     */
+    bool close() {
+        if (!isOpen()) return false;
+        if (full) submit(std::move(full), true);
+        if (filling && !filling->times.empty()) submit(std::move(filling), true);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        workAvailable.notify_one();
+        io.join();
+        filling.reset();
+        queue.clear();
+        spare.clear();
+
+        TrajectoryFormat::Trailer trailer;
+        std::memset(&trailer, 0, sizeof(trailer));
+        trailer.indexOffset = fileBytes;
+        trailer.chunkCount = index.size();
+        trailer.frameCount = frames;
+        std::memcpy(trailer.magic, TrajectoryFormat::INDEX_MAGIC, sizeof(trailer.magic));
+        emit(index.data(), index.size() * sizeof(TrajectoryFormat::IndexEntry));
+        emit(&trailer, sizeof(trailer));
+        file.close();
+
+        if (failed || !file) {
+            std::cerr << "Failed to write trajectory: " << path << std::endl;
+            return false;
+        }
+        std::cout << "Saved trajectory (" << frames << " frames, " << index.size() << " chunks, "
+                  << dropped << " dropped, " << getCompressionRatio() << ":1) to: " << path << std::endl;
+        return true;
+    }
+
+    uint64_t getFramesRecorded() const { return frames; }
+    uint64_t getFramesDropped() const { return dropped; }
+    uint64_t getChunksWritten() const { return chunksWritten.load(); }
+
+    /** @returns Raw sample bytes per stored byte of the last recording (valid after `close()`) */
+    double getCompressionRatio() const { return fileBytes > 0 ? (double)rawBytes / (double)fileBytes : 0.0; }
+
+private:
+    using Chunk = TrajectoryCodec::ChunkData;
+
+    std::unique_ptr<Chunk> acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.empty()) return std::make_unique<Chunk>();
+        std::unique_ptr<Chunk> c = std::move(spare.back());
+        spare.pop_back();
+        return c;
+    }
+
+    /**
+     * @brief Hands a chunk to the I/O thread; waits for room only if `wait` (at close).
+     *
+     * On failure `full` keeps the chunk for the next attempt.
+     */
+    bool submit(std::unique_ptr<Chunk> chunk, bool wait) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (wait) spaceAvailable.wait(lock, [this] { return queue.size() < capacity; });
+            if (queue.size() >= capacity) {
+                full = std::move(chunk);
+                return false;
+            }
+            queue.push_back(std::move(chunk));
+        }
+        workAvailable.notify_one();
+        return true;
+    }
+
+    /** @brief Rebuilds the catalog slot -> body index map when the body store was reordered or merged. */
+    void mapBodies(const std::vector<Body>& bodies) {
+        bool same = bodies.size() == seenIds.size();
+        for (size_t i = 0; same && i < bodies.size(); ++i) same = bodies[i].id == seenIds[i];
+        if (same) return;
+        seenIds.resize(bodies.size());
+        std::fill(bodyOfSlot.begin(), bodyOfSlot.end(), -1);
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            seenIds[i] = bodies[i].id;
+            auto it = slotOfId.find(bodies[i].id);
+            if (it != slotOfId.end()) bodyOfSlot[it->second] = (int)i;
+        }
+    }
+
+    void ioLoop() {
+        while (true) {
+            std::unique_ptr<Chunk> chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [this] { return !queue.empty() || closing; });
+                if (queue.empty()) return;
+                chunk = std::move(queue.front());
+                queue.pop_front();
+            }
+            spaceAvailable.notify_one();
+            writeChunk(*chunk);
+
+            chunk->times.clear();
+            for (auto& column : chunk->columns) column.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(std::move(chunk));
+        }
+    }
+
+    void writeChunk(const Chunk& c) {
+        using F = TrajectoryFormat;
+        layout.build(slotStrides.data(), slotStrides.size(), c.firstFrame, (uint32_t)c.times.size());
+        TrajectoryCodec::encodeChunk(c, layout, settings, encoded, *codecPool);
+
+        F::ChunkHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, F::CHUNK_MAGIC, sizeof(header.magic));
+        header.firstFrame = c.firstFrame;
+        header.frameCount = (uint32_t)c.times.size();
+        header.sampleCount = c.columns[0].size();
+        uint64_t cursor = Checkpoint::alignUp(sizeof(header));
+        for (uint32_t f = 0; f < F::FIELD_COUNT; ++f) {
+            const uint64_t bytes = encoded[f].words.size() * sizeof(uint64_t);
+            header.blocks[f] = { cursor, bytes, encoded[f].values, encoded[f].quantum, encoded[f].codec, 0 };
+            cursor = Checkpoint::alignUp(cursor + bytes);
+        }
+
+        const uint64_t start = fileBytes;
+        emit(&header, sizeof(header));
+        pad();
+        for (uint32_t f = 0; f < F::FIELD_COUNT; ++f) {
+            emit(encoded[f].words.data(), encoded[f].words.size() * sizeof(uint64_t));
+            pad();
+        }
+        index.push_back({ c.times.front(), c.times.back(), c.firstFrame, start, fileBytes - start, header.frameCount, 0 });
+        rawBytes += (c.times.size() + 6 * header.sampleCount) * sizeof(double);
+        ++chunksWritten;
+    }
+
+    void writeCatalog(const std::vector<Body>& catalog) {
+        using F = TrajectoryFormat;
+        const size_t n = catalog.size();
+        std::vector<double> masses(n), radii(n);
+        std::vector<uint64_t> offsets(n + 1);
+        std::string names;
+        for (size_t i = 0; i < n; ++i) {
+            masses[i] = catalog[i].mass;
+            radii[i] = catalog[i].radius;
+            offsets[i] = names.size();
+            names += catalog[i].name;
+        }
+        offsets[n] = names.size();
+
+        F::Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, F::MAGIC, sizeof(header.magic));
+        header.version = F::VERSION;
+        header.byteOrder = Checkpoint::ENDIAN_MARK;
+        header.bodyCount = n;
+        header.framesPerChunk = chunkFrames;
+        const void* data[F::CATALOG_COUNT] = { slotStrides.data(), masses.data(), radii.data(), offsets.data(), names.data() };
+        const size_t sizes[F::CATALOG_COUNT] = {
+            n * sizeof(uint32_t), n * sizeof(double), n * sizeof(double), (n + 1) * sizeof(uint64_t), names.size()
+        };
+        uint64_t cursor = Checkpoint::alignUp(sizeof(header));
+        for (uint32_t c = 0; c < F::CATALOG_COUNT; ++c) {
+            header.catalog[c] = { cursor, sizes[c] };
+            cursor = Checkpoint::alignUp(cursor + sizes[c]);
+        }
+        emit(&header, sizeof(header));
+        pad();
+        for (uint32_t c = 0; c < F::CATALOG_COUNT; ++c) {
+            emit(data[c], sizes[c]);
+            pad();
+        }
+    }
+
+    void emit(const void* data, size_t bytes) {
+        if (!file.write(static_cast<const char*>(data), (std::streamsize)bytes)) failed = true;
+        fileBytes += bytes;
+    }
+
+    void pad() {
+        static const char zeros[TrajectoryFormat::ALIGNMENT] = {};
+        emit(zeros, Checkpoint::alignUp(fileBytes) - fileBytes);
+    }
+
+    // Simulation-thread side
+    std::vector<uint32_t> slotStrides;
+    std::unordered_map<uint32_t, size_t> slotOfId;
+    std::vector<uint32_t> seenIds;      ///< Body order `bodyOfSlot` was built for
+    std::vector<int> bodyOfSlot;        ///< Catalog slot -> body index, -1 once merged away
+    std::unique_ptr<Chunk> filling;     ///< Chunk being filled
+    std::unique_ptr<Chunk> full;        ///< Full chunk still waiting for queue space
+    uint32_t chunkFrames = DEFAULT_FRAMES_PER_CHUNK;
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+
+    // Shared with the I/O thread
+    std::mutex mutex;
+    std::condition_variable workAvailable, spaceAvailable;
+    std::deque<std::unique_ptr<Chunk>> queue;
+    std::vector<std::unique_ptr<Chunk>> spare; ///< Written chunks, reused to avoid reallocating columns
+    size_t capacity = DEFAULT_QUEUE_CHUNKS;
+    bool closing = false;
+    std::atomic<uint64_t> chunksWritten{0};
+
+    // I/O-thread side (and the caller's, before start and after join)
+    std::ofstream file;
+    std::string path;
+    uint64_t fileBytes = 0;
+    uint64_t rawBytes = 0;
+    bool failed = false;
+    std::vector<TrajectoryFormat::IndexEntry> index;
+    TrajectoryCodec::Settings settings, nextSettings;
+    TrajectoryCodec::Layout layout;
+    TrajectoryCodec::Encoded encoded[TrajectoryFormat::FIELD_COUNT];
+    std::unique_ptr<ThreadPool> codecPool; ///< Encodes the three axes of a chunk in parallel
+    std::thread io;
+};
+
+/**
+ * @brief Random access to a trajectory recording.
+ *
+ * `open` maps the file and validates the header, catalog, trailer and time
+ * index; no chunk is read yet. A query binary-searches the index for its
+ * chunk and decodes that chunk alone, and within it only the bodies picked by
+ * `select()`: the other bodies' residuals are parsed past but never
+ * predicted. The last few decoded chunks are cached, so scrubbing back and
+ * forth over nearby times decodes nothing.
+ *
+ * `frame()` returns a view straight into the cached SoA columns. `sample()`
+ * interpolates each body between its two stored samples around the query
+ * time with the cubic Hermite polynomial that matches both stored positions
+ * and velocities ($s = (t - t_a)/h$, $h = t_b - t_a$):
+ *
+ * $$x(t) = h_{00}(s)\,x_a + h_{10}(s)\,h\,v_a + h_{01}(s)\,x_b + h_{11}(s)\,h\,v_b$$
+ *
+ * Its error is $O(h^4)$, so asteroids stored every 10th frame still land on
+ * their orbits.
+ */
+class TrajectoryReader {
+public:
+    static constexpr size_t CACHED_CHUNKS = 4;
+
+    /**
+     * @brief Samples of one stored frame: entry `k` is catalog slot `slots[k]`.
+     *
+     * Points into the reader's chunk cache: valid until the next query that decodes another chunk.
+     */
+    struct FrameView {
+        uint64_t frame = 0;
+        double time = 0.0;
+        size_t count = 0;
+        const uint32_t* slots = nullptr; ///< Ascending catalog slots
+        const double* position[3] = {};
+        const double* velocity[3] = {};
+    };
+
+    /** @brief Interpolated state of the selected bodies; `MISSING` positions for bodies absent at `time`. */
+    struct Sample {
+        double time = 0.0;
+        std::vector<uint32_t> slots;
+        std::vector<Vector3> positions;
+        std::vector<Vector3> velocities;
+    };
+
+    TrajectoryReader() = default;
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    /**
+     * @returns False (with a message on stderr) if the file is missing, truncated, unfinished,
+     *          from another version, or written with a different byte order
+     */
+    bool open(const std::string& filename) {
+        using F = TrajectoryFormat;
+        close();
+        if (!file.open(filename)) {
+            std::cerr << "Failed to open trajectory: " << filename << std::endl;
+            return false;
+        }
+        path = filename;
+        const uint64_t size = file.size();
+        if (size < sizeof(F::Header) + sizeof(F::Trailer)) return fail("truncated file");
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, F::MAGIC, sizeof(header.magic)) != 0) return fail("not a trajectory");
+        if (header.version != F::VERSION) return fail("unsupported version");
+        if (header.byteOrder != Checkpoint::ENDIAN_MARK) return fail("byte order mismatch");
+
+        const uint64_t n = header.bodyCount;
+        if (n > size) return fail("corrupt catalog");
+        const uint64_t expected[F::CATALOG_COUNT] = {
+            n * sizeof(uint32_t), n * sizeof(double), n * sizeof(double), (n + 1) * sizeof(uint64_t), 0
+        };
+        for (uint32_t c = 0; c < F::CATALOG_COUNT; ++c) {
+            const Checkpoint::ColumnEntry& col = header.catalog[c];
+            if (col.offset % F::ALIGNMENT != 0 || col.offset + col.bytes > size ||
+                (c != F::Names && col.bytes != expected[c])) {
+                return fail("corrupt catalog");
+            }
+        }
+        const uint64_t* offsets = catalog<uint64_t>(F::NameOffsets);
+        bool namesValid = offsets[0] == 0 && offsets[n] == header.catalog[F::Names].bytes;
+        for (uint64_t i = 0; namesValid && i < n; ++i) namesValid = offsets[i] <= offsets[i + 1];
+        if (!namesValid) return fail("corrupt name table");
+
+        // An unfinished recording has no trailer yet
+        F::Trailer trailer;
+        std::memcpy(&trailer, file.data() + size - sizeof(trailer), sizeof(trailer));
+        if (std::memcmp(trailer.magic, F::INDEX_MAGIC, sizeof(trailer.magic)) != 0) return fail("missing time index");
+        const uint64_t indexEnd = size - sizeof(trailer);
+        if (trailer.indexOffset > indexEnd || trailer.chunkCount > size / sizeof(F::IndexEntry) ||
+            indexEnd - trailer.indexOffset != trailer.chunkCount * sizeof(F::IndexEntry)) {
+            return fail("corrupt time index");
+        }
+        const uint64_t indexBytes = indexEnd - trailer.indexOffset;
+        index.resize((size_t)trailer.chunkCount);
+        if (!index.empty()) std::memcpy(index.data(), file.data() + trailer.indexOffset, (size_t)indexBytes);
+
+        // Binary search needs contiguous frames and non-decreasing times
+        uint64_t frames = 0;
+        for (size_t c = 0; c < index.size(); ++c) {
+            const F::IndexEntry& e = index[c];
+            if (e.firstFrame != frames || e.frameCount == 0 || e.offset + e.bytes > trailer.indexOffset ||
+                e.offset % F::ALIGNMENT != 0) {
+                return fail("corrupt time index");
+            }
+            if (!(e.firstTime <= e.lastTime) || (c > 0 && !(index[c - 1].lastTime <= e.firstTime))) {
+                return fail("time runs backwards");
+            }
+            frames += e.frameCount;
+        }
+        if (frames != trailer.frameCount) return fail("corrupt time index");
+        frameCount = frames;
+
+        if (!pool) pool = std::make_unique<ThreadPool>(std::min(3u, std::max(1u, std::thread::hardware_concurrency())));
+        select({});
+        return true;
+    }
+
+    void close() {
+        file.close();
+        path.clear();
+        index.clear();
+        frameCount = 0;
+        selection.clear();
+        wanted.clear();
+        for (Cached& c : cache) c.chunk = NONE;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+
+    size_t getBodyCount() const { return (size_t)header.bodyCount; }
+    uint64_t getFrameCount() const { return frameCount; }
+    size_t getChunkCount() const { return index.size(); }
+    double getStartTime() const { return index.empty() ? 0.0 : index.front().firstTime; }
+    double getEndTime() const { return index.empty() ? 0.0 : index.back().lastTime; }
+
+    const uint32_t* strides() const { return catalog<uint32_t>(TrajectoryFormat::Strides); }
+    const double* masses() const { return catalog<double>(TrajectoryFormat::Masses); }
+    const double* radii() const { return catalog<double>(TrajectoryFormat::Radii); }
+
+    std::string name(size_t slot) const {
+        const uint64_t* offsets = catalog<uint64_t>(TrajectoryFormat::NameOffsets);
+        return std::string(catalog<char>(TrajectoryFormat::Names) + offsets[slot], (size_t)(offsets[slot + 1] - offsets[slot]));
+    }
+
+    /**
+     * @brief The recorded bodies (name, mass, radius) at the origin, in catalog order;
+     *        place them with `sample()`.
+     */
+    std::vector<Body> catalogBodies() const {
+        std::vector<Body> bodies;
+        bodies.reserve(getBodyCount());
+        for (size_t s = 0; s < getBodyCount(); ++s) bodies.emplace_back(name(s), masses()[s], radii()[s], Vector3(), Vector3());
+        return bodies;
+    }
+
+    /**
+     * @brief Restricts decoding, `frame()` and `sample()` to catalog `slots`; empty selects every body.
+     */
+    void select(const std::vector<uint32_t>& slots) {
+        const size_t n = getBodyCount();
+        wanted.assign(n, 0);
+        selection.clear();
+        for (uint32_t s : slots) {
+            if (s < n && !wanted[s]) {
+                wanted[s] = 1;
+                selection.push_back(s);
+            }
+        }
+        std::sort(selection.begin(), selection.end());
+        if (selection.empty() || selection.size() == n) {
+            selection.clear();
+            std::fill(wanted.begin(), wanted.end(), 1);
+        }
+        for (Cached& c : cache) c.chunk = NONE; // Decoded for the old selection
+    }
+
+    /** @returns The chunk holding `time` (the nearest one outside the recording), by binary search of the index */
+    size_t findChunk(double time) const {
+        auto it = std::upper_bound(index.begin(), index.end(), time,
+                                   [](double t, const TrajectoryFormat::IndexEntry& e) { return t < e.firstTime; });
+        return it == index.begin() ? 0 : (size_t)(it - index.begin()) - 1;
+    }
+
+    /**
+     * @brief Last stored frame at or before `time` (the first frame before the recording starts).
+     * @return False if nothing is recorded or the chunk is corrupt
+     */
+    bool findFrame(double time, uint64_t& frame) {
+        if (index.empty()) return false;
+        const size_t c = findChunk(time);
+        const Cached* e = decode(c);
+        if (!e) return false;
+        const std::vector<double>& times = e->data.times;
+        const size_t k = (size_t)(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+        frame = index[c].firstFrame + (k > 0 ? k - 1 : 0);
+        return true;
+    }
+
+    /**
+     * @brief Zero-copy view of stored frame `frame` (selected bodies only).
+     * @return False if the frame is out of range or its chunk is corrupt
+     */
+    bool frame(uint64_t frame, FrameView& view) {
+        if (frame >= frameCount) return false;
+        const Cached* e = decode(chunkOfFrame(frame));
+        if (!e) return false;
+        const size_t local = (size_t)(frame - e->data.firstFrame);
+        const uint64_t begin = e->frameStart[local];
+        view.frame = frame;
+        view.time = e->data.times[local];
+        view.count = (size_t)(e->frameStart[local + 1] - begin);
+        view.slots = e->slots + begin;
+        for (int axis = 0; axis < 3; ++axis) {
+            view.position[axis] = e->columns[axis] + begin;
+            view.velocity[axis] = e->columns[3 + axis] + begin;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Hermite-interpolated positions and velocities of the selected bodies at `time`
+     *        (clamped to the recording).
+     *
+     * Each body is interpolated between its own stored samples, which for a
+     * body with stride N are N frames apart. Past its last sample, or next to
+     * a frame where it is missing, a body is extrapolated from its nearest
+     * sample as $x + v\,\Delta t$.
+     *
+     * @return False if nothing is recorded or a needed chunk is corrupt
+     */
+    bool sample(double time, Sample& out) {
+        uint64_t f = 0;
+        if (!findFrame(time, f)) return false;
+        time = std::clamp(time, getStartTime(), getEndTime());
+        out.time = time;
+        if (selection.empty()) {
+            out.slots.resize(getBodyCount());
+            for (size_t s = 0; s < out.slots.size(); ++s) out.slots[s] = (uint32_t)s;
+        } else {
+            out.slots = selection;
+        }
+        out.positions.resize(out.slots.size());
+        out.velocities.resize(out.slots.size());
+
+        const uint32_t* stride = strides();
+        const double missing = TrajectoryFormat::MISSING;
+        for (size_t k = 0; k < out.slots.size(); ++k) {
+            const uint32_t s = out.slots[k];
+            Vector3& x = out.positions[k];
+            Vector3& v = out.velocities[k];
+            x = Vector3(missing, missing, missing);
+            v = Vector3(missing, missing, missing);
+            if (stride[s] == 0) continue;
+
+            const uint64_t fa = f - f % stride[s];
+            const uint64_t fb = fa + stride[s];
+            double ta = 0.0, tb = 0.0;
+            Vector3 xa, va, xb, vb;
+            bool corrupt = false;
+            const bool haveA = lookup(fa, s, ta, xa, va, corrupt);
+            const bool haveB = fb < frameCount && lookup(fb, s, tb, xb, vb, corrupt);
+            if (corrupt) return false;
+            if (haveA && haveB && tb > ta) {
+                const double h = tb - ta;
+                const double u = (time - ta) / h, u2 = u * u, u3 = u2 * u;
+                x = xa * (2.0 * u3 - 3.0 * u2 + 1.0) + va * ((u3 - 2.0 * u2 + u) * h) + xb * (3.0 * u2 - 2.0 * u3) +
+                    vb * ((u3 - u2) * h);
+                v = (xa - xb) * ((6.0 * u2 - 6.0 * u) / h) + va * (3.0 * u2 - 4.0 * u + 1.0) + vb * (3.0 * u2 - 2.0 * u);
+            } else if (haveA) {
+                x = xa + va * (time - ta);
+                v = va;
+            } else if (haveB) {
+                x = xb + vb * (time - tb);
+                v = vb;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    /** @brief A decoded chunk, compacted to the selected bodies (views point into it). */
+    struct Cached {
+        size_t chunk = NONE;
+        uint64_t used = 0;
+        TrajectoryCodec::ChunkData data;
+        TrajectoryCodec::Layout layout;
+        std::vector<uint64_t> frameStart;   ///< First entry of each frame, plus the end
+        std::vector<uint32_t> compactSlots;
+        std::vector<double> compact[TrajectoryFormat::FIELD_COUNT - 1];
+        const uint32_t* slots = nullptr;
+        const double* columns[TrajectoryFormat::FIELD_COUNT - 1] = {};
+    };
+
+    template <typename T>
+    const T* catalog(TrajectoryFormat::CatalogColumn c) const {
+        return reinterpret_cast<const T*>(file.data() + header.catalog[c].offset);
+    }
+
+    size_t chunkOfFrame(uint64_t frame) const {
+        auto it = std::upper_bound(index.begin(), index.end(), frame,
+                                   [](uint64_t f, const TrajectoryFormat::IndexEntry& e) { return f < e.firstFrame; });
+        return (size_t)(it - index.begin()) - 1;
+    }
+
+    /** @returns Chunk `chunk` from the cache, decoding it into the least recently used entry if needed */
+    const Cached* decode(size_t chunk) {
+        Cached* entry = &cache[0];
+        for (Cached& c : cache) {
+            if (c.chunk == chunk) {
+                c.used = ++clock;
+                return &c;
+            }
+            if (c.used < entry->used) entry = &c;
+        }
+
+        const TrajectoryFormat::IndexEntry& e = index[chunk];
+        entry->chunk = NONE;
+        if (!TrajectoryCodec::decodeChunk(file.data() + e.offset, e.bytes, strides(), getBodyCount(), entry->data,
+                                          entry->layout, *pool, selection.empty() ? nullptr : wanted.data()) ||
+            entry->data.firstFrame != e.firstFrame || entry->data.times.size() != e.frameCount) {
+            std::cerr << "Invalid trajectory " << path << ": corrupt chunk " << chunk << std::endl;
+            return nullptr;
+        }
+
+        // Compact the selection frame by frame; with every body selected the decoded columns are used as they are
+        const TrajectoryCodec::Layout& layout = entry->layout;
+        entry->frameStart.assign(e.frameCount + 1, 0);
+        if (selection.empty()) {
+            for (size_t i = 0; i < layout.size(); ++i) ++entry->frameStart[layout.frame[i] + 1];
+            entry->slots = layout.slot.data();
+            for (int c = 0; c < 6; ++c) entry->columns[c] = entry->data.columns[c].data();
+        } else {
+            entry->compactSlots.clear();
+            for (auto& column : entry->compact) column.clear();
+            for (size_t i = 0; i < layout.size(); ++i) {
+                if (!wanted[layout.slot[i]]) continue;
+                ++entry->frameStart[layout.frame[i] + 1];
+                entry->compactSlots.push_back(layout.slot[i]);
+                for (int c = 0; c < 6; ++c) entry->compact[c].push_back(entry->data.columns[c][i]);
+            }
+            entry->slots = entry->compactSlots.data();
+            for (int c = 0; c < 6; ++c) entry->columns[c] = entry->compact[c].data();
+        }
+        for (uint32_t f = 0; f < e.frameCount; ++f) entry->frameStart[f + 1] += entry->frameStart[f];
+        entry->chunk = chunk;
+        entry->used = ++clock;
+        return entry;
+    }
+
+    /**
+     * @brief Stored sample of `slot` in `frame`.
+     * @return False if the body is not stored there or missing; `corrupt` is set if its chunk is
+     */
+    bool lookup(uint64_t frame, uint32_t slot, double& time, Vector3& x, Vector3& v, bool& corrupt) {
+        const Cached* e = decode(chunkOfFrame(frame));
+        if (!e) {
+            corrupt = true;
+            return false;
+        }
+        const size_t local = (size_t)(frame - e->data.firstFrame);
+        const uint32_t* begin = e->slots + e->frameStart[local];
+        const uint32_t* end = e->slots + e->frameStart[local + 1];
+        const uint32_t* it = std::lower_bound(begin, end, slot);
+        if (it == end || *it != slot) return false;
+        const size_t i = (size_t)(it - e->slots);
+        if (TrajectoryFormat::isMissing(e->columns[0][i])) return false;
+        time = e->data.times[local];
+        x = Vector3(e->columns[0][i], e->columns[1][i], e->columns[2][i]);
+        v = Vector3(e->columns[3][i], e->columns[4][i], e->columns[5][i]);
+        return true;
+    }
+
+    bool fail(const char* reason) {
+        std::cerr << "Invalid trajectory " << path << ": " << reason << std::endl;
+        close();
+        return false;
+    }
+
+    MappedFile file;
+    std::string path;
+    TrajectoryFormat::Header header = {};
+    std::vector<TrajectoryFormat::IndexEntry> index;
+    uint64_t frameCount = 0;
+    std::vector<uint32_t> selection;  ///< Selected slots, ascending; empty = all
+    std::vector<uint8_t> wanted;      ///< Per-slot selection mask
+    Cached cache[CACHED_CHUNKS];
+    uint64_t clock = 0;
+    std::unique_ptr<ThreadPool> pool; ///< Decodes the three axes of a chunk in parallel
+};
+
+} // namespace SolarSim
@@ -2,6 +2,11 @@
 
 #include <cmath>
 #include <iostream>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #ifdef _MSC_VER
 #define ALIGN_AS(n) __declspec(align(n))
@@ -12,89 +17,168 @@
 namespace SolarSim {
 
 /**
- * @brief A simple 3D vector struct for physics calculations.
- * Aligned for potential SIMD optimization.
+ * @brief A simple 3D vector for physics calculations, templated on precision.
+ *
+ * `Vector3` (double) is the default everywhere. `Vector3f` halves the footprint
+ * of the compute arrays for belt-scale runs where float precision is enough.
+ *
+ * @details
+ * The vector is padded to four components and aligned to their full width, so
+ * a double vector is exactly one AVX2 `__m256d`. With AVX2 enabled, double
+ * arithmetic is done on that register with aligned loads and stores; the
+ * padding lane is kept at zero by every operation, so `dot` can reduce all
+ * four lanes. Per-component operation order matches the scalar code (no FMA,
+ * `dot` sums $(x + y) + z$), so both paths produce identical results.
+ *
+ * @tparam Real Component type (`float` or `double`)
  */
-struct ALIGN_AS(16) Vector3 {
-    double x, y, z;
-    double padding; // Ensure 32-byte alignment for 2 doubles or 16-byte for future-proofing
+template <typename Real>
+struct alignas(4 * sizeof(Real)) BasicVector3 {
+    using value_type = Real;
+
+    Real x, y, z;
+    Real padding; // Lane 3: always zero
 
-    Vector3(double x = 0.0, double y = 0.0, double z = 0.0) : x(x), y(y), z(z), padding(0.0) {}
+    BasicVector3(Real x = Real(0), Real y = Real(0), Real z = Real(0)) : x(x), y(y), z(z), padding(Real(0)) {}
+
+    /**
+     * @brief Converts between precisions (e.g. loading a double state into a float workspace).
+     */
+    template <typename Other>
+    explicit BasicVector3(const BasicVector3<Other>& other)
+        : x(Real(other.x)), y(Real(other.y)), z(Real(other.z)), padding(Real(0)) {}
 
     // Vector operations
-    Vector3 operator+(const Vector3& other) const {
-        return Vector3(x + other.x, y + other.y, z + other.z);
+    BasicVector3 operator+(const BasicVector3& other) const {
+#if defined(__AVX2__)
+        if constexpr (Simd) return BasicVector3(_mm256_add_pd(reg(), other.reg()));
+#endif
+        return BasicVector3(x + other.x, y + other.y, z + other.z);
     }
 
-    Vector3 operator-(const Vector3& other) const {
-        return Vector3(x - other.x, y - other.y, z - other.z);
+    BasicVector3 operator-(const BasicVector3& other) const {
+#if defined(__AVX2__)
+        if constexpr (Simd) return BasicVector3(_mm256_sub_pd(reg(), other.reg()));
+#endif
+        return BasicVector3(x - other.x, y - other.y, z - other.z);
     }
 
-    Vector3 operator*(double scalar) const {
-        return Vector3(x * scalar, y * scalar, z * scalar);
+    BasicVector3 operator*(Real scalar) const {
+#if defined(__AVX2__)
+        if constexpr (Simd) return BasicVector3(clearW(_mm256_mul_pd(reg(), _mm256_set1_pd(scalar))));
+#endif
+        return BasicVector3(x * scalar, y * scalar, z * scalar);
     }
 
-    Vector3 operator/(double scalar) const {
-        return Vector3(x / scalar, y / scalar, z / scalar);
+    BasicVector3 operator/(Real scalar) const {
+#if defined(__AVX2__)
+        if constexpr (Simd) return BasicVector3(clearW(_mm256_div_pd(reg(), _mm256_set1_pd(scalar))));
+#endif
+        return BasicVector3(x / scalar, y / scalar, z / scalar);
     }
 
-    Vector3& operator+=(const Vector3& other) {
+    BasicVector3& operator+=(const BasicVector3& other) {
+#if defined(__AVX2__)
+        if constexpr (Simd) { _mm256_store_pd(&x, _mm256_add_pd(reg(), other.reg())); return *this; }
+#endif
         x += other.x;
         y += other.y;
         z += other.z;
         return *this;
     }
 
-    Vector3& operator-=(const Vector3& other) {
+    BasicVector3& operator-=(const BasicVector3& other) {
+#if defined(__AVX2__)
+        if constexpr (Simd) { _mm256_store_pd(&x, _mm256_sub_pd(reg(), other.reg())); return *this; }
+#endif
         x -= other.x;
         y -= other.y;
         z -= other.z;
         return *this;
     }
 
-    Vector3& operator*=(double scalar) {
+    BasicVector3& operator*=(Real scalar) {
+#if defined(__AVX2__)
+        if constexpr (Simd) { _mm256_store_pd(&x, clearW(_mm256_mul_pd(reg(), _mm256_set1_pd(scalar)))); return *this; }
+#endif
         x *= scalar;
         y *= scalar;
         z *= scalar;
         return *this;
     }
 
-    double lengthSquared() const {
-        return x * x + y * y + z * z;
+    Real lengthSquared() const {
+        return dot(*this);
     }
 
-    double length() const {
+    Real length() const {
         return std::sqrt(lengthSquared());
     }
 
-    Vector3 normalized() const {
-        double l = length();
+    BasicVector3 normalized() const {
+        Real l = length();
         if (l > 0) return *this / l;
-        return Vector3();
+        return BasicVector3();
     }
 
     /**
      * @brief Dot product with another vector.
      */
-    double dot(const Vector3& other) const {
+    Real dot(const BasicVector3& other) const {
+#if defined(__AVX2__)
+        if constexpr (Simd) {
+            __m256d p = _mm256_mul_pd(reg(), other.reg());
+            __m128d xy = _mm256_castpd256_pd128(p);
+            __m128d zw = _mm256_extractf128_pd(p, 1);
+            __m128d sum = _mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw);
+            return _mm_cvtsd_f64(sum);
+        }
+#endif
         return x * other.x + y * other.y + z * other.z;
     }
 
     /**
      * @brief Cross product with another vector.
      */
-    Vector3 cross(const Vector3& other) const {
-        return Vector3(
+    BasicVector3 cross(const BasicVector3& other) const {
+#if defined(__AVX2__)
+        if constexpr (Simd) {
+            // (y, z, x, w) and (z, x, y, w) lane rotations; w stays 0
+            const __m256d a = reg(), b = other.reg();
+            __m256d aYZX = _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 0, 2, 1));
+            __m256d aZXY = _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 1, 0, 2));
+            __m256d bYZX = _mm256_permute4x64_pd(b, _MM_SHUFFLE(3, 0, 2, 1));
+            __m256d bZXY = _mm256_permute4x64_pd(b, _MM_SHUFFLE(3, 1, 0, 2));
+            return BasicVector3(_mm256_sub_pd(_mm256_mul_pd(aYZX, bZXY), _mm256_mul_pd(aZXY, bYZX)));
+        }
+#endif
+        return BasicVector3(
             y * other.z - z * other.y,
             z * other.x - x * other.z,
             x * other.y - y * other.x
         );
     }
 
-    friend std::ostream& operator<<(std::ostream& os, const Vector3& v) {
+    friend std::ostream& operator<<(std::ostream& os, const BasicVector3& v) {
         os << "(" << v.x << ", " << v.y << ", " << v.z << ")";
         return os;
     }
+
+private:
+    /// AVX2 register path is used for double vectors only
+    static constexpr bool Simd = std::is_same<Real, double>::value;
+
+#if defined(__AVX2__)
+    explicit BasicVector3(__m256d v) { _mm256_store_pd(&x, v); }
+
+    __m256d reg() const { return _mm256_load_pd(&x); }
+
+    /// Forces lane 3 back to zero (a scalar of inf/NaN would otherwise leak into it)
+    static __m256d clearW(__m256d v) { return _mm256_blend_pd(v, _mm256_setzero_pd(), 0x8); }
+#endif
 };
 
+using Vector3 = BasicVector3<double>;
+using Vector3f = BasicVector3<float>;
+
 } // namespace SolarSim
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace SolarSim {
+
+/**
+ * @brief Growable array backed by reserved virtual memory; elements never move.
+ *
+ * `std::vector` growth copies every element to a new block, which in a tree
+ * build means copying the whole pool mid-build on whatever frame the body
+ * count crosses a power of two. This arena reserves address space for the
+ * worst case once and commits pages as it grows, so growing is a page fault
+ * (POSIX) or a commit call (Windows) rather than a copy, and pointers and
+ * indices stay valid.
+ *
+ * On Linux the region is advised for transparent huge pages when requested,
+ * cutting TLB misses for large trees.
+ *
+ * @tparam T Trivially copyable element type; fresh pages are zero-filled
+ */
+template <typename T>
+class VirtualArena {
+    static_assert(std::is_trivially_copyable<T>::value, "VirtualArena holds raw trivially copyable data");
+
+public:
+    VirtualArena() = default;
+    ~VirtualArena() { release(); }
+
+    VirtualArena(const VirtualArena&) = delete;
+    VirtualArena& operator=(const VirtualArena&) = delete;
+
+    /**
+     * @brief Ensures address space for `count` elements.
+     *
+     * Only grows. If the current reservation is too small it is replaced, which
+     * moves and discards the contents, so call this between uses, never while
+     * element pointers are live.
+     *
+     * @param hugePages Advise the kernel to back the region with huge pages (Linux)
+     * @throws std::bad_alloc if the address space cannot be reserved
+     */
+    void reserve(size_t count, bool hugePages = false) {
+        if (count <= reserved) return;
+        release();
+        size_t bytes = roundToPage(count * sizeof(T));
+#if defined(_WIN32)
+        void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_READWRITE);
+        if (!p) throw std::bad_alloc();
+        (void)hugePages;
+#else
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        if (hugePages) huge = madvise(p, bytes, MADV_HUGEPAGE) == 0;
+#else
+        (void)hugePages;
+#endif
+#endif
+        base = static_cast<T*>(p);
+        reservedBytes = bytes;
+        reserved = bytes / sizeof(T);
+    }
+
+    /**
+     * @brief Makes the first `count` elements usable. Never moves existing elements.
+     * @throws std::bad_alloc if `count` exceeds the reservation or commit fails
+     */
+    void commit(size_t count) {
+        if (count <= committed) return;
+        if (count > reserved) throw std::bad_alloc();
+#if defined(_WIN32)
+        size_t bytes = std::min(roundToPage(count * sizeof(T)), reservedBytes);
+        if (!VirtualAlloc(base, bytes, MEM_COMMIT, PAGE_READWRITE)) throw std::bad_alloc();
+        committed = bytes / sizeof(T);
+#else
+        // Anonymous pages are committed by the kernel on first touch
+        committed = count;
+#endif
+    }
+
+    T* data() { return base; }
+    const T* data() const { return base; }
+    T& operator[](size_t i) { return base[i]; }
+    const T& operator[](size_t i) const { return base[i]; }
+
+    size_t getReserved() const { return reserved; }
+    size_t getCommitted() const { return committed; }
+    bool usesHugePages() const { return huge; }
+
+private:
+    static size_t roundToPage(size_t bytes) {
+        const size_t page = size_t(2) << 20; // 2 MiB: huge-page aligned, and a multiple of every base page
+        return std::max(page, (bytes + page - 1) / page * page);
+    }
+
+    void release() {
+        if (!base) return;
+#if defined(_WIN32)
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        munmap(base, reservedBytes);
+#endif
+        base = nullptr;
+        reserved = committed = reservedBytes = 0;
+        huge = false;
+    }
+
+    T* base = nullptr;
+    size_t reserved = 0;      ///< Elements of address space reserved
+    size_t committed = 0;     ///< Elements usable without another commit
+    size_t reservedBytes = 0;
+    bool huge = false;
+};
+
+} // namespace SolarSim
@@ -6,7 +6,11 @@
 #include <numeric>
 #include <iomanip>
 #include <string>
+#include <functional>
 #include "PhysicsEngine.hpp"
+#include "ParticleMesh.hpp"
+#include "Integrators.hpp"
+#include "SpatialOrder.hpp"
 #include "Body.hpp"
 
 /**
@@ -27,6 +31,11 @@ struct BenchmarkResult {
     double totalS;
 };
 
+using Verlet = SolarSim::VerletIntegrator;
+using RK4 = SolarSim::RK4Integrator;
+using Direct = SolarSim::DirectForce;
+using BarnesHut = SolarSim::BarnesHutForce;
+
 std::vector<SolarSim::Body> createTestBodies(int n) {
     std::vector<SolarSim::Body> bodies;
     bodies.reserve(n);
@@ -40,40 +49,36 @@ std::vector<SolarSim::Body> createTestBodies(int n) {
     return bodies;
 }
 
-BenchmarkResult runBenchmark(const std::string& method, int nBodies, int steps, int warmupRuns = 3, int measureRuns = 5) {
+/**
+ * @brief Times `steps` sub-steps of one integrator/solver pairing.
+ * 
+ * The pairing is a template argument, so the timed region contains only the
+ * kernels: one `advance` call per run with no per-step dispatch. `configure`
+ * optionally adjusts the solver (e.g. precision mode) before the first run.
+ */
+template <typename Integrator, typename ForceModel>
+BenchmarkResult runBenchmark(const std::string& method, int nBodies, int steps, int warmupRuns = 3, int measureRuns = 5,
+                             const std::function<void(ForceModel&)>& configure = {}) {
+    const double dt = 0.01;
     std::vector<double> timings;
     timings.reserve(measureRuns);
+    ForceModel force;
+    if (configure) configure(force);
     
     // Warmup runs (not measured)
     for (int w = 0; w < warmupRuns; ++w) {
         auto bodies = createTestBodies(nBodies);
-        SolarSim::PhysicsEngine::calculateAccelerations(bodies);
-        for (int i = 0; i < steps / 2; ++i) {
-            if (method == "Verlet") {
-                SolarSim::PhysicsEngine::stepVerlet(bodies, 0.01);
-            } else if (method == "RK4") {
-                SolarSim::PhysicsEngine::stepRK4(bodies, 0.01);
-            } else if (method == "BarnesHut") {
-                SolarSim::PhysicsEngine::stepBarnesHut(bodies, 0.01, 0.5);
-            }
-        }
+        SolarSim::PhysicsEngine::calculateAccelerations(bodies, force);
+        SolarSim::advance<Integrator>(bodies, force, dt * (steps / 2), dt);
     }
     
     // Measurement runs
     for (int r = 0; r < measureRuns; ++r) {
         auto bodies = createTestBodies(nBodies);
-        SolarSim::PhysicsEngine::calculateAccelerations(bodies);
+        SolarSim::PhysicsEngine::calculateAccelerations(bodies, force);
         
         auto start = std::chrono::high_resolution_clock::now();
-        for (int i = 0; i < steps; ++i) {
-            if (method == "Verlet") {
-                SolarSim::PhysicsEngine::stepVerlet(bodies, 0.01);
-            } else if (method == "RK4") {
-                SolarSim::PhysicsEngine::stepRK4(bodies, 0.01);
-            } else if (method == "BarnesHut") {
-                SolarSim::PhysicsEngine::stepBarnesHut(bodies, 0.01, 0.5);
-            }
-        }
+        SolarSim::advance<Integrator>(bodies, force, dt * steps, dt);
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> diff = end - start;
         timings.push_back(diff.count() / steps);
@@ -93,6 +98,84 @@ BenchmarkResult runBenchmark(const std::string& method, int nBodies, int steps,
     return {method, nBodies, steps, minT, maxT, avg, stddev, sum * steps / 1000.0};
 }
 
+/**
+ * @brief Times the collision sweep on a disk stored in scattered vs Morton order.
+ * 
+ * Same bodies; only the memory order of the body store differs. Barnes-Hut is
+ * not compared: the octree copies bodies into tree order itself.
+ */
+void runBodyOrderComparison(int nBodies, int sweeps) {
+    std::vector<SolarSim::Body> disk;
+    disk.reserve(nBodies);
+    for (int i = 0; i < nBodies; ++i) {
+        // Multiplicative hashing scatters spatial neighbours across the array
+        double u = ((i * 2654435761u) % 100003) / 100003.0;
+        double a = ((i * 40503u) % 65521) / 65521.0 * 2.0 * 3.14159265359;
+        double r = 0.5 + 4.5 * u;
+        disk.push_back(SolarSim::Body("Body", 1e-9, 1e-6, SolarSim::Vector3(r * std::cos(a), r * std::sin(a), 0.01 * (u - 0.5))));
+    }
+    
+    auto timeSweeps = [&](const std::vector<SolarSim::Body>& bodies) {
+        std::vector<SolarSim::Vector3> positions;
+        std::vector<double> radii;
+        for (const auto& b : bodies) {
+            positions.push_back(b.position);
+            radii.push_back(b.radius);
+        }
+        std::vector<int> order;
+        SolarSim::PhysicsEngine::detectCollisions(positions, radii, order); // Initial full sort
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int s = 0; s < sweeps; ++s) {
+            for (auto& p : positions) p.x += 1e-9;
+            SolarSim::PhysicsEngine::detectCollisions(positions, radii, order);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / sweeps;
+    };
+    
+    double scattered = timeSweeps(disk);
+    std::vector<int> remap;
+    SolarSim::reorderBodiesMorton(disk, remap);
+    double morton = timeSweeps(disk);
+    
+    std::cout << std::setw(7) << nBodies << " bodies | scattered: " << std::fixed << std::setprecision(3)
+              << std::setw(8) << scattered << " ms/sweep | morton: " << std::setw(8) << morton
+              << " ms/sweep | " << std::setprecision(2) << scattered / morton << "x" << std::endl;
+}
+
+/**
+ * @brief One force evaluation of Barnes-Hut vs particle-mesh on a thick disk.
+ */
+void runParticleMeshComparison(int nBodies, int gridSize) {
+    std::vector<SolarSim::Vector3> positions(nBodies);
+    std::vector<double> masses(nBodies, 1.0 / nBodies);
+    for (int i = 0; i < nBodies; ++i) {
+        double u = ((i * 2654435761u) % 100003) / 100003.0;
+        double a = ((i * 40503u) % 65521) / 65521.0 * 2.0 * 3.14159265359;
+        double h = ((i * 69069u) % 10007) / 10007.0 - 0.5;
+        double r = 50.0 * u;
+        positions[i] = SolarSim::Vector3(r * std::cos(a), r * std::sin(a), 2.0 * h);
+    }
+    std::vector<SolarSim::Vector3> acc;
+    
+    auto timeOnce = [&](SolarSim::ForceProvider& force) {
+        auto start = std::chrono::high_resolution_clock::now();
+        force.computeAccelerations(positions, masses, acc);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+    
+    BarnesHut bh;
+    bh.setSimdTraversal(true);
+    SolarSim::ParticleMeshForce pm(gridSize);
+    double bhMs = timeOnce(bh);
+    double pmMs = timeOnce(pm);
+    
+    std::cout << std::setw(8) << nBodies << " bodies | Barnes-Hut: " << std::fixed << std::setprecision(1)
+              << std::setw(9) << bhMs << " ms | PM " << gridSize << "^3: " << std::setw(8) << pmMs
+              << " ms | " << std::setprecision(1) << bhMs / pmMs << "x" << std::endl;
+}
+
 void printResult(const BenchmarkResult& r) {
     std::cout << std::setw(12) << r.name 
               << " | " << std::setw(6) << r.bodies << " bodies"
@@ -115,24 +198,59 @@ int main() {
     
     // Standard benchmarks
     std::cout << "--- Standard Benchmarks (100-500 bodies) ---" << std::endl;
-    results.push_back(runBenchmark("Verlet", 100, 100));
+    results.push_back(runBenchmark<Verlet, Direct>("Verlet", 100, 100));
     printResult(results.back());
-    results.push_back(runBenchmark("RK4", 100, 100));
+    results.push_back(runBenchmark<RK4, Direct>("RK4", 100, 100));
     printResult(results.back());
-    results.push_back(runBenchmark("BarnesHut", 100, 100));
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BarnesHut", 100, 100));
     printResult(results.back());
-    results.push_back(runBenchmark("Verlet", 500, 50));
+    results.push_back(runBenchmark<Verlet, Direct>("Verlet", 500, 50));
     printResult(results.back());
-    results.push_back(runBenchmark("BarnesHut", 500, 50));
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BarnesHut", 500, 50));
     printResult(results.back());
     
     std::cout << std::endl;
     std::cout << "--- Stress Test (1000+ bodies) ---" << std::endl;
-    results.push_back(runBenchmark("Verlet", 1000, 20));
+    results.push_back(runBenchmark<Verlet, Direct>("Verlet", 1000, 20));
     printResult(results.back());
-    results.push_back(runBenchmark("BarnesHut", 1000, 20));
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BarnesHut", 1000, 20));
     printResult(results.back());
-    results.push_back(runBenchmark("BarnesHut", 2000, 10));
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BarnesHut", 2000, 10));
+    printResult(results.back());
+    
+    std::cout << std::endl;
+    std::cout << "--- Force Provider Comparison (Verlet, 1000 bodies) ---" << std::endl;
+    results.push_back(runBenchmark<Verlet, Direct>("Direct", 1000, 20));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, SolarSim::DirectSimdForce>("DirectSIMD", 1000, 20));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, SolarSim::DirectSimdForceF>("DirectSIMD-F", 1000, 20));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, SolarSim::ThreadedDirectForce>("Threaded", 1000, 20));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, SolarSim::ThreadedDirectForceF>("Threaded-F", 1000, 20));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BarnesHut", 1000, 20));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BH SIMD-MAC", 1000, 20, 3, 5,
+                                                      [](BarnesHut& f) { f.setSimdTraversal(true); }));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BH Reuse8", 1000, 20, 3, 5,
+                                                      [](BarnesHut& f) { f.setTreeReuse(8); }));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BH ListCache", 1000, 20, 3, 5,
+                                                      [](BarnesHut& f) { f.setTreeReuse(8); f.setInteractionCaching(true); }));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BH ListMixed", 1000, 20, 3, 5, [](BarnesHut& f) {
+        f.setTreeReuse(8);
+        f.setInteractionCaching(true);
+        f.setMixedPrecision(true);
+    }));
+    printResult(results.back());
+    results.push_back(runBenchmark<Verlet, BarnesHut>("BH Relative", 1000, 20, 3, 5,
+                                                      [](BarnesHut& f) { f.setOpeningCriterion(SolarSim::OpeningCriterion::Relative); }));
+    printResult(results.back());
+    results.push_back(runBenchmark<RK4, BarnesHut>("RK4+BH", 1000, 20));
     printResult(results.back());
     
     std::cout << std::endl;
@@ -140,8 +258,8 @@ int main() {
     std::cout << "Bodies | Verlet (ms/step) | Barnes-Hut (ms/step) | Speedup" << std::endl;
     std::cout << "-------|------------------|----------------------|--------" << std::endl;
     for (int n : {100, 250, 500, 1000}) {
-        auto verlet = runBenchmark("Verlet", n, 20, 2, 3);
-        auto bh = runBenchmark("BarnesHut", n, 20, 2, 3);
+        auto verlet = runBenchmark<Verlet, Direct>("Verlet", n, 20, 2, 3);
+        auto bh = runBenchmark<Verlet, BarnesHut>("BarnesHut", n, 20, 2, 3);
         double speedup = verlet.avgMs / bh.avgMs;
         std::cout << std::setw(6) << n << " | " 
                   << std::setw(16) << std::fixed << std::setprecision(4) << verlet.avgMs << " | "
@@ -150,6 +268,17 @@ int main() {
                   << std::endl;
     }
     
+    std::cout << std::endl;
+    std::cout << "--- Body Store Order (collision sweep) ---" << std::endl;
+    runBodyOrderComparison(10000, 20);
+    runBodyOrderComparison(50000, 20);
+    runBodyOrderComparison(200000, 20);
+    
+    std::cout << std::endl;
+    std::cout << "--- Particle-Mesh vs Barnes-Hut (one force evaluation) ---" << std::endl;
+    runParticleMeshComparison(100000, 64);
+    runParticleMeshComparison(1000000, 128);
+    
     std::cout << std::endl;
     std::cout << "============================================================" << std::endl;
     std::cout << "Benchmark complete." << std::endl;
@@ -0,0 +1,365 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+#include <limits>
+#include "PhysicsEngine.hpp"
+#include "ParticleMesh.hpp"
+#include "Integrators.hpp"
+#include "SpatialOrder.hpp"
+#include "StateManager.hpp"
+#include "SystemData.hpp"
+#include "EphemerisLoader.hpp"
+#include "Checkpoint.hpp"
+#include "Trajectory.hpp"
+
+/**
+ * @brief Headless batch runner: no window, no GL context, no frame limiter.
+ *
+ * Loads a preset, a CSV state or a binary checkpoint, integrates a span of
+ * simulated time as fast as the solver allows, reports throughput, and writes
+ * the final state plus optional periodic states. Meant for servers without a
+ * display, e.g.
+ *
+ *     SolarSimHeadless --preset full --years 100 --integrator verlet --every 10 --output run/final.ssck
+ *
+ * Outputs ending in `.ssck` are checkpoints (see `Checkpoint`); resuming from
+ * one restores time, solver settings and RNG state, and continues bit-exactly.
+ * `--record` streams a trajectory (see `TrajectoryWriter`) alongside the run.
+ */
+
+namespace {
+
+struct Options {
+    std::string preset = "full";
+    std::string stateFile;              ///< Overrides the preset when set
+    int asteroids = 0;                  ///< Belt bodies added at 2.2-3.2 AU
+    double years = 1.0;
+    double maxDt = 1.0 / 365.25;        ///< Largest sub-step (1 day)
+    bool fixedStep = false;             ///< Skip the O(N^2) adaptive timestep
+    std::string integrator = "verlet";
+    bool singlePrecision = false;
+    double theta = 0.5;
+    int grid = 64;
+    double every = 0.0;                 ///< Years between periodic states (0 = none)
+    std::string output = "headless_final.csv";
+    std::string record;                 ///< Trajectory file (empty = none)
+    double recordEvery = 0.0;           ///< Years between trajectory frames (0 = every --dt)
+    int asteroidStride = 1;             ///< Asteroids go into every Nth trajectory frame
+    double recordTolerance = 0.0;       ///< Quantize the trajectory to this error (0 = lossless)
+    std::set<std::string> given;        ///< Options set on the command line
+};
+
+const char* INTEGRATORS[] = { "verlet", "rk4", "barnes-hut", "particle-mesh" };
+
+struct RunStats {
+    long long steps = 0;
+    long long bodySteps = 0;
+    double seconds = 0.0;
+};
+
+void printUsage() {
+    std::cout <<
+        "Usage: SolarSimHeadless [options]\n"
+        "  --preset NAME       full | inner | outer | earth-moon | binary (default: full)\n"
+        "  --state FILE        Start from a CSV state or .ssck checkpoint instead of a preset\n"
+        "  --asteroids N       Add N belt asteroids (2.2-3.2 AU)\n"
+        "  --years Y           Simulated span in years (default: 1)\n"
+        "  --dt D              Largest sub-step in years (default: 1 day)\n"
+        "  --fixed             Always step at --dt (skips the O(N^2) adaptive step)\n"
+        "  --integrator NAME   verlet | rk4 | barnes-hut | particle-mesh (default: verlet)\n"
+        "  --single            Direct-sum runs in single precision (verlet/rk4)\n"
+        "  --theta T           Barnes-Hut opening angle (default: 0.5)\n"
+        "  --grid N            Particle-mesh grid size, power of two (default: 64)\n"
+        "  --every Y           Also write a state every Y years\n"
+        "  --output FILE       Final state; .ssck writes binary checkpoints (default: headless_final.csv)\n"
+        "  --record FILE       Stream a .sstraj trajectory while running\n"
+        "  --record-every Y    Years between trajectory frames (default: --dt)\n"
+        "  --asteroid-stride N Record asteroids in every Nth frame only (default: 1)\n"
+        "  --record-tolerance E  Lossy trajectory: positions within E AU, velocities within E AU/yr\n";
+}
+
+bool parseArgs(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const char* name) -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument(std::string("missing value for ") + name);
+            return argv[++i];
+        };
+        if (arg == "--help" || arg == "-h") { printUsage(); return false; }
+        else if (arg == "--preset") opt.preset = value("--preset");
+        else if (arg == "--state") opt.stateFile = value("--state");
+        else if (arg == "--asteroids") opt.asteroids = std::stoi(value("--asteroids"));
+        else if (arg == "--years") opt.years = std::stod(value("--years"));
+        else if (arg == "--dt") opt.maxDt = std::stod(value("--dt"));
+        else if (arg == "--fixed") opt.fixedStep = true;
+        else if (arg == "--integrator") opt.integrator = value("--integrator");
+        else if (arg == "--single") opt.singlePrecision = true;
+        else if (arg == "--theta") opt.theta = std::stod(value("--theta"));
+        else if (arg == "--grid") opt.grid = std::stoi(value("--grid"));
+        else if (arg == "--every") opt.every = std::stod(value("--every"));
+        else if (arg == "--output") opt.output = value("--output");
+        else if (arg == "--record") opt.record = value("--record");
+        else if (arg == "--record-every") opt.recordEvery = std::stod(value("--record-every"));
+        else if (arg == "--asteroid-stride") opt.asteroidStride = std::stoi(value("--asteroid-stride"));
+        else if (arg == "--record-tolerance") opt.recordTolerance = std::stod(value("--record-tolerance"));
+        else throw std::invalid_argument("unknown option " + arg);
+        opt.given.insert(arg);
+    }
+    if (opt.years <= 0.0 || opt.maxDt <= 0.0) throw std::invalid_argument("--years and --dt must be positive");
+    if (opt.recordEvery < 0.0 || opt.asteroidStride < 1 || opt.recordTolerance < 0.0) throw std::invalid_argument("invalid recording interval or stride");
+    return true;
+}
+
+SolarSim::SimulationConfig toConfig(const Options& opt) {
+    SolarSim::SimulationConfig c;
+    c.integrator = (int32_t)(std::find(std::begin(INTEGRATORS), std::end(INTEGRATORS), opt.integrator) - std::begin(INTEGRATORS));
+    c.singlePrecision = opt.singlePrecision;
+    c.gridSize = opt.grid;
+    c.fixedStep = opt.fixedStep;
+    c.theta = opt.theta;
+    c.maxStep = opt.maxDt;
+    return c;
+}
+
+/**
+ * @brief Takes the solver settings of a resumed checkpoint, except those given on the command line.
+ */
+void applyConfig(const SolarSim::SimulationConfig& c, Options& opt) {
+    auto keep = [&opt](const char* flag) { return opt.given.count(flag) != 0; };
+    if (!keep("--integrator") && c.integrator >= 0 && c.integrator < 4) opt.integrator = INTEGRATORS[c.integrator];
+    if (!keep("--single")) opt.singlePrecision = c.singlePrecision != 0;
+    if (!keep("--grid")) opt.grid = c.gridSize;
+    if (!keep("--fixed")) opt.fixedStep = c.fixedStep != 0;
+    if (!keep("--theta")) opt.theta = c.theta;
+    if (!keep("--dt")) opt.maxDt = c.maxStep;
+}
+
+std::vector<SolarSim::Body> loadBodies(Options& opt, std::mt19937_64& rng, SolarSim::CheckpointMeta& meta, bool& resumed) {
+    using SolarSim::PresetType;
+    std::vector<SolarSim::Body> bodies;
+    resumed = false;
+    if (!opt.stateFile.empty() && SolarSim::Checkpoint::isCheckpoint(opt.stateFile)) {
+        if (!SolarSim::loadCheckpoint(opt.stateFile, bodies, meta)) throw std::runtime_error("cannot resume from " + opt.stateFile);
+        applyConfig(meta.config, opt);
+        meta.restoreRng(rng);
+        resumed = true;
+    }
+    else if (!opt.stateFile.empty()) bodies = SolarSim::StateManager::loadState(opt.stateFile);
+    else if (opt.preset == "full") bodies = SolarSim::EphemerisLoader::loadSolarSystemJ2000();
+    else if (opt.preset == "inner") bodies = SolarSim::StateManager::loadPreset(PresetType::InnerPlanets);
+    else if (opt.preset == "outer") bodies = SolarSim::StateManager::loadPreset(PresetType::OuterGiants);
+    else if (opt.preset == "earth-moon") bodies = SolarSim::StateManager::loadPreset(PresetType::EarthMoonSystem);
+    else if (opt.preset == "binary") bodies = SolarSim::StateManager::loadPreset(PresetType::BinaryStarTest);
+    else throw std::invalid_argument("unknown preset " + opt.preset);
+
+    // Same belt as the interactive app, but seeded (and checkpointed) so runs are reproducible
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (int i = 0; i < opt.asteroids; ++i) {
+        double d = 2.2 + u(rng) * 1.0;
+        double a = u(rng) * 2.0 * M_PI;
+        double v = std::sqrt(39.478 / d);
+        bodies.emplace_back("Asteroid", 1e-10, 0.0001,
+                            SolarSim::Vector3(d * std::cos(a), d * std::sin(a), (u(rng) - 0.5) * 0.2),
+                            SolarSim::Vector3(-v * std::sin(a), v * std::cos(a), 0));
+    }
+    return bodies;
+}
+
+bool writeState(const std::vector<SolarSim::Body>& bodies, const SolarSim::CheckpointMeta& meta, const std::string& name) {
+    if (SolarSim::Checkpoint::hasExtension(name)) return SolarSim::Checkpoint::save(bodies, meta, name);
+    return SolarSim::StateManager::saveState(bodies, name);
+}
+
+std::string periodicName(const std::string& output, int index) {
+    std::string stem = output, ext;
+    size_t dot = output.find_last_of('.');
+    size_t slash = output.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        stem = output.substr(0, dot);
+        ext = output.substr(dot);
+    }
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_%04d", index);
+    return stem + suffix + ext;
+}
+
+// Barnes-Hut copies bodies into tree order itself; only the collision sweep gains from a reorder
+bool reordersBodies(const SolarSim::BarnesHutForce&) { return false; }
+template <typename ForceModel>
+bool reordersBodies(const ForceModel&) { return true; }
+
+/**
+ * @brief Integrates `opt.years`, writing periodic states and trajectory frames along the way.
+ *
+ * The span is cut into slices of at most 32 sub-steps so the adaptive timestep
+ * is refreshed regularly, like the per-frame refresh in the interactive loop.
+ * Trajectory frames split a slice further but reuse its timestep; without a
+ * recording the slices are exactly those of an unrecorded run.
+ * Large stores outside Barnes-Hut are Morton-reordered every `REORDER_STEPS`
+ * sub-steps of the run's global step count, which checkpoints carry, so a
+ * resumed run reorders (and therefore sums forces) in the same order as an
+ * uninterrupted one.
+ */
+template <typename Integrator, typename ForceModel>
+RunStats run(std::vector<SolarSim::Body>& bodies, ForceModel& force, const Options& opt, SolarSim::CheckpointMeta& meta,
+             SolarSim::TrajectoryWriter* recorder) {
+    constexpr int SLICE_STEPS = 32;
+    constexpr uint64_t REORDER_STEPS = 2048;
+    RunStats stats;
+    std::vector<int> remap;
+    const bool reorder = reordersBodies(force);
+    // Simulated time is absolute (a resumed run starts at its checkpoint's time), so slice
+    // spans, and therefore every sub-step, match an uninterrupted run with the same outputs
+    const double end = meta.elapsedYears + opt.years;
+    const double tolerance = 1e-12 * opt.years;
+    const double recordEvery = opt.recordEvery > 0.0 ? opt.recordEvery : opt.maxDt;
+    double t = meta.elapsedYears;
+    double nextOutput = opt.every > 0.0 ? t + opt.every : end;
+    double nextRecord = recorder ? t + recordEvery : std::numeric_limits<double>::max(); // -ffast-math: no infinities
+    int outputIndex = 0;
+    if (recorder) recorder->record(bodies, t);
+
+    auto start = std::chrono::steady_clock::now();
+    while (t < end - tolerance) {
+        double dt = opt.fixedStep ? opt.maxDt : SolarSim::PhysicsEngine::getAdaptiveTimestep(bodies, opt.maxDt);
+        double remaining = std::min(SLICE_STEPS * dt, std::min(nextOutput, end) - t);
+        do {
+            const double span = std::min(remaining, nextRecord - t);
+            const uint64_t epoch = meta.tick / REORDER_STEPS;
+            int steps = SolarSim::advance<Integrator>(bodies, force, span, dt);
+            stats.steps += steps;
+            stats.bodySteps += (long long)steps * (long long)bodies.size();
+            t += span;
+            remaining -= span;
+            meta.elapsedYears = t;
+            meta.tick += (uint64_t)steps;
+
+            if (reorder && bodies.size() >= SolarSim::MORTON_REORDER_MIN_BODIES && meta.tick / REORDER_STEPS != epoch &&
+                SolarSim::reorderBodiesMorton(bodies, remap)) {
+                SolarSim::remapIntegrationCaches(remap);
+            }
+            if (recorder && t >= nextRecord - tolerance) {
+                recorder->record(bodies, t);
+                nextRecord += recordEvery;
+            }
+        } while (remaining > tolerance);
+
+        if (opt.every > 0.0 && t >= nextOutput - tolerance && t < end - tolerance) {
+            std::string name = periodicName(opt.output, ++outputIndex);
+            writeState(bodies, meta, name);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  t = " << std::fixed << std::setprecision(3) << t << " yr  "
+                      << stats.steps << " steps  " << bodies.size() << " bodies  "
+                      << std::setprecision(1) << elapsed << " s  -> " << name << std::endl;
+            nextOutput += opt.every;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    std::vector<SolarSim::Body> bodies;
+    SolarSim::CheckpointMeta meta;
+    std::mt19937_64 rng(42);
+    bool resumed = false;
+    try {
+        if (!parseArgs(argc, argv, opt)) return 0;
+        bodies = loadBodies(opt, rng, meta, resumed);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+    if (bodies.empty()) {
+        std::cerr << "Error: no bodies loaded" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path outputDir = std::filesystem::path(opt.output).parent_path();
+    if (!outputDir.empty()) std::filesystem::create_directories(outputDir);
+
+    // A resumed checkpoint is already barycentric with current accelerations; touching it would break bit-exactness
+    if (!resumed) SolarSim::convertToBarycentric(bodies);
+    if (!resumed || opt.asteroids > 0) SolarSim::PhysicsEngine::calculateAccelerations(bodies);
+    meta.config = toConfig(opt);
+    meta.captureRng(rng);
+
+    const bool checkEnergy = bodies.size() <= 5000; // Energy is an O(N^2) sum
+    const double energy0 = checkEnergy ? SolarSim::PhysicsEngine::calculateTotalEnergy(bodies) : 0.0;
+    const size_t initialCount = bodies.size();
+    std::cout << "SolarSim headless: " << bodies.size() << " bodies, " << opt.years << " yr"
+              << (resumed ? " from t = " + std::to_string(meta.elapsedYears) : std::string()) << ", "
+              << opt.integrator << (opt.singlePrecision ? " (float)" : "") << std::endl;
+
+    SolarSim::TrajectoryWriter trajectory;
+    SolarSim::TrajectoryWriter* recorder = nullptr;
+    if (!opt.record.empty()) {
+        std::filesystem::path recordDir = std::filesystem::path(opt.record).parent_path();
+        if (!recordDir.empty()) std::filesystem::create_directories(recordDir);
+        auto strides = SolarSim::TrajectoryWriter::stridesByKind(bodies, (uint32_t)opt.asteroidStride);
+        if (opt.recordTolerance > 0.0) {
+            SolarSim::TrajectoryCodec::Settings codec;
+            codec.codec = SolarSim::TrajectoryFormat::Quantized;
+            codec.positionTolerance = codec.velocityTolerance = opt.recordTolerance;
+            trajectory.setCodec(codec);
+        }
+        if (!trajectory.open(opt.record, bodies, std::move(strides))) return 1;
+        recorder = &trajectory;
+    }
+
+    RunStats stats;
+    try {
+        if (opt.integrator == "verlet" || opt.integrator == "rk4") {
+            const bool rk4 = opt.integrator == "rk4";
+            if (opt.singlePrecision) {
+                SolarSim::DirectSimdForceF force;
+                stats = rk4 ? run<SolarSim::RK4Integrator>(bodies, force, opt, meta, recorder) : run<SolarSim::VerletIntegrator>(bodies, force, opt, meta, recorder);
+            } else {
+                SolarSim::DirectForce force;
+                stats = rk4 ? run<SolarSim::RK4Integrator>(bodies, force, opt, meta, recorder) : run<SolarSim::VerletIntegrator>(bodies, force, opt, meta, recorder);
+            }
+        } else if (opt.integrator == "barnes-hut") {
+            SolarSim::BarnesHutForce force(opt.theta);
+            force.setTreeReuse(8);
+            force.setSimdTraversal(true);
+            stats = run<SolarSim::VerletIntegrator>(bodies, force, opt, meta, recorder);
+        } else if (opt.integrator == "particle-mesh") {
+            SolarSim::ParticleMeshForce force(opt.grid);
+            stats = run<SolarSim::VerletIntegrator>(bodies, force, opt, meta, recorder);
+        } else {
+            throw std::invalid_argument("unknown integrator " + opt.integrator);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (recorder && !trajectory.close()) return 1;
+    if (!writeState(bodies, meta, opt.output)) return 1;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Finished " << stats.steps << " steps in " << stats.seconds << " s -> " << opt.output << std::endl
+              << "  Steps/s:      " << stats.steps / stats.seconds << std::endl
+              << "  Body-steps/s: " << std::scientific << std::setprecision(3) << stats.bodySteps / stats.seconds << std::endl;
+    if (bodies.size() != initialCount) {
+        std::cout << "  Bodies:       " << initialCount << " -> " << bodies.size() << " (merged)" << std::endl;
+    }
+    if (checkEnergy && energy0 != 0.0) {
+        double drift = std::abs((SolarSim::PhysicsEngine::calculateTotalEnergy(bodies) - energy0) / energy0);
+        std::cout << "  Energy drift: " << drift << std::endl;
+    }
+    return 0;
+}
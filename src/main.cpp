@@ -7,12 +7,15 @@
 #include <glm/glm.hpp>
 #include "GraphicsEngine.hpp"
 #include "PhysicsEngine.hpp"
+#include "SimulationThread.hpp"
+#include "FrameGovernor.hpp"
 #include "EphemerisLoader.hpp"
 #include "SystemData.hpp"
 #include "GuiEngine.hpp"
 #include "StateManager.hpp"
 
 #include <filesystem>
+#include <ctime>
 
 /**
  * @brief Captures the current window content and saves it to a file.
@@ -51,26 +54,26 @@ int main(int argc, char* argv[]) {
     std::cout << "Using J2000 Ephemeris Data for accurate orbital positions" << std::endl;
     
     // Load celestial bodies using real J2000 ephemeris data
-    std::vector<SolarSim::Body> system = SolarSim::EphemerisLoader::loadSolarSystemJ2000();
-    if (system.empty()) {
+    std::vector<SolarSim::Body> initialSystem = SolarSim::EphemerisLoader::loadSolarSystemJ2000();
+    if (initialSystem.empty()) {
         std::cerr << "Error: Failed to load ephemeris data" << std::endl;
         return 1;
     }
-    std::cout << "Loaded " << system.size() << " celestial bodies" << std::endl;
+    std::cout << "Loaded " << initialSystem.size() << " celestial bodies" << std::endl;
 
     // Add asteroid belt (100 asteroids for performance)
     for (int i = 0; i < 100; ++i) {
         double d = 2.2 + (double)rand()/RAND_MAX * 1.0;  // 2.2-3.2 AU
         double a = (double)rand()/RAND_MAX * 2.0 * M_PI;
         double v = std::sqrt(39.478 / d);  // Circular orbit velocity
-        system.emplace_back("Asteroid", 1e-10, 0.0001, 
+        initialSystem.emplace_back("Asteroid", 1e-10, 0.0001, 
                            SolarSim::Vector3(d*std::cos(a), d*std::sin(a), ((double)rand()/RAND_MAX-0.5)*0.2), 
                            SolarSim::Vector3(-v*std::sin(a), v*std::cos(a), 0));
     }
 
     // Convert to barycentric coordinates (zero total momentum)
-    SolarSim::convertToBarycentric(system);
-    SolarSim::PhysicsEngine::calculateAccelerations(system);
+    SolarSim::convertToBarycentric(initialSystem);
+    SolarSim::PhysicsEngine::calculateAccelerations(initialSystem);
 
     // Create SFML window with OpenGL 3.3 context
     sf::ContextSettings settings;
@@ -81,7 +84,8 @@ int main(int argc, char* argv[]) {
     
     sf::RenderWindow window(sf::VideoMode(1280, 720), "Solar System Simulation 3D", 
                             sf::Style::Default, settings);
-    window.setFramerateLimit(60);
+    const unsigned int frameLimit = 60;
+    window.setFramerateLimit(frameLimit);
     window.setActive(true);
     
     // Initialize GLAD for modern OpenGL functions
@@ -104,7 +108,86 @@ int main(int argc, char* argv[]) {
     float *scalePtr, *rotXPtr, *rotZPtr;
     graphics.exposeControls(scalePtr, rotXPtr, rotZPtr);
 
-    double baseDt = 1.0/365.25;  // 1 day in years
+    // 60 days per second at 1x, the pace of the former one-day-per-frame loop at 60 FPS
+    const double yearsPerSecond = 60.0 / 365.25;
+
+    // Physics runs on its own thread with a fixed 30 Hz timestep. The render loop
+    // only reads the newest snapshot into a render-side copy of the bodies,
+    // interpolates between ticks, and sends GUI changes back as commands.
+    SolarSim::SimulationThread simulation(std::move(initialSystem), yearsPerSecond, 30.0);
+    SolarSim::RenderMirror mirror;
+    simulation.snapshots().fetch();
+    mirror.apply(simulation.snapshots().front(), false);
+    std::vector<SolarSim::Body>& system = mirror.bodies;
+
+    // Holds the 30 FPS floor by stepping quality levers up and down at runtime
+    SolarSim::FrameGovernor governor(30.0);
+    governor.setFrameLimit(frameLimit);
+    double lastTickMs = 0.0, tickBudgetMs = 0.0;
+
+    // Settings last sent to the simulation thread; GUI and governor changes are diffed against these
+    struct SentSettings {
+        bool paused; float timeRate; int integrator; bool singlePrecision; int openingCriterion; float forceAccuracy;
+        double theta; int maxSubsteps; bool recording;
+    } sent = { false, 1.0f, -1, false, -1, 0.0f, -1.0, -1, false };
+    auto syncSettings = [&simulation, &sent, &governor](SolarSim::GuiEngine::SimulationState& state) {
+        using Cmd = SolarSim::SimulationCommand;
+        auto post = [&simulation](Cmd::Type type, int option, double value = 0.0) {
+            Cmd c;
+            c.type = type; c.option = option; c.value = value;
+            return simulation.post(std::move(c)); // A full queue retries next frame
+        };
+        const bool paused = state.paused || state.replay; // The simulation waits while a recording is replayed
+        if (paused != sent.paused && post(Cmd::Type::SetPaused, paused)) sent.paused = paused;
+        if (state.timeRate != sent.timeRate && post(Cmd::Type::SetTimeRate, 0, state.timeRate)) sent.timeRate = state.timeRate;
+        if (state.integrator != sent.integrator && post(Cmd::Type::SetIntegrator, state.integrator)) sent.integrator = state.integrator;
+        if (state.singlePrecision != sent.singlePrecision && post(Cmd::Type::SetSinglePrecision, state.singlePrecision)) {
+            sent.singlePrecision = state.singlePrecision;
+        }
+        if ((state.openingCriterion != sent.openingCriterion || state.forceAccuracy != sent.forceAccuracy) &&
+            post(Cmd::Type::SetOpeningCriterion, state.openingCriterion, state.forceAccuracy)) {
+            sent.openingCriterion = state.openingCriterion;
+            sent.forceAccuracy = state.forceAccuracy;
+        }
+        if (governor.getTheta() != sent.theta && post(Cmd::Type::SetTheta, 0, governor.getTheta())) {
+            sent.theta = governor.getTheta();
+        }
+        if (governor.getMaxSubsteps() != sent.maxSubsteps && post(Cmd::Type::SetSubstepBudget, governor.getMaxSubsteps())) {
+            sent.maxSubsteps = governor.getMaxSubsteps();
+        }
+        if (state.requestTimeReset && post(Cmd::Type::ResetTime, 0)) state.requestTimeReset = false;
+        if (state.requestRewind && post(Cmd::Type::Rewind, 0, state.rewindYears)) {
+            state.requestRewind = false;
+            state.recording = false; // The rewind ends it: recorded times cannot run backwards
+        }
+        if (state.recording != sent.recording) {
+            Cmd c;
+            c.type = state.recording ? Cmd::Type::StartRecording : Cmd::Type::StopRecording;
+            c.option = 10; // Planets every tick, asteroids every 10th
+            if (state.recording) {
+                std::filesystem::create_directories("recordings");
+                char filename[64];
+                std::snprintf(filename, sizeof(filename), "recordings/trajectory_%lld.sstraj",
+                              (long long)std::time(nullptr));
+                c.filename = filename;
+                state.lastRecording = filename;
+            }
+            if (simulation.post(std::move(c))) sent.recording = state.recording;
+        }
+        if (state.presetRequest >= 0 && post(Cmd::Type::LoadPreset, state.presetRequest)) state.presetRequest = -1;
+        if (state.requestSave || state.requestLoad) {
+            Cmd c;
+            c.type = state.requestSave ? Cmd::Type::SaveState : Cmd::Type::LoadState;
+            c.filename = state.saveFilename;
+            if (simulation.post(std::move(c))) {
+                if (state.requestSave) state.requestSave = false;
+                else state.requestLoad = false;
+            }
+        }
+    };
+    syncSettings(SolarSim::GuiEngine::getState());
+    simulation.start();
+
     sf::Clock deltaClock;
     sf::Clock fpsClock;
     int frameCount = 0;
@@ -115,6 +198,13 @@ int main(int argc, char* argv[]) {
     int videoFramesCaptured = 0;
     const int MAX_VIDEO_FRAMES = 60;
 
+    // Replay of the last recording: its bodies stand in for the live ones while scrubbing
+    SolarSim::TrajectoryReader replay;
+    SolarSim::TrajectoryReader::Sample replaySample;
+    std::vector<SolarSim::Body> liveBodies;
+    bool replaying = false;
+    float replayShownYears = -1.0f;
+
     // Set default body selection to Sun
     for (int i = 0; i < (int)system.size(); ++i) {
         if (system[i].name == "Sun") {
@@ -125,6 +215,8 @@ int main(int argc, char* argv[]) {
     
 
     while (window.isOpen()) {
+        auto frameStart = std::chrono::steady_clock::now();
+
         // Event handling
         sf::Event event;
         while (window.pollEvent(event)) {
@@ -144,6 +236,17 @@ int main(int argc, char* argv[]) {
                     if (event.key.code == sf::Keyboard::Space) state.paused = !state.paused;
                     else if (event.key.code == sf::Keyboard::T) state.showTrails = !state.showTrails;
                     else if (event.key.code == sf::Keyboard::H) state.showHelp = !state.showHelp;
+                    else if (event.key.code == sf::Keyboard::R) {
+                        state.recording = !state.recording;
+                        SolarSim::GuiEngine::addToast(state.recording ? "Recording trajectory" : "Recording saved to recordings/",
+                                                      SolarSim::GuiEngine::ToastType::Info);
+                    }
+                    else if (event.key.code == sf::Keyboard::P && !state.lastRecording.empty() && !state.recording) {
+                        state.replay = !state.replay;
+                    }
+                    else if (event.key.code == sf::Keyboard::Backspace && !state.replay && !state.rewinding) {
+                        state.requestRewind = true;
+                    }
                 }
             }
 
@@ -299,39 +402,111 @@ int main(int argc, char* argv[]) {
         }
 
 
-        // Physics
-        if (!guiState.paused) {
-            double frameTime = baseDt * guiState.timeRate;
-            double currentT = 0;
-            
-            // Optimization: Get adaptive timestep once per frame loop if bodies are few/stable
-            // For 100+ bodies, O(N^2) every sub-step is a massive bottleneck.
-            double adt = SolarSim::PhysicsEngine::getAdaptiveTimestep(system, baseDt);
-
-            while (currentT < frameTime) {
-                double stepDt = std::min(adt, frameTime - currentT);
-                switch (guiState.integrator) {
-                    case 0: SolarSim::PhysicsEngine::stepVerlet(system, stepDt); break;
-                    case 1: SolarSim::PhysicsEngine::stepRK4(system, stepDt); break;
-                    case 2: SolarSim::PhysicsEngine::stepBarnesHut(system, stepDt, 0.5); break;
-                }
-                currentT += stepDt;
+        // Replay: enter and leave by swapping the recorded bodies with the live ones
+        if (guiState.replay && !replaying) {
+            if (replay.open(guiState.lastRecording) && replay.getFrameCount() > 0) {
+                liveBodies = replay.catalogBodies();
+                std::swap(system, liveBodies);
+                guiState.replayStart = (float)replay.getStartTime();
+                guiState.replayEnd = (float)replay.getEndTime();
+                guiState.replayYears = guiState.replayStart;
+                replayShownYears = -1.0f;
+                replaying = true;
+            } else {
+                guiState.replay = false;
+                SolarSim::GuiEngine::addToast("Recording could not be opened", SolarSim::GuiEngine::ToastType::Error);
             }
-            guiState.elapsedYears += (float)frameTime;
+        } else if (!guiState.replay && replaying) {
+            std::swap(system, liveBodies);
+            liveBodies.clear();
+            replay.close();
+            replaying = false;
+        }
+        if (guiState.selectedBody >= (int)system.size() || guiState.lastSelectedBody >= (int)system.size()) {
+            guiState.selectedBody = 0;
+            guiState.lastSelectedBody = -1;
+        }
 
-            // Update trails once per frame instead of every sub-step
-            if (guiState.showTrails) {
-                for (auto& b : system) b.updateTrail();
+        // Physics: forward GUI changes, then pick up the newest published tick
+        syncSettings(guiState);
+        if (replaying) {
+            if (!guiState.paused) {
+                guiState.replayYears = std::min(guiState.replayYears + (float)(dtSec * yearsPerSecond * guiState.timeRate),
+                                                guiState.replayEnd);
             }
+            // One chunk decode at most per scrub: milliseconds even for long recordings
+            if (guiState.replayYears != replayShownYears && replay.sample(guiState.replayYears, replaySample)) {
+                for (size_t k = 0; k < replaySample.slots.size(); ++k) {
+                    if (SolarSim::TrajectoryFormat::isMissing(replaySample.positions[k].x)) continue; // Merged away
+                    SolarSim::Body& b = system[replaySample.slots[k]];
+                    b.position = replaySample.positions[k];
+                    b.velocity = replaySample.velocities[k];
+                }
+                replayShownYears = guiState.replayYears;
+            }
+            guiState.elapsedYears = guiState.replayYears;
+        } else if (simulation.snapshots().fetch()) {
+            const SolarSim::RenderSnapshot& snapshot = simulation.snapshots().front();
+            uint32_t selectedId = (guiState.selectedBody >= 0 && guiState.selectedBody < (int)system.size())
+                                      ? system[guiState.selectedBody].id : UINT32_MAX;
+            uint32_t lastSelectedId = (guiState.lastSelectedBody >= 0 && guiState.lastSelectedBody < (int)system.size())
+                                          ? system[guiState.lastSelectedBody].id : UINT32_MAX;
+            if (mirror.apply(snapshot, guiState.showTrails)) {
+                // Merges, reorders and loads change indices: follow the selection by id
+                int selected = SolarSim::findBodyById(system, selectedId);
+                guiState.selectedBody = selected >= 0 ? selected : 0;
+                if (guiState.lastSelectedBody >= 0) {
+                    int last = SolarSim::findBodyById(system, lastSelectedId);
+                    guiState.lastSelectedBody = last >= 0 ? last : -1;
+                }
+            }
+            guiState.elapsedYears = (float)snapshot.elapsedYears;
+            if (snapshot.rewinding && !guiState.rewinding) {
+                SolarSim::GuiEngine::addToast("Rewinding...", SolarSim::GuiEngine::ToastType::Info);
+            }
+            guiState.rewinding = snapshot.rewinding;
+            guiState.historyStart = (float)snapshot.historyStart;
+            lastTickMs = snapshot.tickMs;
+            tickBudgetMs = snapshot.tickSeconds * 1000.0;
         }
+        if (!replaying) mirror.interpolate(std::chrono::steady_clock::now());
 
+        auto renderStart = std::chrono::steady_clock::now();
+        graphics.setSphereSegments(governor.getSphereSegments());
+        graphics.setTrailStride(governor.getTrailStride());
         graphics.render(system, guiState.showTrails, guiState.showPlanetOrbits, guiState.showOtherOrbits, guiState.debugUV);
         SolarSim::GuiEngine::renderLabels(system, graphics.getViewProjectionMatrix(), window.getSize());
+        auto guiStart = std::chrono::steady_clock::now();
         SolarSim::GuiEngine::render(system, scalePtr, rotXPtr, rotZPtr);
         SolarSim::GuiEngine::display(window);
+        auto guiEnd = std::chrono::steady_clock::now();
         window.display();
+
+        // Frame-budget governor: this frame's costs steer the next frame's levers
+        using Ms = std::chrono::duration<double, std::milli>;
+        SolarSim::FrameSample sample;
+        sample.frameMs = Ms(std::chrono::steady_clock::now() - frameStart).count();
+        sample.renderMs = Ms(guiStart - renderStart).count();
+        sample.guiMs = Ms(guiEnd - guiStart).count();
+        sample.physicsMs = guiState.paused ? 0.0 : lastTickMs;
+        sample.physicsBudgetMs = tickBudgetMs;
+        if (!guiState.autoQuality && governor.isEnabled()) governor.reset();
+        governor.setEnabled(guiState.autoQuality);
+        governor.setLeverAvailable(SolarSim::FrameGovernor::Theta, guiState.integrator == 2 && guiState.openingCriterion == 0);
+        governor.update(sample);
+
+        guiState.frameMs = (float)governor.getFrameMs();
+        guiState.renderMs = (float)governor.getRenderMs();
+        guiState.physicsMs = (float)governor.getPhysicsMs();
+        char levels[160];
+        snprintf(levels, sizeof(levels), "Spheres %dx%d, trail 1/%d, theta %.1f, sub-steps %s",
+                 governor.getSphereSegments(), governor.getSphereSegments(), governor.getTrailStride(), governor.getTheta(),
+                 governor.getMaxSubsteps() > 0 ? std::to_string(governor.getMaxSubsteps()).c_str() : "adaptive");
+        guiState.qualityLevels = levels;
+        guiState.qualityDecision = governor.getLastDecision();
     }
 
+    simulation.stop();
     SolarSim::GuiEngine::shutdown();
     return 0;
 }
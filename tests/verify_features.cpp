@@ -9,9 +9,48 @@
 #include "StateManager.hpp"
 #include "SystemData.hpp"
 #include "EphemerisLoader.hpp"
+#include "Integrators.hpp"
+#include "SpatialOrder.hpp"
+#include "SimulationThread.hpp"
+#include "FrameGovernor.hpp"
+#include "Checkpoint.hpp"
+#include "Trajectory.hpp"
+#include "HistoryManager.hpp"
+#include <cstring>
+#include <cstdio>
 
 using namespace SolarSim;
 
+// =============================================================================
+// Shared Fixtures
+// =============================================================================
+
+/**
+ * @brief J2000 Solar System plus `n` belt asteroids between 2.2 and 3.2 AU.
+ *
+ * The belt gives Barnes-Hut many accepted far-field nodes and full leaves.
+ * With `withVelocities` the asteroids move on circular orbits, otherwise they
+ * are at rest (force-only tests).
+ */
+std::vector<Body> makeBeltScene(int n, bool withVelocities) {
+    auto bodies = EphemerisLoader::loadSolarSystemJ2000();
+    for (int i = 0; i < n; ++i) {
+        double d = 2.2 + (i % 50) * 0.02;
+        double a = i * 0.0917;
+        double v = withVelocities ? 2.0 * M_PI / std::sqrt(d) : 0.0;
+        bodies.push_back(Body("Asteroid", 1e-10, 1e-6, Vector3(d * std::cos(a), d * std::sin(a), 0.003 * (i % 11)),
+                              Vector3(-v * std::sin(a), v * std::cos(a), 0)));
+    }
+    return bodies;
+}
+
+/** @brief Splits bodies into the position and mass arrays a `ForceProvider` takes. */
+void pointMasses(const std::vector<Body>& bodies, std::vector<Vector3>& pos, std::vector<double>& mass) {
+    pos.clear();
+    mass.clear();
+    for (const auto& b : bodies) { pos.push_back(b.position); mass.push_back(b.mass); }
+}
+
 // =============================================================================
 // Original Tests
 // =============================================================================
@@ -455,6 +494,1611 @@ void test_moon_orbital_stability() {
     std::cout << "[PASS] Moon Orbital Stability" << std::endl << std::endl;
 }
 
+// =============================================================================
+// NEW: Force Provider Agreement
+// =============================================================================
+
+void test_force_providers() {
+    std::cout << "[TEST] Force Providers (Solver Agreement)..." << std::endl;
+    
+    auto bodies = EphemerisLoader::loadSolarSystemJ2000();
+    convertToBarycentric(bodies);
+    
+    std::vector<Vector3> positions;
+    std::vector<double> masses;
+    for (const auto& b : bodies) {
+        positions.push_back(b.position);
+        masses.push_back(b.mass);
+    }
+    
+    DirectForce direct;
+    std::vector<Vector3> reference;
+    direct.computeAccelerations(positions, masses, reference);
+    
+    auto maxRelativeError = [&](ForceProvider& provider) {
+        std::vector<Vector3> acc;
+        provider.computeAccelerations(positions, masses, acc);
+        assert(acc.size() == reference.size());
+        double worst = 0.0;
+        for (size_t i = 0; i < acc.size(); ++i) {
+            worst = std::max(worst, (acc[i] - reference[i]).length() / reference[i].length());
+        }
+        std::cout << "  " << provider.getName() << " max relative error: " << worst << std::endl;
+        return worst;
+    };
+    
+    ThreadPool workers(4);  // Fixed size so the threaded path runs on any machine
+    DirectSimdForce simd;
+    ThreadedDirectForce threaded(workers);
+    BarnesHutForce barnesHut(0.5);
+    TestParticleForce testParticles(0.0);  // Every body is a source: must match exactly
+    
+    assert(maxRelativeError(simd) < 1e-12);
+    assert(maxRelativeError(threaded) < 1e-12);
+    assert(maxRelativeError(testParticles) < 1e-12);
+    assert(maxRelativeError(barnesHut) < 1e-2);
+    
+    // Any integrator pairs with any solver: RK4 + Barnes-Hut
+    auto rk4Bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(rk4Bodies);
+    double initialEnergy = PhysicsEngine::calculateTotalEnergy(rk4Bodies);
+    for (int i = 0; i < 200; ++i) {
+        PhysicsEngine::stepRK4(rk4Bodies, 0.001, barnesHut);
+    }
+    double drift = std::abs((PhysicsEngine::calculateTotalEnergy(rk4Bodies) - initialEnergy) / initialEnergy);
+    std::cout << "  RK4 + Barnes-Hut Energy Drift (200 steps): " << (drift * 100) << "%" << std::endl;
+    assert(drift < 1e-2);
+    
+    std::cout << "[PASS] Force Providers" << std::endl << std::endl;
+}
+
+// =============================================================================
+// NEW: Multi-step advance() API
+// =============================================================================
+
+void test_advance_api() {
+    std::cout << "[TEST] advance<Integrator, ForceModel> (Sub-step Equivalence)..." << std::endl;
+    
+    auto stepped = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(stepped);
+    PhysicsEngine::calculateAccelerations(stepped);
+    auto advanced = stepped;
+    
+    // 0.01 years with a 0.001 cap must be exactly ten equal Verlet steps
+    for (int i = 0; i < 10; ++i) PhysicsEngine::stepVerlet(stepped, 0.001);
+    DirectForce direct;
+    int steps = advance<VerletIntegrator>(advanced, direct, 0.01, 0.001);
+    std::cout << "  Sub-steps taken: " << steps << std::endl;
+    assert(steps == 10);
+    
+    double maxDiff = 0.0;
+    for (size_t i = 0; i < stepped.size(); ++i) {
+        maxDiff = std::max(maxDiff, (stepped[i].position - advanced[i].position).length());
+    }
+    std::cout << "  Max position difference vs stepVerlet loop: " << maxDiff << " AU" << std::endl;
+    assert(maxDiff < 1e-12);
+    
+    // Non-multiple spans are split evenly rather than leaving a short remainder step
+    int rk4Steps = advance<RK4Integrator>(advanced, direct, 0.0025, 0.001);
+    assert(rk4Steps == 3);
+    int noSteps = advance<VerletIntegrator>(advanced, direct, 0.0, 0.001);
+    assert(noSteps == 0);
+    
+    std::cout << "[PASS] advance API" << std::endl << std::endl;
+}
+
+// =============================================================================
+// NEW: Fused Kick-Drift-Kick Verlet Pipeline
+// =============================================================================
+
+void test_fused_verlet_pipeline() {
+    std::cout << "[TEST] Fused Verlet Pipeline (Collisions & Batched Rotation)..." << std::endl;
+    
+    // Head-on pair: the merge must happen inside a multi-step advance() call
+    std::vector<Body> bodies;
+    bodies.push_back(Body("Body A", 0.5, 0.01, Vector3(-0.1, 0, 0), Vector3(0.5, 0, 0)));
+    bodies.push_back(Body("Body B", 0.5, 0.01, Vector3(0.1, 0, 0), Vector3(-0.5, 0, 0)));
+    bodies.push_back(Body("Spinner", 1e-9, 0.001, Vector3(5, 0, 0), Vector3(0, 2.8, 0)));
+    bodies[2].rotationSpeed = 500.0;
+    bodies[2].rotationAngle = 350.0;
+    PhysicsEngine::calculateAccelerations(bodies);
+    
+    Vector3 initialMomentum(0, 0, 0);
+    double initialMass = 0.0;
+    for (const auto& b : bodies) { initialMomentum += b.velocity * b.mass; initialMass += b.mass; }
+    
+    DirectSimdForce simd;
+    int steps = advance<VerletIntegrator>(bodies, simd, 0.5, 0.001);
+    std::cout << "  Sub-steps: " << steps << ", bodies remaining: " << bodies.size() << std::endl;
+    assert(bodies.size() == 2);
+    
+    double finalMass = 0.0;
+    Vector3 finalMomentum(0, 0, 0);
+    for (const auto& b : bodies) { finalMomentum += b.velocity * b.mass; finalMass += b.mass; }
+    assert(std::abs(finalMass - initialMass) < 1e-12);
+    std::cout << "  Momentum error: " << (finalMomentum - initialMomentum).length() << std::endl;
+    assert((finalMomentum - initialMomentum).length() < 1e-9);
+    
+    // Rotation is applied once for the whole span: 350 + 500 * 0.5 = 600 -> 240 degrees
+    std::cout << "  Spinner rotation: " << bodies[1].rotationAngle << " deg" << std::endl;
+    assert(std::abs(bodies[1].rotationAngle - 240.0) < 1e-9);
+    
+    std::cout << "[PASS] Fused Verlet Pipeline" << std::endl << std::endl;
+}
+
+// =============================================================================
+// NEW: Mixed-Precision Barnes-Hut Far Field
+// =============================================================================
+
+void test_barnes_hut_mixed_precision() {
+    std::cout << "[TEST] Barnes-Hut Mixed-Precision Far Field..." << std::endl;
+    
+    std::vector<Vector3> positions;
+    std::vector<double> masses;
+    pointMasses(makeBeltScene(400, false), positions, masses);
+    
+    // Both evaluate the same cached group lists; only the far-field arithmetic differs
+    DirectForce direct;
+    BarnesHutForce full(0.5), mixed(0.5);
+    for (BarnesHutForce* f : { &full, &mixed }) {
+        f->setTreeReuse(8);
+        f->setInteractionCaching(true);
+    }
+    mixed.setMixedPrecision(true);
+    
+    std::vector<Vector3> ref, accFull, accMixed;
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            // A small drift: the tree is refitted and the lists are reused, so the far field is repacked
+            for (size_t i = 0; i < positions.size(); ++i) positions[i] += Vector3(1e-6, -2e-6, 5e-7) * (double)(i % 5);
+        }
+        direct.computeAccelerations(positions, masses, ref);
+        full.computeAccelerations(positions, masses, accFull);
+        mixed.computeAccelerations(positions, masses, accMixed);
+        
+        double worstFull = 0.0, worstMixed = 0.0, worstRounding = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) {
+            worstFull = std::max(worstFull, (accFull[i] - ref[i]).length() / ref[i].length());
+            worstMixed = std::max(worstMixed, (accMixed[i] - ref[i]).length() / ref[i].length());
+            worstRounding = std::max(worstRounding, (accMixed[i] - accFull[i]).length() / accFull[i].length());
+        }
+        std::cout << "  Pass " << pass << ": max relative error double " << worstFull << ", mixed " << worstMixed
+                  << ", mixed vs double " << worstRounding << " (lists reused: " << mixed.getListReuses() << ")" << std::endl;
+        
+        // Float rounding must not noticeably widen the theta error
+        assert(worstMixed < 1e-2);
+        assert(worstMixed < worstFull * 1.5 + 1e-5);
+        assert(worstRounding < 1e-5);
+    }
+    assert(mixed.getListReuses() > 0);
+    
+    std::cout << "[PASS] Barnes-Hut Mixed Precision" << std::endl << std::endl;
+}
+
+void test_single_precision() {
+    std::cout << "[TEST] Templated Single-Precision Simulation..." << std::endl;
+    
+    // Float halves the compute arrays
+    assert(sizeof(Vector3f) == 16);
+    assert(sizeof(Vector3) == 32);
+    
+    // Sun plus a belt of test particles on circular orbits
+    std::vector<Body> belt;
+    belt.push_back(Body("Sun", 1.0, 0.00465, Vector3(0, 0, 0), Vector3(0, 0, 0)));
+    for (int i = 0; i < 300; ++i) {
+        double d = 2.2 + (i % 30) * 0.04;
+        double a = i * 0.211;
+        double v = 2.0 * M_PI / std::sqrt(d);
+        belt.push_back(Body("Asteroid", 1e-12, 1e-6, Vector3(d * std::cos(a), d * std::sin(a), 0),
+                            Vector3(-v * std::sin(a), v * std::cos(a), 0)));
+    }
+    
+    // Float and double kernels agree to float precision
+    auto fBodies = belt, dBodies = belt;
+    DirectSimdForceF simdF;
+    DirectSimdForce simdD;
+    PhysicsEngine::calculateAccelerations(fBodies, simdF);
+    PhysicsEngine::calculateAccelerations(dBodies, simdD);
+    double worst = 0.0;
+    for (size_t i = 0; i < belt.size(); ++i) {
+        if (i == 0) continue; // Net pull on the Sun is tiny, so relative error is meaningless
+        worst = std::max(worst, (fBodies[i].acceleration - dBodies[i].acceleration).length() / dBodies[i].acceleration.length());
+    }
+    std::cout << "  Max relative force difference (float vs double): " << worst << std::endl;
+    assert(worst < 1e-5);
+    
+    // A one-year float run stays on the double trajectory to well under belt spacing
+    advance<VerletIntegrator>(fBodies, simdF, 1.0, 0.002);
+    advance<VerletIntegrator>(dBodies, simdD, 1.0, 0.002);
+    double drift = 0.0;
+    for (size_t i = 0; i < belt.size(); ++i) {
+        drift = std::max(drift, (fBodies[i].position - dBodies[i].position).length());
+    }
+    std::cout << "  Max position divergence after 1 year: " << drift << " AU" << std::endl;
+    assert(drift < 1e-3);
+    
+    std::cout << "[PASS] Single Precision" << std::endl << std::endl;
+}
+
+void test_simd_vector3() {
+    std::cout << "[TEST] SIMD-Native Vector3..." << std::endl;
+    
+    // One full AVX2 register, aligned for aligned loads
+    assert(alignof(Vector3) == 32);
+    
+    // Results must match the scalar formulas bit for bit
+    int checked = 0;
+    for (int i = 0; i < 200; ++i) {
+        const double ax = std::sin(i * 1.3) * 5.2, ay = std::cos(i * 0.7) * 0.031, az = i * 1e-3 - 0.1;
+        const double bx = std::cos(i * 2.1) * 30.0, by = std::sin(i * 0.9), bz = 1.0 / (i + 1);
+        const double s = 0.37 + i * 0.01;
+        Vector3 a(ax, ay, az), b(bx, by, bz);
+        
+        Vector3 sum = a + b, diff = a - b, scaled = a * s, divided = a / s, c = a.cross(b);
+        assert(sum.x == ax + bx && sum.y == ay + by && sum.z == az + bz);
+        assert(diff.x == ax - bx && diff.y == ay - by && diff.z == az - bz);
+        assert(scaled.x == ax * s && scaled.y == ay * s && scaled.z == az * s);
+        assert(divided.x == ax / s && divided.y == ay / s && divided.z == az / s);
+        assert(c.x == ay * bz - az * by && c.y == az * bx - ax * bz && c.z == ax * by - ay * bx);
+        assert(a.dot(b) == ax * bx + ay * by + az * bz);
+        assert(a.lengthSquared() == ax * ax + ay * ay + az * az);
+        
+        Vector3 acc = a;
+        acc += b; acc -= a; acc *= s;
+        assert(acc.x == ((ax + bx) - ax) * s);
+        
+        // Padding lane stays zero
+        assert(sum.padding == 0.0 && diff.padding == 0.0 && scaled.padding == 0.0 && divided.padding == 0.0);
+        assert(c.padding == 0.0 && acc.padding == 0.0);
+        ++checked;
+    }
+    std::cout << "  " << checked << " operand sets match scalar results exactly" << std::endl;
+    
+    std::cout << "[PASS] SIMD Vector3" << std::endl << std::endl;
+}
+
+void test_morton_reorder() {
+    std::cout << "[TEST] Morton Reordering of the Body Store..." << std::endl;
+    
+    // Bodies created in an order unrelated to their location
+    std::vector<Body> bodies;
+    for (int i = 0; i < 2000; ++i) {
+        double d = 1.0 + ((i * 7919) % 2000) * 0.002;
+        double a = ((i * 104729) % 2000) * 0.00314;
+        bodies.push_back(Body("Asteroid", 1e-10, 1e-6, Vector3(d * std::cos(a), d * std::sin(a), 0.001 * (i % 13))));
+    }
+    bodies[123].name = "Marker";
+    bodies[123].updateTrail();
+    const uint32_t markerId = bodies[123].id;
+    
+    auto meanGap = [](const std::vector<Body>& b) {
+        double sum = 0.0;
+        for (size_t i = 1; i < b.size(); ++i) sum += (b[i].position - b[i - 1].position).length();
+        return sum / (b.size() - 1);
+    };
+    
+    // Reference forces keyed by id
+    auto before = bodies;
+    BarnesHutForce bh(0.5);
+    PhysicsEngine::calculateAccelerations(before, bh);
+    double gapBefore = meanGap(bodies);
+    
+    std::vector<int> oldToNew;
+    bool reordered = reorderBodiesMorton(bodies, oldToNew);
+    assert(reordered);
+    double gapAfter = meanGap(bodies);
+    std::cout << "  Mean neighbour gap: " << gapBefore << " -> " << gapAfter << " AU" << std::endl;
+    assert(gapAfter < gapBefore * 0.25);
+    
+    // The remap table and the stable id agree, and owned state moved with the body
+    int markerIdx = remapBodyIndex(123, oldToNew);
+    assert(markerIdx == findBodyById(bodies, markerId));
+    assert(bodies[markerIdx].name == "Marker" && bodies[markerIdx].trail.size() == 1);
+    for (size_t i = 0; i < before.size(); ++i) assert(bodies[oldToNew[i]].id == before[i].id);
+    
+    // Physics does not care about storage order
+    PhysicsEngine::calculateAccelerations(bodies, bh);
+    double worst = 0.0;
+    for (size_t i = 0; i < before.size(); ++i) {
+        const Vector3& a = bodies[oldToNew[i]].acceleration;
+        worst = std::max(worst, (a - before[i].acceleration).length() / before[i].acceleration.length());
+    }
+    std::cout << "  Max force change after reorder: " << worst << std::endl;
+    assert(worst < 1e-3);
+    
+    // A reused tree and its cached lists follow the reorder instead of rebuilding
+    BarnesHutForce reused(0.5);
+    reused.setTreeReuse(8);
+    reused.setInteractionCaching(true);
+    auto scattered = before;
+    PhysicsEngine::calculateAccelerations(scattered, reused);
+    const size_t builds = reused.getTreeStats().builds;
+    const auto unmoved = scattered;
+    reordered = reorderBodiesMorton(scattered, oldToNew);
+    assert(reordered);
+    reused.remapBodies(oldToNew);
+    PhysicsEngine::calculateAccelerations(scattered, reused);
+    std::cout << "  Reused tree across the reorder: " << reused.getTreeStats().builds - builds << " rebuilds, "
+              << reused.getListWalks() << " list walks" << std::endl;
+    assert(reused.getTreeStats().builds == builds && reused.getListWalks() == 0);
+    for (size_t i = 0; i < unmoved.size(); ++i) {
+        const Vector3& a = scattered[oldToNew[i]].acceleration;
+        assert((a - unmoved[i].acceleration).length() < 1e-12 * unmoved[i].acceleration.length());
+    }
+    
+    // Already ordered: nothing to do
+    reordered = reorderBodiesMorton(bodies, oldToNew);
+    assert(!reordered);
+    
+    std::cout << "[PASS] Morton Reorder" << std::endl << std::endl;
+}
+
+void test_compact_octree() {
+    std::cout << "[TEST] Compact Octree Node Layout..." << std::endl;
+    
+    assert(sizeof(OctreeNode) == 64);
+    assert(sizeof(PointMass) == 32);
+    
+    std::vector<Vector3> positions;
+    std::vector<double> masses;
+    for (int i = 0; i < 3000; ++i) {
+        double d = 0.5 + (i % 97) * 0.05;
+        double a = i * 0.731;
+        positions.push_back(Vector3(d * std::cos(a), d * std::sin(a), 0.02 * std::sin(i * 0.37)));
+        masses.push_back(1e-9 * (1 + i % 5));
+    }
+    // Coincident bodies exercise the depth guard
+    for (int i = 0; i < 20; ++i) { positions.push_back(Vector3(1, 1, 0)); masses.push_back(1e-9); }
+    
+    OctreePool tree;
+    int root = tree.build(positions, masses);
+    
+    // Walk the tree: children contiguous, body ranges partition the parent, mass and COM consistent
+    int leaves = 0, leafBodies = 0;
+    std::vector<int> stack = { root };
+    while (!stack.empty()) {
+        const OctreeNode& node = tree[stack.back()];
+        stack.pop_back();
+        assert(node.bodyCount > 0);
+        if (node.isLeaf()) {
+            ++leaves;
+            leafBodies += node.bodyCount;
+            continue;
+        }
+        int begin = node.bodyBegin;
+        double m = 0.0;
+        Vector3 weighted(0, 0, 0);
+        for (int c = node.firstChild; c < node.firstChild + node.childCount(); ++c) {
+            const OctreeNode& child = tree[c];
+            assert(child.bodyBegin == begin);
+            assert(std::abs(child.size - node.size * 0.5) < 1e-15);
+            begin += child.bodyCount;
+            m += child.com.mass;
+            weighted += child.com.position() * child.com.mass;
+            stack.push_back(c);
+        }
+        assert(begin == node.bodyBegin + node.bodyCount);
+        assert(std::abs(m - node.com.mass) < 1e-18);
+        assert((weighted / m - node.com.position()).length() < 1e-12);
+    }
+    assert(leafBodies == (int)positions.size());
+    std::cout << "  " << tree.getNodeCount() << " nodes (" << leaves << " leaves) for "
+              << positions.size() << " bodies" << std::endl;
+    
+    std::cout << "[PASS] Compact Octree" << std::endl << std::endl;
+}
+
+void test_octree_arena() {
+    std::cout << "[TEST] Octree Node Arena and Stats..." << std::endl;
+    
+    auto makeCloud = [](int n, std::vector<Vector3>& pos, std::vector<double>& mass) {
+        pos.clear(); mass.clear();
+        for (int i = 0; i < n; ++i) {
+            double d = 0.3 + (i % 211) * 0.02;
+            double a = i * 2.399963;
+            pos.push_back(Vector3(d * std::cos(a), d * std::sin(a), 0.01 * std::cos(i * 0.13)));
+            mass.push_back(1e-9);
+        }
+    };
+    
+    // Growing past the initial commit within one build must not move nodes
+    OctreePool tree(16);
+    std::vector<Vector3> pos;
+    std::vector<double> mass;
+    makeCloud(20000, pos, mass);
+    int root = tree.build(pos, mass);
+    const OctreeNode* rootPtr = &tree[root];
+    const OctreeStats& stats = tree.getStats();
+    assert(stats.nodeCount > 1000);
+    assert(stats.committedNodes >= stats.nodeCount);
+    assert(stats.reservedNodes >= OctreePool::maxNodesFor(pos.size()));
+    
+    // Rebuilding a denser tree within the reservation keeps the same arena
+    makeCloud(30000, pos, mass);
+    if (OctreePool::maxNodesFor(pos.size()) <= stats.reservedNodes) {
+        tree.build(pos, mass);
+        assert(&tree[root] == rootPtr);
+    } else {
+        tree.build(pos, mass);
+    }
+    size_t peak = stats.nodeCount;
+    
+    // A smaller tree lowers the node count but not the high-water mark
+    makeCloud(500, pos, mass);
+    tree.build(pos, mass);
+    assert(stats.nodeCount < peak);
+    assert(stats.highWaterMark == peak);
+    assert(stats.builds == 3);
+    std::cout << "  High-water mark: " << stats.highWaterMark << " nodes, reserved: " << stats.reservedNodes
+              << (stats.hugePages ? " (huge pages)" : "") << std::endl;
+    
+    std::cout << "[PASS] Octree Arena" << std::endl << std::endl;
+}
+
+void test_tree_reuse() {
+    std::cout << "[TEST] Barnes-Hut Tree Reuse (Refit)..." << std::endl;
+    
+    auto bodies = makeBeltScene(400, true);
+    
+    auto worstError = [](const std::vector<Body>& b, BarnesHutForce& bh) {
+        std::vector<Vector3> pos, ref, acc;
+        std::vector<double> mass;
+        pointMasses(b, pos, mass);
+        DirectForce direct;
+        direct.computeAccelerations(pos, mass, ref);
+        bh.computeAccelerations(pos, mass, acc);
+        double worst = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) worst = std::max(worst, (acc[i] - ref[i]).length() / ref[i].length());
+        return worst;
+    };
+    
+    // Build once, then evaluate 5 days later on the refitted structure
+    BarnesHutForce fresh(0.5), reused(0.5);
+    reused.setTreeReuse(16);
+    worstError(bodies, reused);
+    auto later = bodies;
+    advance<VerletIntegrator>(later, fresh, 5.0 / 365.25, 1.0 / 365.25);
+    double errFresh = worstError(later, fresh);
+    double errReused = worstError(later, reused);
+    std::cout << "  Max relative error, rebuilt: " << errFresh << "  refitted: " << errReused << std::endl;
+    assert(reused.getTreeStats().builds == 1 && reused.getTreeStats().refits == 1);
+    assert(errReused < 1e-3);
+    
+    // Integrating with reuse tracks the rebuild-every-step trajectory
+    auto a = bodies, b = bodies;
+    BarnesHutForce every(0.5), amortized(0.5);
+    amortized.setTreeReuse(8);
+    advance<VerletIntegrator>(a, every, 0.1, 0.001);
+    advance<VerletIntegrator>(b, amortized, 0.1, 0.001);
+    double drift = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) drift = std::max(drift, (a[i].position - b[i].position).length());
+    const OctreeStats& st = amortized.getTreeStats();
+    std::cout << "  Builds: " << st.builds << ", refits: " << st.refits
+              << ", max position difference: " << drift << " AU" << std::endl;
+    assert(st.builds < every.getTreeStats().builds / 4);
+    assert(drift < 1e-6);
+    
+    std::cout << "[PASS] Tree Reuse" << std::endl << std::endl;
+}
+
+void test_simd_mac() {
+    std::cout << "[TEST] Barnes-Hut SIMD Opening Test..." << std::endl;
+    
+    std::vector<Vector3> pos, scalarAcc, simdAcc;
+    std::vector<double> mass;
+    pointMasses(makeBeltScene(2000, false), pos, mass);
+    
+    // Same tree, same opening decisions: only the summation order differs
+    BarnesHutForce scalar(0.5), simd(0.5);
+    simd.setSimdTraversal(true);
+    scalar.computeAccelerations(pos, mass, scalarAcc);
+    simd.computeAccelerations(pos, mass, simdAcc);
+    double worst = 0.0;
+    for (size_t i = 0; i < pos.size(); ++i) {
+        worst = std::max(worst, (simdAcc[i] - scalarAcc[i]).length() / scalarAcc[i].length());
+    }
+    std::cout << "  Max relative difference vs scalar walk: " << worst << std::endl;
+    assert(worst < 1e-10);
+    
+    // Degenerate trees: a single body, and two coincident bodies
+    std::vector<Vector3> one = { Vector3(1, 0, 0) }, acc;
+    std::vector<double> m1 = { 1e-3 };
+    simd.computeAccelerations(one, m1, acc);
+    assert(acc[0].length() == 0.0);
+    std::vector<Vector3> two = { Vector3(1, 0, 0), Vector3(1, 0, 0) };
+    std::vector<double> m2 = { 1e-3, 1e-3 };
+    simd.computeAccelerations(two, m2, acc);
+    assert(std::isfinite(acc[0].x) && std::isfinite(acc[1].x));
+    
+    std::cout << "[PASS] SIMD Opening Test" << std::endl << std::endl;
+}
+
+void test_cost_zones() {
+    std::cout << "[TEST] Barnes-Hut Cost Zones..." << std::endl;
+    
+    // Dense belt plus a sparse outer cloud: uneven walk costs
+    auto bodies = makeBeltScene(2250, false);
+    for (int i = 0; i < 750; ++i) {
+        double d = 30.0 + (i % 97), a = i * 0.0917, z = (i % 13) * 3.0 - 18.0;
+        bodies.push_back(Body("Asteroid", 1e-10, 1e-6, Vector3(d * std::cos(a), d * std::sin(a), z)));
+    }
+    std::vector<Vector3> pos, serialAcc, zonedAcc;
+    std::vector<double> mass;
+    pointMasses(bodies, pos, mass);
+    
+    // Zoning only changes who walks which body, never the result
+    ThreadPool one(1), four(4);
+    BarnesHutForce serial(0.5, one), zoned(0.5, four);
+    serial.computeAccelerations(pos, mass, serialAcc);
+    zoned.computeAccelerations(pos, mass, zonedAcc);
+    zoned.computeAccelerations(pos, mass, zonedAcc); // Second pass zones by measured cost
+    for (size_t i = 0; i < pos.size(); ++i) assert((zonedAcc[i] - serialAcc[i]).lengthSquared() == 0.0);
+    
+    const std::vector<int>& cost = zoned.getBodyCosts();
+    const std::vector<int>& order = zoned.getTreeOrder();
+    const std::vector<size_t>& zones = zoned.getCostZones();
+    assert(zones.size() == 5 && zones.front() == 0 && zones.back() == pos.size());
+    
+    // Slowest zone relative to the mean, vs equal-count chunks of the same order
+    auto imbalance = [&](const std::vector<size_t>& b) {
+        double worst = 0.0, total = 0.0;
+        for (size_t z = 0; z + 1 < b.size(); ++z) {
+            double c = 0.0;
+            for (size_t k = b[z]; k < b[z + 1]; ++k) c += cost[order[k]];
+            worst = std::max(worst, c);
+            total += c;
+        }
+        return worst / (total / (b.size() - 1));
+    };
+    const size_t n = pos.size();
+    double equalCount = imbalance({ 0, n / 4, n / 2, 3 * n / 4, n });
+    double costZones = imbalance(zones);
+    std::cout << "  Slowest zone / mean: equal-count " << equalCount << ", cost zones " << costZones << std::endl;
+    assert(costZones < 1.05);
+    assert(costZones < equalCount && equalCount > 1.1);
+    
+    std::cout << "[PASS] Cost Zones" << std::endl << std::endl;
+}
+
+void test_interaction_list_cache() {
+    std::cout << "[TEST] Barnes-Hut Interaction List Caching..." << std::endl;
+    
+    auto bodies = makeBeltScene(2000, true);
+    
+    auto worstError = [](const std::vector<Body>& b, BarnesHutForce& bh) {
+        std::vector<Vector3> pos, ref, acc;
+        std::vector<double> mass;
+        pointMasses(b, pos, mass);
+        DirectForce direct;
+        direct.computeAccelerations(pos, mass, ref);
+        bh.computeAccelerations(pos, mass, acc);
+        double worst = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) worst = std::max(worst, (acc[i] - ref[i]).length() / ref[i].length());
+        return worst;
+    };
+    
+    // Group lists are at least as strict as per-body walks
+    BarnesHutForce walked(0.5), cached(0.5);
+    cached.setTreeReuse(16);
+    cached.setInteractionCaching(true);
+    double errWalked = worstError(bodies, walked);
+    double errCached = worstError(bodies, cached);
+    std::cout << "  Max relative error, per-body walks: " << errWalked << "  group lists: " << errCached << std::endl;
+    assert(cached.getListWalks() > 0 && cached.getListReuses() == 0);
+    assert(errCached <= errWalked * 1.01);
+    
+    // One day later most groups are still inside their validity spheres
+    std::vector<Body> later = bodies;
+    for (auto& b : later) b.position += b.velocity * (1.0 / 365.25);
+    double errLater = worstError(later, cached);
+    size_t walks = cached.getListWalks(), reuses = cached.getListReuses();
+    std::cout << "  After 1 day: " << reuses << " lists reused, " << walks << " re-walked, error " << errLater << std::endl;
+    assert(cached.getTreeStats().builds == 1);
+    assert(reuses > walks);
+    assert(errLater < 1e-3);
+    
+    // A rebuild invalidates every list
+    BarnesHutForce rebuilt(0.5);
+    rebuilt.setInteractionCaching(true);
+    worstError(bodies, rebuilt);
+    worstError(later, rebuilt);
+    assert(rebuilt.getListReuses() == 0);
+    
+    std::cout << "[PASS] Interaction List Caching" << std::endl << std::endl;
+}
+
+void test_relative_opening_criterion() {
+    std::cout << "[TEST] Barnes-Hut Relative Opening Criterion..." << std::endl;
+    
+    std::vector<Vector3> pos, ref, acc;
+    std::vector<double> mass;
+    pointMasses(makeBeltScene(2000, false), pos, mass);
+    DirectForce direct;
+    direct.computeAccelerations(pos, mass, ref);
+    
+    auto evaluate = [&](BarnesHutForce& bh, double& worst) {
+        bh.computeAccelerations(pos, mass, acc);
+        worst = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) worst = std::max(worst, (acc[i] - ref[i]).length() / ref[i].length());
+        double total = 0.0;
+        for (int c : bh.getBodyCosts()) total += c;
+        return total;
+    };
+    
+    BarnesHutForce geometric(0.5), relative(0.5);
+    relative.setOpeningCriterion(OpeningCriterion::Relative, 0.001);
+    double errGeometric, errSeed, errRelative;
+    double costGeometric = evaluate(geometric, errGeometric);
+    double costSeed = evaluate(relative, errSeed); // No |a| history yet: geometric pass
+    double costRelative = evaluate(relative, errRelative);
+    std::cout << "  Geometric: " << costGeometric << " interactions, error " << errGeometric << std::endl;
+    std::cout << "  Relative:  " << costRelative << " interactions, error " << errRelative << std::endl;
+    assert(costSeed == costGeometric);
+    assert(costRelative < 0.75 * costGeometric);
+    assert(errRelative <= errGeometric);
+    
+    // History follows the bodies through a reorder
+    std::vector<int> oldToNew(pos.size());
+    for (size_t i = 0; i < pos.size(); ++i) oldToNew[i] = (int)(pos.size() - 1 - i);
+    std::reverse(pos.begin(), pos.end());
+    std::reverse(mass.begin(), mass.end());
+    std::reverse(ref.begin(), ref.end());
+    relative.remapBodies(oldToNew);
+    double errRemapped;
+    evaluate(relative, errRemapped);
+    assert(std::abs(errRemapped - errRelative) < 1e-12);
+    
+    std::cout << "[PASS] Relative Opening Criterion" << std::endl << std::endl;
+}
+
+void test_particle_mesh() {
+    std::cout << "[TEST] Particle-Mesh Solver..." << std::endl;
+    
+    // In-tree FFT against a naive DFT, and the real round trip
+    const size_t n = 64;
+    std::vector<double> x(n);
+    for (size_t j = 0; j < n; ++j) x[j] = std::sin(0.37 * j) + 0.1 * (j % 5);
+    std::vector<FFT::Complex> X(n / 2 + 1);
+    FFT::realToComplex(x.data(), X.data(), n);
+    double dftErr = 0.0;
+    for (size_t k = 0; k <= n / 2; ++k) {
+        FFT::Complex sum(0.0, 0.0);
+        for (size_t j = 0; j < n; ++j) sum += x[j] * std::polar(1.0, -2.0 * M_PI * (double)(j * k) / n);
+        dftErr = std::max(dftErr, std::abs(sum - X[k]));
+    }
+    std::vector<double> back(n);
+    FFT::complexToReal(X.data(), back.data(), n);
+    double roundTrip = 0.0;
+    for (size_t j = 0; j < n; ++j) roundTrip = std::max(roundTrip, std::abs(back[j] / n - x[j]));
+    std::cout << "  FFT vs DFT: " << dftErr << ", round trip: " << roundTrip << std::endl;
+    assert(dftErr < 1e-10 && roundTrip < 1e-12);
+    
+    // Point mass: the mesh force converges to 1/r^2 beyond a few cells
+    std::vector<Vector3> pos = { Vector3(0.3, 0.1, 0.2) };
+    std::vector<double> mass = { 1.0 };
+    for (int k = 5; k <= 25; ++k) { pos.push_back(Vector3(k * 0.8, k * 0.6, 0.0)); mass.push_back(0.0); }
+    pos.push_back(Vector3(-28, -28, -28)); mass.push_back(0.0);
+    pos.push_back(Vector3(28, 28, 28)); mass.push_back(0.0);
+    std::vector<Vector3> acc, ref;
+    ParticleMeshForce pm(64);
+    DirectForce direct;
+    pm.computeAccelerations(pos, mass, acc);
+    direct.computeAccelerations(pos, mass, ref);
+    double worst = 0.0;
+    for (size_t i = 1; i + 2 < pos.size(); ++i) worst = std::max(worst, (acc[i] - ref[i]).length() / ref[i].length());
+    std::cout << "  Cell size " << pm.getCellSize() << " AU, worst error beyond 5 cells: " << worst << std::endl;
+    assert(std::abs(pm.getCellSize() - 1.0) < 1e-12);
+    assert(worst < 0.02);
+    assert(acc[0].length() < 1e-12); // No self-force
+    
+    // Thread-parallel deposit is a pure reduction: same result on any pool
+    std::vector<Vector3> cloud;
+    std::vector<double> cloudMass;
+    for (int i = 0; i < 20000; ++i) {
+        double r = 10.0 * ((i * 2654435761u) % 100003) / 100003.0;
+        double a = i * 0.0917;
+        cloud.push_back(Vector3(r * std::cos(a), r * std::sin(a), 0.1 * ((i % 17) - 8)));
+        cloudMass.push_back(1e-6);
+    }
+    ThreadPool one(1), four(4);
+    ParticleMeshForce serial(32, one), parallel(32, four);
+    std::vector<Vector3> a1, a4;
+    serial.computeAccelerations(cloud, cloudMass, a1);
+    parallel.computeAccelerations(cloud, cloudMass, a4);
+    Vector3 net(0, 0, 0);
+    double scale = 0.0, diff = 0.0;
+    for (size_t i = 0; i < cloud.size(); ++i) {
+        net += a4[i] * cloudMass[i];
+        scale += a4[i].length() * cloudMass[i];
+        diff = std::max(diff, (a4[i] - a1[i]).length() / a1[i].length());
+    }
+    std::cout << "  1 vs 4 threads: " << diff << ", net force / total: " << net.length() / scale << std::endl;
+    assert(diff < 1e-9);
+    assert(net.length() < 1e-3 * scale);
+    
+    std::cout << "[PASS] Particle-Mesh Solver" << std::endl << std::endl;
+}
+
+void test_simulation_thread() {
+    std::cout << "[TEST] Simulation Thread & Snapshots..." << std::endl;
+    
+    // Triple buffer: the reader sees only the newest published value
+    TripleBuffer<int> tb;
+    bool fresh = tb.fetch();
+    assert(!fresh);
+    tb.back() = 1; tb.publish();
+    tb.back() = 2; tb.publish();
+    fresh = tb.fetch();
+    assert(fresh && tb.front() == 2);
+    fresh = tb.fetch();
+    assert(!fresh && tb.front() == 2);
+    tb.back() = 3; tb.publish();
+    fresh = tb.fetch();
+    assert(fresh && tb.front() == 3);
+    
+    // Command queue: FIFO, bounded at Capacity - 1
+    SpscQueue<int, 4> q;
+    bool pushed[4];
+    for (int i = 0; i < 4; ++i) pushed[i] = q.push(i + 1);
+    assert(pushed[0] && pushed[1] && pushed[2] && !pushed[3]);
+    int v = 0;
+    bool popped = q.pop(v);
+    assert(popped && v == 1);
+    pushed[3] = q.push(4);
+    assert(pushed[3]);
+    for (int expected = 2; expected <= 4; ++expected) {
+        popped = q.pop(v);
+        assert(popped && v == expected);
+    }
+    popped = q.pop(v);
+    assert(!popped);
+    
+    // Synchronous ticks: commands apply before integration, snapshots follow
+    auto bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    const size_t n = bodies.size();
+    const double dt = 1.0 / 365.25;
+    SimulationThread sim(bodies, dt * 30.0); // One day per tick at 30 Hz
+    RenderMirror mirror;
+    fresh = sim.snapshots().fetch();
+    assert(fresh);
+    bool rebuilt = mirror.apply(sim.snapshots().front(), true);
+    assert(rebuilt);
+    assert(mirror.bodies.size() == n);
+    
+    SimulationCommand rate;
+    rate.type = SimulationCommand::Type::SetTimeRate;
+    rate.value = 2.0;
+    bool posted = sim.post(rate);
+    assert(posted);
+    sim.tick();
+    sim.tick();
+    fresh = sim.snapshots().fetch();
+    assert(fresh);
+    const RenderSnapshot& snap = sim.snapshots().front();
+    assert(snap.tick == 2 && std::abs(snap.elapsedYears - 4.0 * dt) < 1e-12);
+    rebuilt = mirror.apply(snap, true);
+    assert(!rebuilt); // Same catalog: no rebuild
+    assert((mirror.bodies[1].position - bodies[1].position).length() > 1e-6);
+    assert(mirror.bodies[1].trail.size() == 1);
+    
+    SimulationCommand pause, reset;
+    pause.type = SimulationCommand::Type::SetPaused;
+    pause.option = 1;
+    reset.type = SimulationCommand::Type::ResetTime;
+    posted = sim.post(pause) && sim.post(reset);
+    assert(posted);
+    sim.tick();
+    fresh = sim.snapshots().fetch();
+    assert(fresh);
+    assert(sim.snapshots().front().paused && sim.snapshots().front().tick == 2);
+    assert(sim.snapshots().front().elapsedYears == 0.0);
+    
+    // Preset load replaces the catalog; the mirror rebuilds and keeps trails by id
+    SimulationCommand preset;
+    preset.type = SimulationCommand::Type::LoadPreset;
+    preset.option = static_cast<int>(PresetType::BinaryStarTest);
+    posted = sim.post(preset);
+    assert(posted);
+    sim.tick();
+    fresh = sim.snapshots().fetch();
+    assert(fresh);
+    rebuilt = mirror.apply(sim.snapshots().front(), true);
+    assert(rebuilt);
+    assert(mirror.bodies.size() == sim.snapshots().front().states.size());
+    std::cout << "  Preset swap: " << n << " -> " << mirror.bodies.size() << " bodies" << std::endl;
+    
+    // Threaded: the worker keeps publishing without the reader waiting
+    SimulationThread live(bodies, dt, 500.0);
+    live.start();
+    uint64_t seen = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (seen < 5 && std::chrono::steady_clock::now() < deadline) {
+        if (live.snapshots().fetch()) {
+            const RenderSnapshot& s = live.snapshots().front();
+            assert(s.tick >= seen && s.states.size() == n);
+            seen = s.tick;
+        }
+        std::this_thread::yield();
+    }
+    live.stop();
+    std::cout << "  Worker ticks observed: " << seen << std::endl;
+    assert(seen >= 5);
+    
+    std::cout << "[PASS] Simulation Thread & Snapshots" << std::endl << std::endl;
+}
+
+void test_fixed_timestep_interpolation() {
+    std::cout << "[TEST] Fixed Timestep & Render Interpolation..." << std::endl;
+    
+    // Two ticks of a unit circular orbit (v = 2*pi AU/yr), a tenth of an orbit apart
+    const double w = 2.0 * M_PI, h = 0.1;
+    auto circular = [w](double t) {
+        return BodyState{ Vector3(std::cos(w * t), std::sin(w * t), 0), Vector3(-w * std::sin(w * t), w * std::cos(w * t), 0), 0.0, 7 };
+    };
+    Body probe("Probe", 1e-10, 0.0001, Vector3(1, 0, 0), Vector3(0, w, 0));
+    probe.id = 7;
+    probe.rotationSpeed = 100.0;
+    auto catalog = std::make_shared<const std::vector<Body>>(std::vector<Body>{ probe });
+    
+    auto t0 = std::chrono::steady_clock::now();
+    const auto period = std::chrono::milliseconds(100);
+    RenderSnapshot a, b;
+    a.catalog = b.catalog = catalog;
+    a.generation = b.generation = 1;
+    a.tickSeconds = b.tickSeconds = 0.1;
+    a.tick = 1; a.elapsedYears = 0.0; a.stateTime = t0; a.states = { circular(0.0) };
+    b.tick = 2; b.elapsedYears = h;   b.stateTime = t0 + period; b.states = { circular(h) };
+    
+    RenderMirror mirror;
+    mirror.apply(a, false);
+    bool rebuilt = mirror.apply(b, false);
+    assert(!rebuilt);
+    
+    // One tick of latency: render time t0 + 150 ms sits halfway between the ticks
+    mirror.interpolate(t0 + period + period / 2);
+    const Vector3 exact = circular(h / 2).position;
+    const Vector3 lerp = (a.states[0].position + b.states[0].position) * 0.5;
+    double hermiteErr = (mirror.bodies[0].position - exact).length();
+    double lerpErr = (lerp - exact).length();
+    std::cout << "  Midpoint error: Hermite " << hermiteErr << " AU, lerp " << lerpErr << " AU" << std::endl;
+    assert(hermiteErr < 0.01 * lerpErr);
+    assert(std::abs(mirror.bodies[0].rotationAngle - 5.0) < 1e-9);
+    
+    // Ends land exactly on the ticks; beyond the newest tick it holds still
+    mirror.interpolate(t0 + period);
+    assert((mirror.bodies[0].position - a.states[0].position).length() < 1e-12);
+    mirror.interpolate(t0 + period * 5);
+    assert((mirror.bodies[0].position - b.states[0].position).length() < 1e-12);
+    
+    // Fixed timestep: simulated time follows wall time, not how often anyone looks
+    auto bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    SimulationThread sim(bodies, 1.0, 50.0); // One year per second, 20 ms ticks
+    sim.start();
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    sim.stop();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool fresh = sim.snapshots().fetch();
+    assert(fresh);
+    const RenderSnapshot& last = sim.snapshots().front();
+    double ticked = last.tick * 0.02;
+    std::cout << "  " << last.tick << " ticks in " << wall << " s, simulated " << last.elapsedYears << " yr" << std::endl;
+    assert(std::abs(last.elapsedYears - ticked) < 1e-9); // Every tick is the same size
+    assert(ticked > 0.5 * wall && ticked <= wall + 0.02);
+    
+    std::cout << "[PASS] Fixed Timestep & Render Interpolation" << std::endl << std::endl;
+}
+
+void test_frame_governor() {
+    std::cout << "[TEST] Frame-Budget Governor..." << std::endl;
+    
+    auto sample = [](double frame, double render, double physics) {
+        FrameSample f;
+        f.frameMs = frame; f.renderMs = render; f.guiMs = 0.0;
+        f.physicsMs = physics; f.physicsBudgetMs = 33.3;
+        return f;
+    };
+    auto feed = [](FrameGovernor& g, const FrameSample& f, int frames) {
+        int changes = 0;
+        for (int i = 0; i < frames; ++i) changes += g.update(f);
+        return changes;
+    };
+    
+    // Render-bound: sphere detail goes first, then trail sampling, one step per cooldown
+    FrameGovernor g(30.0);
+    assert(g.getSphereSegments() == 32 && g.getTrailStride() == 1 && g.getMaxSubsteps() == 0);
+    int changes = feed(g, sample(50, 45, 2), FrameGovernor::DEGRADE_FRAMES - 1);
+    assert(changes == 0);
+    changes = feed(g, sample(50, 45, 2), 1);
+    assert(changes == 1 && g.getLevel(FrameGovernor::SphereDetail) == 1);
+    feed(g, sample(50, 45, 2), 1000);
+    std::cout << "  Render-bound: spheres " << g.getSphereSegments() << ", trail 1/" << g.getTrailStride()
+              << " (" << g.getLastDecision() << ")" << std::endl;
+    assert(g.getSphereSegments() == 8 && g.getTrailStride() == 8);
+    assert(g.getLevel(FrameGovernor::Theta) > 0); // Render exhausted, physics gave up the rest
+    
+    // Comfortable frames restore the most recent reduction first
+    int physicsSteps = g.getLevel(FrameGovernor::Theta) + g.getLevel(FrameGovernor::Substeps);
+    changes = feed(g, sample(10, 8, 1), FrameGovernor::RESTORE_FRAMES + 40); // + EMA settling
+    assert(changes == 1);
+    assert(g.getLevel(FrameGovernor::Theta) + g.getLevel(FrameGovernor::Substeps) == physicsSteps - 1);
+    assert(g.getSphereSegments() == 8);
+    feed(g, sample(10, 8, 1), 100000);
+    assert(g.getSphereSegments() == 32 && g.getTrailStride() == 1 && g.getTheta() == 0.5 && g.getMaxSubsteps() == 0);
+    
+    // Behind a 60 Hz limiter no frame is shorter than 16.7 ms, yet quality still comes back
+    FrameGovernor capped(30.0);
+    capped.setFrameLimit(60.0);
+    feed(capped, sample(50, 45, 2), FrameGovernor::DEGRADE_FRAMES);
+    assert(capped.getLevel(FrameGovernor::SphereDetail) == 1);
+    changes = feed(capped, sample(16.8, 6, 1), FrameGovernor::COOLDOWN_FRAMES + FrameGovernor::RESTORE_FRAMES + 40);
+    std::cout << "  Limiter-bound frames after a reduction: " << capped.getLastDecision() << std::endl;
+    assert(changes == 1 && capped.getSphereSegments() == 32);
+    changes = feed(capped, sample(16.8, 6, 1), 1000);
+    assert(changes == 0);
+    
+    // Hysteresis: a scene hovering around the target never moves a lever
+    FrameGovernor h(30.0);
+    int flips = 0;
+    for (int i = 0; i < 2000; ++i) flips += h.update(sample(i % 10 < 5 ? 22 : 32, 15, 2));
+    std::cout << "  Borderline scene, lever changes: " << flips << std::endl;
+    assert(flips == 0);
+    
+    // Physics overrunning its tick: theta first, then the sub-step budget when theta is unavailable
+    FrameGovernor p(30.0);
+    feed(p, sample(20, 15, 40), FrameGovernor::DEGRADE_FRAMES + 5);
+    assert(p.getTheta() > 0.5 && p.getSphereSegments() == 32);
+    FrameGovernor q(30.0);
+    q.setLeverAvailable(FrameGovernor::Theta, false);
+    feed(q, sample(20, 15, 40), FrameGovernor::DEGRADE_FRAMES + 5);
+    assert(q.getTheta() == 0.5 && q.getMaxSubsteps() > 0);
+    
+    // Disabled governor holds full quality
+    FrameGovernor off(30.0);
+    off.setEnabled(false);
+    changes = feed(off, sample(100, 90, 90), 500);
+    assert(changes == 0);
+    
+    // The physics thread honours the sub-step budget without changing the tick span
+    auto bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    SimulationThread sim(bodies, 100.0 * 30.0 / 365.25); // 100 days per tick
+    SimulationCommand budget;
+    budget.type = SimulationCommand::Type::SetSubstepBudget;
+    budget.option = 8;
+    bool posted = sim.post(budget);
+    assert(posted);
+    sim.tick();
+    bool fresh = sim.snapshots().fetch();
+    assert(fresh);
+    std::cout << "  Budgeted tick: " << sim.snapshots().front().tickMs << " ms" << std::endl;
+    assert(std::abs(sim.snapshots().front().elapsedYears - 100.0 / 365.25) < 1e-12);
+    
+    std::cout << "[PASS] Frame-Budget Governor" << std::endl << std::endl;
+}
+
+void test_binary_checkpoint() {
+    std::cout << "[TEST] Binary Checkpoint..." << std::endl;
+    
+    auto bodies = StateManager::loadPreset(PresetType::FullSolarSystem);
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (int i = 0; i < 300; ++i) {
+        double d = 2.2 + u(rng), a = u(rng) * 2.0 * M_PI, v = std::sqrt(39.478 / d);
+        bodies.emplace_back("Asteroid", 1e-10, 0.0001, Vector3(d * std::cos(a), d * std::sin(a), 0.0),
+                            Vector3(-v * std::sin(a), v * std::cos(a), 0.0));
+    }
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    DirectForce direct;
+    const double day = 1.0 / 365.25;
+    advance<VerletIntegrator>(bodies, direct, 30 * day, day);
+    
+    CheckpointMeta meta;
+    meta.elapsedYears = 30 * day;
+    meta.tick = 30;
+    meta.config.integrator = 0;
+    meta.config.theta = 0.7;
+    meta.captureRng(rng);
+    const std::string file = "test_checkpoint.ssck";
+    assert(Checkpoint::hasExtension(file));
+    bool saved = Checkpoint::save(bodies, meta, file);
+    assert(saved);
+    assert(Checkpoint::isCheckpoint(file));
+    
+    // Zero-copy view: aligned columns holding the exact bits
+    {
+        CheckpointView view;
+        bool opened = view.open(file);
+        assert(opened);
+        assert(view.size() == bodies.size());
+        assert(reinterpret_cast<uintptr_t>(view.positions()) % Checkpoint::ALIGNMENT == 0);
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            assert(std::memcmp(&view.positions()[i], &bodies[i].position, sizeof(Vector3)) == 0);
+            assert(std::memcmp(&view.accelerations()[i], &bodies[i].acceleration, sizeof(Vector3)) == 0);
+            assert(view.masses()[i] == bodies[i].mass && view.axialTilts()[i] == bodies[i].axialTilt);
+            assert(view.name(i) == bodies[i].name && view.parentName(i) == bodies[i].parentName);
+        }
+        CheckpointMeta back = view.meta();
+        assert(back.elapsedYears == meta.elapsedYears && back.tick == 30);
+        assert(back.config.integrator == 0 && back.config.theta == 0.7);
+        std::mt19937_64 restored;
+        bool rngRestored = back.restoreRng(restored);
+        assert(rngRestored);
+        const uint64_t nextRestored = restored(), nextOriginal = rng();
+        assert(nextRestored == nextOriginal);
+    }
+    
+    // Restart continues bit-for-bit
+    std::vector<Body> resumed;
+    CheckpointMeta resumedMeta;
+    bool loaded = loadCheckpoint(file, resumed, resumedMeta);
+    assert(loaded);
+    advance<VerletIntegrator>(bodies, direct, 60 * day, day);
+    advance<VerletIntegrator>(resumed, direct, 60 * day, day);
+    assert(resumed.size() == bodies.size());
+    size_t differing = 0;
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        differing += std::memcmp(&bodies[i].position, &resumed[i].position, sizeof(Vector3)) != 0;
+        differing += std::memcmp(&bodies[i].velocity, &resumed[i].velocity, sizeof(Vector3)) != 0;
+    }
+    std::cout << "  " << bodies.size() << " bodies, differing vectors after restart: " << differing << std::endl;
+    assert(differing == 0);
+    
+    // Damaged files are rejected, not mapped
+    {
+        std::ifstream in(file, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream(file, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)(bytes.size() / 2));
+        CheckpointView truncated;
+        bool opened = truncated.open(file);
+        assert(!opened);
+        bytes[0] = 'X';
+        std::ofstream(file, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+        CheckpointView foreign;
+        opened = foreign.open(file);
+        assert(!opened && !Checkpoint::isCheckpoint(file));
+    }
+    std::remove(file.c_str());
+    
+    std::cout << "[PASS] Binary Checkpoint" << std::endl << std::endl;
+}
+
+void test_trajectory_writer() {
+    std::cout << "[TEST] Trajectory Writer..." << std::endl;
+    using F = TrajectoryFormat;
+    
+    auto bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    for (int i = 0; i < 6; ++i) {
+        double d = 2.2 + 0.15 * i, v = std::sqrt(39.478 / d);
+        bodies.emplace_back("Asteroid", 1e-10, 0.0001, Vector3(d, 0.0, 0.0), Vector3(0.0, v, 0.0));
+    }
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    const std::vector<Body> catalog = bodies;
+    const auto strides = TrajectoryWriter::stridesByKind(catalog, 3);
+    
+    // Expected samples per frame, in catalog order; the store is reordered and merged along the way
+    const std::string file = "test_trajectory.sstraj";
+    TrajectoryWriter writer;
+    TrajectoryCodec::Settings raw;
+    raw.codec = F::Raw; // Byte-level layout checks below
+    writer.setCodec(raw);
+    bool ok = writer.open(file, catalog, strides, 4);
+    assert(ok);
+    DirectForce direct;
+    const double day = 1.0 / 365.25;
+    const int FRAMES = 10;
+    std::vector<double> times;
+    std::vector<std::vector<double>> expected(F::FIELD_COUNT - 1);
+    uint32_t mergedId = 0;
+    for (int f = 0; f < FRAMES; ++f) {
+        if (f == 5) std::reverse(bodies.begin(), bodies.end());
+        if (f == 7) {
+            mergedId = bodies.front().id; // An asteroid after the reversal
+            bodies.erase(bodies.begin());
+        }
+        ok = writer.record(bodies, f * day);
+        assert(ok);
+        times.push_back(f * day);
+        for (size_t s = 0; s < catalog.size(); ++s) {
+            if (!F::recorded(strides[s], f)) continue;
+            auto it = std::find_if(bodies.begin(), bodies.end(), [&](const Body& b) { return b.id == catalog[s].id; });
+            const double values[6] = {
+                it == bodies.end() ? F::MISSING : it->position.x, it == bodies.end() ? F::MISSING : it->position.y,
+                it == bodies.end() ? F::MISSING : it->position.z, it == bodies.end() ? F::MISSING : it->velocity.x,
+                it == bodies.end() ? F::MISSING : it->velocity.y, it == bodies.end() ? F::MISSING : it->velocity.z };
+            for (int c = 0; c < 6; ++c) expected[c].push_back(values[c]);
+        }
+        advance<VerletIntegrator>(bodies, direct, day, day);
+    }
+    assert(catalog.back().name == "Asteroid" && catalog.back().id == mergedId);
+    ok = writer.close();
+    assert(ok);
+    assert(writer.getFramesRecorded() == FRAMES && writer.getFramesDropped() == 0 && writer.getChunksWritten() == 3);
+    
+    MappedFile mapped;
+    ok = mapped.open(file);
+    assert(ok);
+    const unsigned char* base = mapped.data();
+    const auto* header = reinterpret_cast<const F::Header*>(base);
+    assert(std::memcmp(header->magic, F::MAGIC, 8) == 0 && header->version == F::VERSION);
+    assert(header->bodyCount == catalog.size() && header->framesPerChunk == 4);
+    const auto* storedStrides = reinterpret_cast<const uint32_t*>(base + header->catalog[F::Strides].offset);
+    assert(std::equal(strides.begin(), strides.end(), storedStrides));
+    
+    const auto* trailer = reinterpret_cast<const F::Trailer*>(base + mapped.size() - sizeof(F::Trailer));
+    assert(std::memcmp(trailer->magic, F::INDEX_MAGIC, 8) == 0);
+    assert(trailer->chunkCount == 3 && trailer->frameCount == FRAMES);
+    const auto* index = reinterpret_cast<const F::IndexEntry*>(base + trailer->indexOffset);
+    
+    // Chunks hold each field as one contiguous, aligned block, in the order recorded
+    size_t sample = 0, frame = 0, missing = 0;
+    for (uint64_t k = 0; k < trailer->chunkCount; ++k) {
+        assert(index[k].firstFrame == frame && index[k].frameCount == (k < 2 ? 4u : 2u));
+        assert(index[k].firstTime == times[frame] && index[k].lastTime == times[frame + index[k].frameCount - 1]);
+        const unsigned char* chunk = base + index[k].offset;
+        const auto* ch = reinterpret_cast<const F::ChunkHeader*>(chunk);
+        assert(std::memcmp(ch->magic, F::CHUNK_MAGIC, 8) == 0 && ch->frameCount == index[k].frameCount);
+        const auto* t = reinterpret_cast<const double*>(chunk + ch->blocks[F::Times].offset);
+        for (uint32_t i = 0; i < ch->frameCount; ++i) assert(t[i] == times[frame + i]);
+        for (uint32_t c = F::PositionX; c < F::FIELD_COUNT; ++c) {
+            assert(ch->blocks[c].codec == F::Raw && ch->blocks[c].values == ch->sampleCount);
+            assert(reinterpret_cast<uintptr_t>(chunk + ch->blocks[c].offset) % F::ALIGNMENT == 0);
+            const auto* v = reinterpret_cast<const double*>(chunk + ch->blocks[c].offset);
+            for (uint64_t i = 0; i < ch->sampleCount; ++i) {
+                const double want = expected[c - 1][sample + i];
+                if (F::isMissing(want)) {
+                    assert(F::isMissing(v[i]));
+                    missing += c == F::PositionX;
+                } else {
+                    assert(v[i] == want);
+                }
+            }
+        }
+        sample += ch->sampleCount;
+        frame += ch->frameCount;
+    }
+    assert(sample == expected[0].size() && missing > 0);
+    std::cout << "  " << FRAMES << " frames, " << sample << " samples (asteroids every 3rd), "
+              << missing << " after merge, " << mapped.size() << " bytes" << std::endl;
+    mapped.close();
+    
+    // The simulation thread records one frame per tick
+    {
+        SimulationThread sim(catalog, 60.0 / 365.25, 30.0);
+        SimulationCommand start;
+        start.type = SimulationCommand::Type::StartRecording;
+        start.filename = file;
+        start.option = 2;
+        ok = sim.post(start);
+        assert(ok);
+        for (int i = 0; i < 5; ++i) sim.tick();
+        SimulationCommand stop;
+        stop.type = SimulationCommand::Type::StopRecording;
+        ok = sim.post(stop);
+        assert(ok);
+        sim.tick();
+    }
+    ok = mapped.open(file);
+    assert(ok);
+    trailer = reinterpret_cast<const F::Trailer*>(mapped.data() + mapped.size() - sizeof(F::Trailer));
+    assert(trailer->frameCount == 5 && trailer->chunkCount == 1);
+    mapped.close();
+    std::remove(file.c_str());
+    
+    std::cout << "[PASS] Trajectory Writer" << std::endl << std::endl;
+}
+
+void test_trajectory_codec() {
+    std::cout << "[TEST] Trajectory Codec..." << std::endl;
+    using F = TrajectoryFormat;
+    
+    auto bodies = EphemerisLoader::loadSolarSystemJ2000();
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (int i = 0; i < 400; ++i) {
+        double d = 2.2 + u(rng), a = u(rng) * 2.0 * M_PI, v = std::sqrt(39.478 / d);
+        bodies.emplace_back("Asteroid", 1e-10, 0.0001, Vector3(d * std::cos(a), d * std::sin(a), (u(rng) - 0.5) * 0.2),
+                            Vector3(-v * std::sin(a), v * std::cos(a), 0.0));
+    }
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    const std::vector<Body> catalog = bodies;
+    const auto strides = TrajectoryWriter::stridesByKind(catalog, 2);
+    
+    // Daily frames, with a merge partway so missing samples are coded too
+    std::vector<std::vector<Body>> frames;
+    DirectForce direct;
+    const double day = 1.0 / 365.25;
+    for (int f = 0; f < 100; ++f) {
+        if (f == 50) bodies.pop_back();
+        frames.push_back(bodies);
+        advance<VerletIntegrator>(bodies, direct, day, day);
+    }
+    
+    struct Result { size_t bytes; double maxError; bool exact; };
+    auto roundTrip = [&](const TrajectoryCodec::Settings& settings) {
+        const std::string file = "test_codec.sstraj";
+        TrajectoryWriter writer;
+        writer.setCodec(settings);
+        bool ok = writer.open(file, catalog, strides, 32);
+        assert(ok);
+        for (size_t f = 0; f < frames.size(); ++f) {
+            ok = writer.record(frames[f], f * day);
+            assert(ok);
+        }
+        ok = writer.close();
+        assert(ok);
+        
+        MappedFile mapped;
+        ok = mapped.open(file);
+        assert(ok);
+        const auto* header = reinterpret_cast<const F::Header*>(mapped.data());
+        const auto* stored = reinterpret_cast<const uint32_t*>(mapped.data() + header->catalog[F::Strides].offset);
+        const auto* trailer = reinterpret_cast<const F::Trailer*>(mapped.data() + mapped.size() - sizeof(F::Trailer));
+        const auto* index = reinterpret_cast<const F::IndexEntry*>(mapped.data() + trailer->indexOffset);
+        Result r = { mapped.size(), 0.0, true };
+        TrajectoryCodec::ChunkData chunk;
+        TrajectoryCodec::Layout layout;
+        ThreadPool pool(3);
+        for (uint64_t k = 0; k < trailer->chunkCount; ++k) {
+            ok = TrajectoryCodec::decodeChunk(mapped.data() + index[k].offset, index[k].bytes, stored,
+                                              (size_t)header->bodyCount, chunk, layout, pool);
+            assert(ok);
+            for (uint32_t i = 0; i < index[k].frameCount; ++i) assert(chunk.times[i] == (chunk.firstFrame + i) * day);
+            for (size_t i = 0; i < layout.size(); ++i) {
+                const std::vector<Body>& frame = frames[chunk.firstFrame + layout.frame[i]];
+                const Body& want = catalog[layout.slot[i]];
+                auto it = std::find_if(frame.begin(), frame.end(), [&](const Body& b) { return b.id == want.id; });
+                for (int c = 0; c < 6; ++c) {
+                    const double got = chunk.columns[c][i];
+                    if (it == frame.end()) {
+                        assert(F::isMissing(got));
+                        continue;
+                    }
+                    const double value = c < 3 ? (&it->position.x)[c] : (&it->velocity.x)[c - 3];
+                    r.exact = r.exact && std::memcmp(&got, &value, sizeof(double)) == 0;
+                    r.maxError = std::max(r.maxError, std::abs(got - value));
+                }
+            }
+        }
+        
+        // Corruption is reported, not decoded into garbage
+        std::vector<unsigned char> damaged(mapped.data() + index[0].offset, mapped.data() + index[0].offset + index[0].bytes);
+        auto* ch = reinterpret_cast<F::ChunkHeader*>(damaged.data());
+        ch->blocks[F::PositionX].bytes = 8;
+        ok = TrajectoryCodec::decodeChunk(damaged.data(), damaged.size(), stored, (size_t)header->bodyCount, chunk, layout, pool);
+        assert(!ok);
+        mapped.close();
+        std::remove(file.c_str());
+        return r;
+    };
+    
+    TrajectoryCodec::Settings raw, lossless, lossy;
+    raw.codec = F::Raw;
+    lossless.codec = F::Predictive;
+    lossy.codec = F::Quantized;
+    lossy.positionTolerance = 1e-6;  // ~150 km
+    lossy.velocityTolerance = 1e-6;
+    const Result r0 = roundTrip(raw), r1 = roundTrip(lossless), r2 = roundTrip(lossy);
+    std::cout << "  Raw: " << r0.bytes << " B, lossless: " << r1.bytes << " B (" << (double)r0.bytes / r1.bytes
+              << ":1), quantized 1e-6: " << r2.bytes << " B (" << (double)r0.bytes / r2.bytes << ":1, max error "
+              << r2.maxError << ")" << std::endl;
+    assert(r0.exact && r1.exact);
+    assert(r1.bytes < r0.bytes / 2);
+    assert(!r2.exact && r2.maxError <= 1e-6 * (1.0 + 1e-6) && r2.bytes < r1.bytes / 3);
+    
+    std::cout << "[PASS] Trajectory Codec" << std::endl << std::endl;
+}
+
+void test_trajectory_reader() {
+    std::cout << "[TEST] Trajectory Reader..." << std::endl;
+    using F = TrajectoryFormat;
+    
+    auto bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    for (int i = 0; i < 6; ++i) {
+        double d = 2.2 + 0.15 * i, v = std::sqrt(39.478 / d);
+        bodies.emplace_back("Asteroid", 1e-10, 0.0001, Vector3(d, 0.0, 0.0), Vector3(0.0, v * (1.0 + 0.02 * i), 0.0));
+    }
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    const std::vector<Body> catalog = bodies;
+    const auto strides = TrajectoryWriter::stridesByKind(catalog, 4);
+    const size_t n = catalog.size();
+    
+    // Every body is kept at every frame for reference, asteroids are stored every 4th
+    const std::string file = "test_trajectory_reader.sstraj";
+    TrajectoryWriter writer;
+    bool ok = writer.open(file, catalog, strides, 8);
+    assert(ok);
+    DirectForce direct;
+    const double day = 1.0 / 365.25;
+    const int FRAMES = 43;
+    std::vector<std::vector<Body>> reference;
+    for (int f = 0; f < FRAMES; ++f) {
+        ok = writer.record(bodies, f * day);
+        assert(ok);
+        reference.push_back(bodies);
+        advance<VerletIntegrator>(bodies, direct, day, day);
+    }
+    ok = writer.close();
+    assert(ok);
+    
+    TrajectoryReader reader;
+    ok = reader.open(file);
+    assert(ok);
+    assert(reader.getBodyCount() == n && reader.getFrameCount() == FRAMES && reader.getChunkCount() == 6);
+    assert(reader.getStartTime() == 0.0 && reader.getEndTime() == (FRAMES - 1) * day);
+    for (size_t s = 0; s < n; ++s) {
+        assert(reader.name(s) == catalog[s].name && reader.masses()[s] == catalog[s].mass && reader.strides()[s] == strides[s]);
+    }
+    assert(reader.catalogBodies().size() == n && reader.catalogBodies()[n - 1].name == "Asteroid");
+    
+    // Index search: a frame's own time and any time up to the next frame find that frame
+    for (int f = 0; f < FRAMES; ++f) {
+        uint64_t found = 0;
+        assert(reader.findChunk(f * day) == (size_t)f / 8);
+        ok = reader.findFrame(f * day, found);
+        assert(ok && found == (uint64_t)f);
+        ok = reader.findFrame((f + 0.5) * day, found);
+        assert(ok && found == (uint64_t)f);
+    }
+    uint64_t found = 99;
+    ok = reader.findFrame(-1.0, found);
+    assert(ok && found == 0);
+    ok = reader.findFrame(1.0, found);
+    assert(ok && found == FRAMES - 1);
+    
+    // Frame views: lossless, in catalog order, asteroids only on their stride
+    auto checkFrame = [&](int f, const std::vector<uint32_t>& slots) {
+        TrajectoryReader::FrameView view;
+        const bool viewed = reader.frame(f, view);
+        assert(viewed && view.frame == (uint64_t)f && view.time == f * day);
+        size_t k = 0;
+        for (uint32_t s : slots) {
+            if (!F::recorded(strides[s], f)) continue;
+            assert(k < view.count && view.slots[k] == s);
+            const Body& b = reference[f][s];
+            assert(view.position[0][k] == b.position.x && view.position[1][k] == b.position.y &&
+                   view.position[2][k] == b.position.z);
+            assert(view.velocity[0][k] == b.velocity.x && view.velocity[1][k] == b.velocity.y &&
+                   view.velocity[2][k] == b.velocity.z);
+            ++k;
+        }
+        assert(k == view.count);
+    };
+    std::vector<uint32_t> all(n);
+    for (size_t s = 0; s < n; ++s) all[s] = (uint32_t)s;
+    for (int f = 0; f < FRAMES; ++f) checkFrame(f, all);
+    TrajectoryReader::FrameView outside;
+    ok = reader.frame(FRAMES, outside);
+    assert(!ok);
+    
+    // A body subset decodes and views only those bodies
+    const std::vector<uint32_t> subset = { (uint32_t)n - 2, 1 };
+    reader.select(subset);
+    for (int f : { 0, 3, 8, 20, 42 }) checkFrame(f, { 1, (uint32_t)n - 2 });
+    
+    // Hermite interpolation: exact on stored samples, and between an asteroid's samples
+    // (4 days apart) far closer to the true orbit than straight lines
+    TrajectoryReader::Sample sample;
+    ok = reader.sample(8 * day, sample);
+    assert(ok && sample.slots == std::vector<uint32_t>({ 1, (uint32_t)n - 2 }));
+    assert(sample.positions[1].x == reference[8][n - 2].position.x && sample.velocities[0].y == reference[8][1].velocity.y);
+    double hermiteError = 0.0, linearError = 0.0, velocityError = 0.0;
+    for (int f = 1; f < 40; ++f) {
+        if (f % 4 == 0) continue;
+        ok = reader.sample(f * day, sample);
+        assert(ok);
+        const Body& truth = reference[f][n - 2];
+        const int a = f - f % 4, b = a + 4;
+        const double u = (f - a) / 4.0;
+        const Vector3 linear = reference[a][n - 2].position * (1.0 - u) + reference[b][n - 2].position * u;
+        hermiteError = std::max(hermiteError, (sample.positions[1] - truth.position).length());
+        linearError = std::max(linearError, (linear - truth.position).length());
+        velocityError = std::max(velocityError, (sample.velocities[1] - truth.velocity).length() / truth.velocity.length());
+    }
+    std::cout << "  Asteroid every 4 days: Hermite error " << hermiteError << " AU, linear " << linearError
+              << " AU, velocity " << velocityError << " relative" << std::endl;
+    assert(hermiteError < 1e-7 && hermiteError < linearError * 1e-3 && velocityError < 1e-5);
+    
+    // Past its last sample a body is carried along its velocity; times are clamped to the recording
+    ok = reader.sample(42 * day, sample);
+    assert(ok);
+    const Vector3 carried = reference[40][n - 2].position + reference[40][n - 2].velocity * (2 * day);
+    assert((sample.positions[1] - carried).length() < 1e-12);
+    ok = reader.sample(10.0, sample);
+    assert(ok && sample.time == reader.getEndTime());
+    reader.close();
+    
+    // An unfinished recording (no index yet) is rejected
+    {
+        std::ifstream in(file, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), (std::streamsize)(bytes.size() - sizeof(F::Trailer)));
+    }
+    ok = reader.open(file);
+    assert(!ok && !reader.isOpen());
+    std::remove(file.c_str());
+    
+    std::cout << "[PASS] Trajectory Reader" << std::endl << std::endl;
+}
+
+void test_history_rewind() {
+    std::cout << "[TEST] History Keyframes & Rewind..." << std::endl;
+    
+    auto bodies = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(bodies);
+    PhysicsEngine::calculateAccelerations(bodies);
+    const double day = 1.0 / 365.25;
+    
+    // Keyframes every day under a budget of about 24: recent ones dense, old ones sparse
+    HistoryManager probe;
+    probe.capture(bodies, 0.0, 0, day);
+    const size_t firstBytes = probe.getMemoryBytes(); // Includes the shared catalog
+    probe.capture(bodies, day, 1, day);
+    const size_t keyframeBytes = probe.getMemoryBytes() - firstBytes;
+    HistoryManager history(0.999 * day, firstBytes + 23 * keyframeBytes);
+    DirectForce direct;
+    std::vector<Body> saved;
+    for (int d = 0; d < 400; ++d) {
+        assert(history.isDue(d * day));
+        history.capture(bodies, d * day, d, day);
+        assert(!history.isDue((d + 0.5) * day));
+        if (d == 397) saved = bodies;
+        advance<VerletIntegrator>(bodies, direct, day, day);
+    }
+    assert(history.getMemoryBytes() <= history.getBudget() && history.size() >= 10 && history.size() <= 24);
+    assert(history.getOldestTime() == 0.0 && history.getNewestTime() == 399 * day);
+    assert(history[0].catalog == history[history.size() - 1].catalog); // Same bodies: one shared catalog
+    const size_t last = history.size() - 1;
+    const double newestGap = history[last].elapsedYears - history[last - 1].elapsedYears;
+    const double oldestGap = history[1].elapsedYears - history[0].elapsedYears;
+    std::cout << "  " << history.size() << " keyframes over 400 days, gaps " << newestGap / day << " .. "
+              << oldestGap / day << " days" << std::endl;
+    assert(newestGap <= 2 * day && oldestGap >= 16 * newestGap);
+    for (size_t i = 2; i <= last; ++i) {
+        assert(history[i].elapsedYears - history[i - 1].elapsedYears <= 2.5 * (history[i - 1].elapsedYears - history[i - 2].elapsedYears));
+    }
+    
+    // Restoring gives back the captured bodies exactly
+    const Keyframe* k = history.findBefore(397.5 * day);
+    assert(k && k->elapsedYears == 397 * day && k->tick == 397 && !history.findBefore(-day));
+    std::vector<Body> restored;
+    HistoryManager::restore(*k, restored);
+    assert(restored.size() == saved.size());
+    for (size_t i = 0; i < saved.size(); ++i) {
+        assert(restored[i].id == saved[i].id && restored[i].name == saved[i].name && restored[i].mass == saved[i].mass);
+        assert(restored[i].position.x == saved[i].position.x && restored[i].velocity.z == saved[i].velocity.z &&
+               restored[i].acceleration.y == saved[i].acceleration.y && restored[i].rotationAngle == saved[i].rotationAngle);
+    }
+    history.discardAfter(300 * day);
+    assert(history.getNewestTime() <= 300 * day);
+    
+    // A changed body set gets its own catalog
+    bodies.pop_back();
+    history.capture(bodies, 401 * day, 401, day);
+    assert(history[history.size() - 1].catalog != history[0].catalog && history[history.size() - 1].bodyCount() == bodies.size());
+    
+    // Rewinding the simulation: restore a keyframe, re-integrate to the target, bit for bit (direct-sum Verlet)
+    auto system = StateManager::loadPreset(PresetType::InnerPlanets);
+    convertToBarycentric(system);
+    PhysicsEngine::calculateAccelerations(system);
+    SimulationThread sim(system, day * 30.0); // One day per tick
+    auto post = [&sim](SimulationCommand::Type type, int option, double value) {
+        SimulationCommand c;
+        c.type = type; c.option = option; c.value = value;
+        const bool posted = sim.post(c);
+        assert(posted);
+    };
+    post(SimulationCommand::Type::SetIntegrator, 0, 0.0);
+    post(SimulationCommand::Type::ConfigureHistory, 16, 7 * day);
+    std::vector<BodyState> at25;
+    double years25 = 0.0, years40 = 0.0;
+    for (int t = 1; t <= 40; ++t) {
+        sim.tick();
+        bool fresh = sim.snapshots().fetch();
+        assert(fresh);
+        if (t == 25) { at25 = sim.snapshots().front().states; years25 = sim.snapshots().front().elapsedYears; }
+        if (t == 40) years40 = sim.snapshots().front().elapsedYears;
+    }
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        post(SimulationCommand::Type::Rewind, 0, years40 - years25);
+        sim.tick(); // Restores day 21 and re-integrates one tick
+        bool fresh = sim.snapshots().fetch();
+        assert(fresh && sim.snapshots().front().rewinding);
+        int steps = 1;
+        while (sim.snapshots().front().rewinding) {
+            sim.tick();
+            fresh = sim.snapshots().fetch();
+            assert(fresh);
+            ++steps;
+        }
+        const RenderSnapshot& snap = sim.snapshots().front();
+        assert(steps >= 1 && steps <= 7 && snap.tick == 25 && snap.elapsedYears == years25 && snap.states.size() == at25.size());
+        for (size_t i = 0; i < at25.size(); ++i) {
+            assert(snap.states[i].id == at25[i].id && snap.states[i].position.x == at25[i].position.x &&
+                   snap.states[i].position.y == at25[i].position.y && snap.states[i].velocity.z == at25[i].velocity.z);
+        }
+        for (int t = 0; t < 15; ++t) sim.tick(); // Back to day 40 for the second attempt
+        fresh = sim.snapshots().fetch();
+        assert(fresh && sim.snapshots().front().elapsedYears == years40);
+    }
+    
+    // Past the start of history: back to the oldest keyframe, nothing to re-integrate
+    post(SimulationCommand::Type::Rewind, 0, 100.0);
+    sim.tick();
+    const bool fresh = sim.snapshots().fetch();
+    assert(fresh && !sim.snapshots().front().rewinding && sim.snapshots().front().tick == 1);
+    
+    std::cout << "[PASS] History Keyframes & Rewind" << std::endl << std::endl;
+}
+
+// =============================================================================
+// NEW: Parallel CSV Parser & Writer
+// =============================================================================
+
+void test_csv_fast_path() {
+    std::cout << "[TEST] Parallel CSV Parser & Writer..." << std::endl;
+    
+    // Round trip is bit-exact, across several parse chunks (> 1 MiB)
+    std::vector<Body> bodies;
+    std::mt19937_64 rng(50);
+    std::uniform_real_distribution<double> u(-50.0, 50.0);
+    const size_t N = 20000;
+    for (size_t i = 0; i < N; ++i) {
+        Body b("Body" + std::to_string(i), 1e-12 * std::abs(u(rng)), 1e-7 * std::abs(u(rng)),
+               Vector3(u(rng), u(rng), u(rng)), Vector3(u(rng), u(rng), 1.0 / 3.0));
+        b.rotationAngle = u(rng);
+        b.rotationSpeed = u(rng);
+        b.axialTilt = 0.1 * i;
+        bodies.push_back(std::move(b));
+    }
+    const std::string testFile = "test_fast.csv";
+    bool saved = StateManager::saveState(bodies, testFile);
+    assert(saved);
+    auto loaded = StateManager::loadState(testFile);
+    assert(loaded.size() == N);
+    for (size_t i = 0; i < N; ++i) {
+        const Body& a = bodies[i];
+        const Body& b = loaded[i];
+        assert(a.name == b.name && a.mass == b.mass && a.radius == b.radius);
+        assert(a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z);
+        assert(a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y && a.velocity.z == b.velocity.z);
+        assert(a.rotationAngle == b.rotationAngle && a.rotationSpeed == b.rotationSpeed && a.axialTilt == b.axialTilt);
+    }
+    std::cout << "  " << N << " bodies round-trip bit-exact" << std::endl;
+    
+    // CRLF, blanks, '+', extra columns, blank lines; short rows and trailing garbage are skipped
+    {
+        std::ofstream file(testFile, std::ios::binary);
+        file << "name,mass,radius,px,py,pz,vx,vy,vz,rotAngle,rotSpeed,axialTilt\r\n";
+        file << "Crlf,1.5,0.01, 2 ,+3,-4e-3,0,0,0,0,0,0.25\r\n";
+        file << "\r\n";
+        file << "Short,1,0.01,0,0,0\r\n";
+        file << "Garbage,1x,0.01,0,0,0,0,0,0,0,0,0\n";
+        file << "Extra,2,0.02,1,1,1,1,1,1,1,1,1,ignored,columns\n";
+        file << "NoNewline,3,0.03,0,0,0,0,0,0,0,0,7";
+    }
+    loaded = StateManager::loadState(testFile);
+    assert(loaded.size() == 3);
+    assert(loaded[0].name == "Crlf" && loaded[0].mass == 1.5 && loaded[0].position.x == 2.0);
+    assert(loaded[0].position.y == 3.0 && loaded[0].position.z == -4e-3 && loaded[0].axialTilt == 0.25);
+    assert(loaded[1].name == "Extra" && loaded[1].axialTilt == 1.0);
+    assert(loaded[2].name == "NoNewline" && loaded[2].axialTilt == 7.0);
+    
+    std::remove(testFile.c_str());
+    
+    std::cout << "[PASS] Parallel CSV Parser & Writer" << std::endl << std::endl;
+}
+
 // =============================================================================
 // Main Entry Point
 // =============================================================================
@@ -483,6 +2127,32 @@ int main() {
         // Moon orbital stability test
         test_moon_orbital_stability();
         
+        // Force provider / integrator decoupling
+        test_force_providers();
+        test_advance_api();
+        test_fused_verlet_pipeline();
+        test_barnes_hut_mixed_precision();
+        test_single_precision();
+        test_simd_vector3();
+        test_morton_reorder();
+        test_compact_octree();
+        test_octree_arena();
+        test_tree_reuse();
+        test_simd_mac();
+        test_cost_zones();
+        test_interaction_list_cache();
+        test_relative_opening_criterion();
+        test_particle_mesh();
+        test_simulation_thread();
+        test_fixed_timestep_interpolation();
+        test_frame_governor();
+        test_binary_checkpoint();
+        test_trajectory_writer();
+        test_trajectory_codec();
+        test_trajectory_reader();
+        test_history_rewind();
+        test_csv_fast_path();
+        
         std::cout << "=====================================" << std::endl;
         std::cout << "✅ ALL TESTS PASSED SUCCESSFULLY" << std::endl;
         std::cout << "=====================================" << std::endl;